@@ -0,0 +1,196 @@
+#define _DEFAULT_SOURCE
+#include "arena.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/* Buffers this big come from mmap, so freeing them returns the memory at once. */
+#define ARENA_MAP_MIN ((size_t)1 << 20)
+#define ARENA_HUGE ((size_t)2 << 20)
+#define ARENA_GIANT ((size_t)1 << 30)
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+typedef struct Block {
+    struct Block *next;
+    void *p;
+    size_t size;    /* usable bytes */
+    int map;        /* mmap'd (else aligned_alloc) */
+    int used;
+} Block;
+
+static pthread_mutex_t mu = PTHREAD_MUTEX_INITIALIZER;
+static Block *blocks;
+static size_t keep = ARENA_KEEP_DEFAULT;
+static HugeMode huge;
+static ArenaStats st;
+static size_t mapped;
+
+void arena_config(size_t k, HugeMode h) {
+    pthread_mutex_lock(&mu);
+    keep = k;
+    huge = h;
+    pthread_mutex_unlock(&mu);
+}
+
+static size_t round_up(size_t x, size_t m) { return (x + m - 1) / m * m; }
+
+/* 2 MiB-aligned mapping of sz bytes (a multiple of 2 MiB): over-map, then trim both ends. */
+static void *map_thp(size_t sz) {
+    char *p = (char*)mmap(NULL, sz + ARENA_HUGE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    size_t head = (ARENA_HUGE - (size_t)((uintptr_t)p % ARENA_HUGE)) % ARENA_HUGE;
+    if (head) munmap(p, head);
+    munmap(p + head + sz, ARENA_HUGE - head);
+    madvise(p + head, sz, MADV_HUGEPAGE);
+    return p + head;
+}
+
+void *arena_map(size_t bytes, size_t *len) {
+    pthread_mutex_lock(&mu);
+    HugeMode h = huge;
+    pthread_mutex_unlock(&mu);
+
+    void *p = NULL;
+    int fell = 0;
+    if (h != HUGE_OFF && bytes >= ARENA_HUGE) {
+        if (h == HUGE_2M || h == HUGE_1G) {
+            size_t page = h == HUGE_1G ? ARENA_GIANT : ARENA_HUGE;
+            int shift = h == HUGE_1G ? 30 : 21;
+            *len = round_up(bytes, page);
+            p = mmap(NULL, *len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+            if (p == MAP_FAILED) { p = NULL; fell = 1; }
+        }
+        if (!p) {
+            *len = round_up(bytes, ARENA_HUGE);
+            p = map_thp(*len);
+        }
+        if (p) {
+            pthread_mutex_lock(&mu);
+            st.huge_maps++;
+            st.huge_fallbacks += (size_t)fell;
+            pthread_mutex_unlock(&mu);
+        }
+        return p;
+    }
+    *len = round_up(bytes ? bytes : 1, 4096);
+    p = mmap(NULL, *len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+/* New block; mu not held. Fresh mappings are already zero. */
+static Block *fresh(size_t bytes, int *zeroed) {
+    Block *b = (Block*)calloc(1, sizeof(Block));
+    if (!b) return NULL;
+    if (bytes >= ARENA_MAP_MIN) {
+        b->p = arena_map(bytes, &b->size);
+        b->map = 1;
+        *zeroed = 1;
+    } else {
+        b->size = (bytes + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+        b->p = aligned_alloc(ARENA_ALIGN, b->size ? b->size : ARENA_ALIGN);
+        *zeroed = 0;
+    }
+    if (!b->p) { free(b); return NULL; }
+    return b;
+}
+
+static void destroy(Block *b) {
+    if (b->map) munmap(b->p, b->size);
+    else free(b->p);
+    free(b);
+}
+
+void *arena_get(size_t bytes, int zero) {
+    pthread_mutex_lock(&mu);
+    st.gets++;
+    /* Best fit among idle blocks no more than 1/4 larger than asked. */
+    Block *best = NULL;
+    for (Block *b = blocks; b; b = b->next) {
+        if (b->used || b->size < bytes || b->size - bytes > bytes / 4 + ARENA_ALIGN) continue;
+        if (!best || b->size < best->size) best = b;
+    }
+    if (best) {
+        best->used = 1;
+        st.reuses++;
+        st.idle_bytes -= best->size;
+        pthread_mutex_unlock(&mu);
+        if (zero) memset(best->p, 0, bytes);
+        return best->p;
+    }
+    pthread_mutex_unlock(&mu);
+
+    int zeroed;
+    Block *b = fresh(bytes, &zeroed);
+    if (!b) return NULL;
+    if (zero && !zeroed) memset(b->p, 0, bytes);
+    b->used = 1;
+
+    pthread_mutex_lock(&mu);
+    b->next = blocks;
+    blocks = b;
+    mapped += b->size;
+    if (mapped > st.peak_bytes) st.peak_bytes = mapped;
+    pthread_mutex_unlock(&mu);
+    return b->p;
+}
+
+void arena_put(void *p) {
+    if (!p) return;
+    pthread_mutex_lock(&mu);
+    for (Block **pb = &blocks; *pb; pb = &(*pb)->next) {
+        Block *b = *pb;
+        if (b->p != p) continue;
+        if (st.idle_bytes + b->size <= keep) {
+            b->used = 0;
+            st.idle_bytes += b->size;
+        } else {
+            *pb = b->next;
+            mapped -= b->size;
+            destroy(b);
+        }
+        break;
+    }
+    pthread_mutex_unlock(&mu);
+}
+
+void arena_trim(void) {
+    pthread_mutex_lock(&mu);
+    for (Block **pb = &blocks; *pb; ) {
+        Block *b = *pb;
+        if (b->used) { pb = &b->next; continue; }
+        *pb = b->next;
+        mapped -= b->size;
+        destroy(b);
+    }
+    st.idle_bytes = 0;
+    pthread_mutex_unlock(&mu);
+}
+
+void arena_stats(ArenaStats *out) {
+    pthread_mutex_lock(&mu);
+    *out = st;
+    pthread_mutex_unlock(&mu);
+}
+
+int arena_huge_resident(size_t *thp, size_t *hugetlb) {
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f) return -1;
+    char line[256];
+    size_t kb;
+    *thp = *hugetlb = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "AnonHugePages: %zu kB", &kb) == 1) *thp += kb << 10;
+        else if (sscanf(line, "Private_Hugetlb: %zu kB", &kb) == 1) *hugetlb += kb << 10;
+        else if (sscanf(line, "Shared_Hugetlb: %zu kB", &kb) == 1) *hugetlb += kb << 10;
+    }
+    fclose(f);
+    return 0;
+}
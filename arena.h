@@ -0,0 +1,56 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* Alignment of every arena buffer, in bytes (a cache line, like MAT_ALIGN). */
+#define ARENA_ALIGN 64
+
+/* Idle bytes kept for reuse unless arena_config says otherwise. */
+#define ARENA_KEEP_DEFAULT ((size_t)1 << 30)
+
+/*
+ * Process-wide cache of aligned buffers for results and kernel scratch.
+ * arena_put keeps a buffer mapped, and a later arena_get of a similar
+ * size (up to 1/4 smaller) reuses it. Repeated kernel calls and ops then
+ * skip malloc/mmap and the fresh page faults behind them. Thread-safe.
+ */
+
+/*
+ * Page backing of large mappings (arena_map). HUGE_THP maps on 2 MiB
+ * boundaries and madvises for transparent huge pages; HUGE_2M/HUGE_1G
+ * take reserved hugetlbfs pages and fall back to THP when there are none.
+ */
+typedef enum { HUGE_OFF, HUGE_THP, HUGE_2M, HUGE_1G } HugeMode;
+
+/* keep: idle bytes held for reuse; a buffer put back past it is freed (0: every put frees). */
+void arena_config(size_t keep, HugeMode huge);
+
+/*
+ * Zero-filled anonymous read-write mapping of at least bytes, backed as
+ * arena_config chose for anything of 2 MiB and up. *len is the length
+ * to munmap. Used for arena buffers and for large Mat/Vec storage.
+ */
+void *arena_map(size_t bytes, size_t *len);
+
+/* At least bytes, aligned to ARENA_ALIGN and zero-filled if zero; NULL on failure. */
+void *arena_get(size_t bytes, int zero);
+/* Returns a buffer from arena_get; NULL is ignored. */
+void arena_put(void *p);
+/* Frees every idle buffer. */
+void arena_trim(void);
+
+typedef struct {
+    size_t gets, reuses;      /* arena_get calls, and those served by an idle buffer */
+    size_t idle_bytes;        /* held for reuse now */
+    size_t peak_bytes;        /* most bytes mapped at once, in use or idle */
+    size_t huge_maps;         /* arena_map calls backed by huge pages (or advised for THP) */
+    size_t huge_fallbacks;    /* ... of which asked for hugetlbfs but got THP */
+} ArenaStats;
+
+void arena_stats(ArenaStats *st);
+
+/* Resident huge-page bytes of the process, from /proc/self/smaps_rollup; -1 if unreadable. */
+int arena_huge_resident(size_t *thp, size_t *hugetlb);
+
+#endif
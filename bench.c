@@ -1,10 +1,209 @@
 #include "bench.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <signal.h>
 #include <time.h>
 #include <sys/stat.h>
 
+extern volatile sig_atomic_t g_stop;
+
 double now_s(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
     return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
 }
+
+/* A sample shorter than this is dominated by timer overhead and jitter. */
+#define BENCH_MIN_SAMPLE 50e-6
+
+static int cmp_dbl(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void summarize(double *t, int n, BenchStats *st) {
+    qsort(t, (size_t)n, sizeof(double), cmp_dbl);
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) sum += t[i];
+    double mean = sum / n, var = 0.0;
+    for (int i = 0; i < n; i++) var += (t[i] - mean) * (t[i] - mean);
+    st->samples = n;
+    st->min = t[0];
+    st->median = n % 2 ? t[n / 2] : 0.5 * (t[n / 2 - 1] + t[n / 2]);
+    st->p95 = t[(int)ceil(0.95 * n) - 1];   /* nearest rank */
+    st->mean = mean;
+    st->stddev = n > 1 ? sqrt(var / (n - 1)) : 0.0;
+}
+
+/* Seconds taken by inner back-to-back calls, or a negative value on failure. */
+static double timed(BenchFn fn, BenchPrep prep, void *arg, int inner, Perf *perf) {
+    if (prep) prep(arg);
+    perf_start(perf);
+    double t0 = now_s();
+    int rc = 0;
+    for (int i = 0; i < inner && rc == 0; i++) rc = fn(arg);
+    double t = now_s() - t0;
+    perf_stop(perf);
+    return rc != 0 ? -1.0 : t;
+}
+
+int bench_run(BenchFn fn, BenchPrep prep, void *arg, const BenchOpts *o, BenchStats *st) {
+    memset(st, 0, sizeof(*st));
+    for (int w = 0; w < o->warmup; w++) {
+        if (g_stop) return 2;
+        if (timed(fn, prep, arg, 1, NULL) < 0) return -1;
+    }
+
+    int inner = 1, samples = o->reps;
+    if (samples <= 0) {
+        if (g_stop) return 2;
+        double t1 = timed(fn, prep, arg, 1, NULL);
+        if (t1 < 0) return -1;
+        if (!prep && t1 < BENCH_MIN_SAMPLE)
+            inner = t1 > 0 ? (int)ceil(BENCH_MIN_SAMPLE / t1) : 1000;
+        double per = t1 * inner;
+        samples = per > 0 ? (int)ceil(o->min_time / per) : BENCH_MAX_SAMPLES;
+        if (samples < 1) samples = 1;
+    }
+    if (samples > BENCH_MAX_SAMPLES && o->reps <= 0) samples = BENCH_MAX_SAMPLES;
+
+    double *t = (double*)malloc((size_t)samples * sizeof(double));
+    if (!t) return -1;
+    perf_reset(o->perf);
+    int n = 0;
+    for (; n < samples && !g_stop; n++) {
+        double s = timed(fn, prep, arg, inner, o->perf);
+        if (s < 0) { free(t); return -1; }
+        t[n] = s / inner;
+    }
+    if (n > 0) summarize(t, n, st);
+    st->inner = inner;
+    st->calls = (long)n * inner;
+    free(t);
+    return g_stop ? 2 : 0;
+}
+
+/* ---- reporting --------------------------------------------------------- */
+
+static const char *CSV_HEADER =
+    "op,m,n,k,threads,seconds,gflops,speedup,efficiency,format,"
+    "min_s,p95_s,stddev_s,samples,isa,dtype,gbs,roof_gflops,roof_pct,bound,"
+    "cycles,instructions,ipc,l1d_miss,llc_miss,dram_bytes,dtlb_miss,ranks\n";
+
+static double roof_pct(const BenchRow *r) {
+    return r->roof > 0 ? 100.0 * r->gflops / r->roof : 0.0;
+}
+
+/* One counter value, or an empty field (CSV) / null (JSON) if it was not counted. */
+static void put_ev(FILE *f, const PerfCount *c, PerfEvent e, int json) {
+    if (c->ok & (1u << e)) fprintf(f, "%.0f", c->v[e]);
+    else if (json) fputs("null", f);
+}
+
+static void put_perf_csv(FILE *f, const PerfCount *c) {
+    const unsigned ci = (1u << PE_CYCLES) | (1u << PE_INSTR);
+    fputc(',', f); put_ev(f, c, PE_CYCLES, 0);
+    fputc(',', f); put_ev(f, c, PE_INSTR, 0);
+    fputc(',', f);
+    if ((c->ok & ci) == ci && c->v[PE_CYCLES] > 0) fprintf(f, "%.3f", c->v[PE_INSTR] / c->v[PE_CYCLES]);
+    fputc(',', f); put_ev(f, c, PE_L1D_MISS, 0);
+    fputc(',', f); put_ev(f, c, PE_LLC_MISS, 0);
+    fputc(',', f);
+    if (c->ok & (1u << PE_LLC_MISS)) fprintf(f, "%.0f", c->v[PE_LLC_MISS] * PERF_LINE);
+    fputc(',', f); put_ev(f, c, PE_DTLB_MISS, 0);
+}
+
+static void put_perf_json(FILE *f, const PerfCount *c) {
+    if (!c->ok) { fputs("null", f); return; }
+    fputc('{', f);
+    for (int e = 0; e < PE_NEV; e++) {
+        fprintf(f, "%s\"%s\":", e ? "," : "", perf_event_name((PerfEvent)e));
+        put_ev(f, c, (PerfEvent)e, 1);
+    }
+    fputs(",\"dram_bytes\":", f);
+    if (c->ok & (1u << PE_LLC_MISS)) fprintf(f, "%.0f", c->v[PE_LLC_MISS] * PERF_LINE);
+    else fputs("null", f);
+    fputc('}', f);
+}
+
+static void csv_row(FILE *f, const BenchRow *r) {
+    fprintf(f, "%s,%zu,%zu,%zu,%d,%.9f,%.6f,%.4f,%.2f,%s,%.9f,%.9f,%.9f,%d,%s,%s,%.3f,%.3f,%.1f,%s",
+            r->op, r->m, r->n, r->k, r->threads, r->st.median, r->gflops,
+            r->speedup, r->efficiency, r->fmt ? r->fmt : "",
+            r->st.min, r->st.p95, r->st.stddev, r->st.samples,
+            r->isa ? r->isa : "", r->dtype ? r->dtype : "",
+            r->gbs, r->roof, roof_pct(r), r->bound ? r->bound : "");
+    put_perf_csv(f, &r->perf);
+    fprintf(f, ",%d\n", r->ranks > 0 ? r->ranks : 1);
+}
+
+static FILE *open_out(const char *out_base, const char *op, const char *ext) {
+    size_t n = strlen(out_base) + strlen(op) + strlen(ext) + 3;
+    char *path = (char*)malloc(n);
+    if (!path) return NULL;
+    snprintf(path, n, "%s_%s.%s", out_base, op, ext);
+    FILE *f = fopen(path, "w");
+    if (!f) perror(path);
+    free(path);
+    return f;
+}
+
+int report_open(Report *r, const char *out_base, const char *op) {
+    memset(r, 0, sizeof(*r));
+    printf("\n[%s] Results:\n", op);
+    printf("%s", CSV_HEADER);
+    if (!out_base || strcmp(out_base, "/dev/null") == 0) return 0;
+
+    r->csv = open_out(out_base, op, "csv");
+    r->json = open_out(out_base, op, "json");
+    if (!r->csv || !r->json) { report_close(r); return -1; }
+    fputs(CSV_HEADER, r->csv);
+    fprintf(r->json, "{\"op\":\"%s\",\"results\":[", op);
+    return 0;
+}
+
+void report_row(Report *r, const BenchRow *row) {
+    csv_row(stdout, row);
+    if (r->csv) csv_row(r->csv, row);
+    if (r->json) {
+        fprintf(r->json,
+                "%s\n  {\"m\":%zu,\"n\":%zu,\"k\":%zu,\"len\":%zu,\"threads\":%d,\"ranks\":%d,"
+                "\"format\":\"%s\",\"isa\":\"%s\",\"dtype\":\"%s\","
+                "\"samples\":%d,\"calls_per_sample\":%d,"
+                "\"min_s\":%.9e,\"median_s\":%.9e,\"p95_s\":%.9e,\"mean_s\":%.9e,\"stddev_s\":%.9e,"
+                "\"gflops\":%.6f,\"speedup\":%.4f,\"efficiency\":%.2f,"
+                "\"gbs\":%.3f,\"roof_gflops\":%.3f,\"roof_pct\":%.1f,\"bound\":\"%s\",\"perf\":",
+                r->rows ? "," : "", row->m, row->n, row->k, row->len, row->threads,
+                row->ranks > 0 ? row->ranks : 1,
+                row->fmt ? row->fmt : "", row->isa ? row->isa : "", row->dtype ? row->dtype : "",
+                row->st.samples, row->st.inner,
+                row->st.min, row->st.median, row->st.p95, row->st.mean, row->st.stddev,
+                row->gflops, row->speedup, row->efficiency,
+                row->gbs, row->roof, roof_pct(row), row->bound ? row->bound : "");
+        put_perf_json(r->json, &row->perf);
+        fputs(",\"perf_threads\":", r->json);
+        if (row->perf.ok && row->perf_per) {
+            fputc('[', r->json);
+            for (int t = 0; t < row->threads; t++) {
+                if (t) fputc(',', r->json);
+                put_perf_json(r->json, &row->perf_per[t]);
+            }
+            fputc(']', r->json);
+        } else {
+            fputs("null", r->json);
+        }
+        fputc('}', r->json);
+    }
+    r->rows++;
+}
+
+void report_close(Report *r) {
+    if (r->json) {
+        fputs("\n]}\n", r->json);
+        fclose(r->json);
+    }
+    if (r->csv) fclose(r->csv);
+    r->csv = r->json = NULL;
+}
@@ -2,7 +2,70 @@
 #define BENCH_H
 
 #include "matrix.h"
+#include "perf.h"
+#include <stdio.h>
 
 double now_s(void);
 
+/* One timed call of the benchmarked op; nonzero aborts the run. */
+typedef int  (*BenchFn)(void *arg);
+/* Untimed setup before every call (e.g. restoring an in-place output); may be NULL. */
+typedef void (*BenchPrep)(void *arg);
+
+typedef struct {
+    int warmup;        /* untimed calls before sampling */
+    int reps;          /* timed samples; 0 = calibrate to min_time */
+    double min_time;   /* calibration target for the total timed work, in seconds */
+    Perf *perf;        /* if set, counts the timed samples only (reset per run) */
+} BenchOpts;
+
+#define BENCH_WARMUP   1
+#define BENCH_MIN_TIME 0.25
+#define BENCH_MAX_SAMPLES 1000
+
+/* Seconds per call over all samples. */
+typedef struct {
+    int samples;
+    int inner;         /* calls per sample: > 1 when one call is too short to time */
+    long calls;        /* timed calls in total: samples * inner */
+    double min, median, p95, mean, stddev;
+} BenchStats;
+
+/*
+ * Runs o->warmup untimed calls, then the timed samples. When calibrating,
+ * calls shorter than a few tens of microseconds are batched per sample
+ * (prep == NULL only) and the sample count is chosen so the timed work
+ * reaches o->min_time. o->perf, if set, is reset and then counts only
+ * the timed windows. Returns 0, -1 if fn failed, or 2 if interrupted.
+ */
+int bench_run(BenchFn fn, BenchPrep prep, void *arg, const BenchOpts *o, BenchStats *st);
+
+/* One result line: an op at one thread count. */
+typedef struct {
+    const char *op, *fmt, *isa, *dtype;
+    size_t m, n, k, len;
+    int threads;
+    int ranks;           /* MPI ranks of a distributed row; 0 = 1 */
+    BenchStats st;
+    double gflops, speedup, efficiency;
+    double gbs;          /* minimum memory traffic of one call over the median */
+    double roof;         /* roofline bound in GFLOPS, 0 if not measured */
+    const char *bound;   /* "mem" or "compute": the ceiling that sets roof */
+    PerfCount perf;              /* per call, summed over threads; perf.ok == 0 if not counted */
+    const PerfCount *perf_per;   /* per call, for each of the row's threads; may be NULL */
+} BenchRow;
+
+/*
+ * Results of one op: echoed as CSV to stdout and, unless out_base is
+ * /dev/null, written to <out_base>_<op>.csv and <out_base>_<op>.json.
+ */
+typedef struct {
+    FILE *csv, *json;
+    int rows;
+} Report;
+
+int  report_open(Report *r, const char *out_base, const char *op);
+void report_row(Report *r, const BenchRow *row);
+void report_close(Report *r);
+
 #endif
@@ -0,0 +1,492 @@
+#define _POSIX_C_SOURCE 200809L
+#include "chunk.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <nmmintrin.h>
+
+#define CK_VERSION 1
+#define CK_ENTRY   24
+
+const char *ck_codec_name(Codec c) {
+    switch (c) {
+        case CODEC_NONE: return "none";
+        case CODEC_LZ:   return "lz";
+        case CODEC_SHUF: return "shuffle";
+        default:         return "unknown";
+    }
+}
+
+/* ---- CRC32C ------------------------------------------------------------ */
+
+static uint32_t crc_tab[256];
+static uint32_t (*crc_fn)(uint32_t, const uint8_t*, size_t);
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static uint32_t crc32c_sw(uint32_t c, const uint8_t *p, size_t n) {
+    while (n--) c = crc_tab[(c ^ *p++) & 0xff] ^ (c >> 8);
+    return c;
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t c, const uint8_t *p, size_t n) {
+    uint64_t c64 = c;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        c64 = _mm_crc32_u64(c64, w);
+    }
+    c = (uint32_t)c64;
+    while (n--) c = _mm_crc32_u8(c, *p++);
+    return c;
+}
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = c & 1 ? (c >> 1) ^ 0x82f63b78u : c >> 1;
+        crc_tab[i] = c;
+    }
+    __builtin_cpu_init();
+    crc_fn = __builtin_cpu_supports("sse4.2") ? crc32c_hw : crc32c_sw;
+}
+
+static uint32_t crc32c(const void *p, size_t n) {
+    pthread_once(&crc_once, crc_init);
+    return ~crc_fn(~0u, (const uint8_t*)p, n);
+}
+
+/* ---- codecs ------------------------------------------------------------ */
+
+#define LZ_HASH_BITS 14
+#define LZ_MIN 4
+
+static inline uint32_t rd32(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+/* A run length past 15 continues in bytes of 255 and a final remainder. */
+static uint8_t *put_len(uint8_t *op, size_t n) {
+    for (; n >= 255; n -= 255) *op++ = 255;
+    *op++ = (uint8_t)n;
+    return op;
+}
+
+/*
+ * Sequences of token (literal count << 4 | match length - 4), literals,
+ * u16 offset back; the last sequence is literals only. Returns the
+ * encoded size, or 0 if it would not fit in cap bytes.
+ */
+static size_t lz_encode(const uint8_t *src, size_t n, uint8_t *dst, size_t cap) {
+    uint32_t ht[1u << LZ_HASH_BITS];
+    memset(ht, 0, sizeof(ht));
+    const uint8_t *ip = src, *anchor = src, *end = src + n;
+    const uint8_t *mlimit = n > 12 ? end - 12 : src, *xlimit = n > 5 ? end - 5 : src;
+    uint8_t *op = dst, *oend = dst + cap;
+
+    while (ip < mlimit) {
+        const uint32_t seq = rd32(ip), h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+        const uint8_t *ref = src + ht[h];
+        ht[h] = (uint32_t)(ip - src);
+        if (ref >= ip || ip - ref > 65535 || rd32(ref) != seq) {
+            ip += 1 + ((size_t)(ip - anchor) >> 6);   /* skip faster through data that does not match */
+            continue;
+        }
+        const uint8_t *mp = ip + LZ_MIN, *rp = ref + LZ_MIN;
+        while (mp < xlimit && *mp == *rp) mp++, rp++;
+        const size_t lit = (size_t)(ip - anchor), ml = (size_t)(mp - ip) - LZ_MIN;
+        if ((size_t)(oend - op) < 1 + lit + lit / 255 + 1 + 2 + ml / 255 + 1) return 0;
+        uint8_t *tok = op++;
+        *tok = (uint8_t)((lit < 15 ? lit : 15) << 4 | (ml < 15 ? ml : 15));
+        if (lit >= 15) op = put_len(op, lit - 15);
+        memcpy(op, anchor, lit); op += lit;
+        const size_t off = (size_t)(ip - ref);
+        *op++ = (uint8_t)off; *op++ = (uint8_t)(off >> 8);
+        if (ml >= 15) op = put_len(op, ml - 15);
+        ip = anchor = mp;
+    }
+    const size_t lit = (size_t)(end - anchor);
+    if ((size_t)(oend - op) < 1 + lit + lit / 255 + 1) return 0;
+    *op++ = (uint8_t)((lit < 15 ? lit : 15) << 4);
+    if (lit >= 15) op = put_len(op, lit - 15);
+    memcpy(op, anchor, lit); op += lit;
+    return (size_t)(op - dst);
+}
+
+/* Decodes exactly n bytes into dst; -1 on any malformed or out-of-range sequence. */
+static int lz_decode(const uint8_t *src, size_t len, uint8_t *dst, size_t n) {
+    const uint8_t *ip = src, *iend = src + len;
+    uint8_t *op = dst, *oend = dst + n;
+    while (ip < iend) {
+        const unsigned tok = *ip++;
+        size_t lit = tok >> 4;
+        if (lit == 15) {
+            unsigned b;
+            do { if (ip >= iend) return -1; b = *ip++; lit += b; } while (b == 255);
+        }
+        if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op)) return -1;
+        memcpy(op, ip, lit); op += lit; ip += lit;
+        if (ip == iend) break;
+        if (iend - ip < 2) return -1;
+        const size_t off = (size_t)ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        size_t ml = tok & 15;
+        if (ml == 15) {
+            unsigned b;
+            do { if (ip >= iend) return -1; b = *ip++; ml += b; } while (b == 255);
+        }
+        ml += LZ_MIN;
+        if (off == 0 || off > (size_t)(op - dst) || ml > (size_t)(oend - op)) return -1;
+        /* An overlapping match repeats [m, op): copy it in doubling, non-overlapping steps. */
+        const uint8_t *m = op - off;
+        for (size_t have = off; ml > 0; ) {
+            const size_t c = have < ml ? have : ml;
+            memcpy(op, m, c);
+            op += c; ml -= c; have += c;
+        }
+    }
+    return op == oend ? 0 : -1;
+}
+
+/*
+ * n elements of esz bytes: byte b of element i goes to dst[b * n + i].
+ * Element-major loops with a constant esz, so each element is one
+ * sequential read (or write) and esz streams on the other side.
+ */
+static inline void shuffle_k(const uint8_t *src, uint8_t *dst, size_t n, size_t esz) {
+    for (size_t i = 0; i < n; i++)
+        for (size_t b = 0; b < esz; b++) dst[b * n + i] = src[i * esz + b];
+}
+
+static inline void unshuffle_k(const uint8_t *src, uint8_t *dst, size_t n, size_t esz) {
+    for (size_t i = 0; i < n; i++)
+        for (size_t b = 0; b < esz; b++) dst[i * esz + b] = src[b * n + i];
+}
+
+static void shuffle(const uint8_t *src, uint8_t *dst, size_t n, size_t esz) {
+    if (esz == 8) shuffle_k(src, dst, n, 8);
+    else shuffle_k(src, dst, n, 4);
+}
+
+static void unshuffle(const uint8_t *src, uint8_t *dst, size_t n, size_t esz) {
+    if (esz == 8) unshuffle_k(src, dst, n, 8);
+    else unshuffle_k(src, dst, n, 4);
+}
+
+/* ---- header and index -------------------------------------------------- */
+
+static inline void put32(uint8_t *p, uint32_t v) { memcpy(p, &v, 4); }
+static inline void put64(uint8_t *p, uint64_t v) { memcpy(p, &v, 8); }
+static inline uint32_t get32(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static inline uint64_t get64(const uint8_t *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+
+static int pread_full(int fd, void *dst, size_t n, off_t off) {
+    char *p = (char*)dst;
+    while (n > 0) {
+        ssize_t r = pread(fd, p, n, off);
+        if (r <= 0) return -1;
+        p += r; n -= (size_t)r; off += r;
+    }
+    return 0;
+}
+
+static int pwrite_full(int fd, const void *src, size_t n, off_t off) {
+    const char *p = (const char*)src;
+    while (n > 0) {
+        ssize_t r = pwrite(fd, p, n, off);
+        if (r <= 0) return -1;
+        p += r; n -= (size_t)r; off += r;
+    }
+    return 0;
+}
+
+static inline size_t min_sz(size_t a, size_t b) { return a < b ? a : b; }
+
+/* Raw bytes of tile (ti, tj). */
+static size_t tile_bytes(const CkFile *f, size_t ti, size_t tj) {
+    return min_sz(f->tile_r, f->rows - ti * f->tile_r) * min_sz(f->tile_c, f->cols - tj * f->tile_c) *
+           dt_size(f->dt);
+}
+
+int ck_is_chunk(const char *path) {
+    char m[8];
+    int fd = path ? open(path, O_RDONLY) : -1;
+    if (fd < 0) return 0;
+    int ok = pread_full(fd, m, sizeof(m), 0) == 0 && memcmp(m, CK_MAGIC, 8) == 0;
+    close(fd);
+    return ok;
+}
+
+void ck_close(CkFile *f) {
+    if (!f) return;
+    if (f->fd >= 0) close(f->fd);
+    free(f->path);
+    free(f->idx);
+    memset(f, 0, sizeof(*f));
+    f->fd = -1;
+}
+
+static int bad(CkFile *f, const char *what) {
+    fprintf(stderr, "[chunk] %s: %s\n", f->path ? f->path : "?", what);
+    ck_close(f);
+    return -1;
+}
+
+int ck_open(const char *path, CkFile *f) {
+    memset(f, 0, sizeof(*f));
+    f->fd = -1;
+    if (!path) return -1;
+    f->fd = open(path, O_RDONLY);
+    if (f->fd < 0) { perror("open"); return -1; }
+    f->path = strdup(path);
+    struct stat st;
+    uint8_t h[CK_HDR];
+    if (fstat(f->fd, &st) != 0 || pread_full(f->fd, h, CK_HDR, 0) != 0) return bad(f, "short header");
+    if (memcmp(h, CK_MAGIC, 8) != 0) return bad(f, "not a chunked file");
+    if (get32(h + 76) != crc32c(h, 76)) return bad(f, "header checksum mismatch");
+    if (get32(h + 8) != CK_VERSION || get32(h + 16) > DT_F32 || get32(h + 20) > CODEC_SHUF)
+        return bad(f, "unsupported version, type or codec");
+    f->vec = get32(h + 12) & 1;
+    f->dt = (DType)get32(h + 16);
+    f->codec = (Codec)get32(h + 20);
+    const uint64_t r = get64(h + 24), c = get64(h + 32), tr = get64(h + 40), tc = get64(h + 48);
+    const uint64_t ioff = get64(h + 56), nt = get64(h + 64);
+    if (!r || !c || !tr || !tc || tr > r || tc > c || tr > UINT32_MAX / tc / 8 || (f->vec && c != 1))
+        return bad(f, "bad dimensions");
+    f->rows = (size_t)r; f->cols = (size_t)c; f->tile_r = (size_t)tr; f->tile_c = (size_t)tc;
+    f->gr = (f->rows + f->tile_r - 1) / f->tile_r;
+    f->gc = (f->cols + f->tile_c - 1) / f->tile_c;
+    if (nt != (uint64_t)f->gr * f->gc || ioff < CK_HDR || ioff > (uint64_t)st.st_size ||
+        nt > ((uint64_t)st.st_size - ioff) / CK_ENTRY)
+        return bad(f, "bad index");
+
+    const size_t n = (size_t)nt;
+    uint8_t *raw = (uint8_t*)malloc(n * CK_ENTRY);
+    f->idx = (CkEntry*)malloc(n * sizeof(CkEntry));
+    if (!raw || !f->idx) { free(raw); return bad(f, "allocation failure"); }
+    if (pread_full(f->fd, raw, n * CK_ENTRY, (off_t)ioff) != 0) { free(raw); return bad(f, "short index"); }
+    if (crc32c(raw, n * CK_ENTRY) != get32(h + 72)) { free(raw); return bad(f, "index checksum mismatch"); }
+    for (size_t t = 0; t < n; t++) {
+        const uint8_t *e = raw + t * CK_ENTRY;
+        CkEntry *x = &f->idx[t];
+        x->off = get64(e); x->len = get32(e + 8); x->raw = get32(e + 12);
+        x->codec = get32(e + 16); x->crc = get32(e + 20);
+        if (x->raw != tile_bytes(f, t / f->gc, t % f->gc) || x->codec > CODEC_SHUF ||
+            x->off < CK_HDR || x->off > ioff || x->len > ioff - x->off ||
+            (x->codec == CODEC_NONE ? x->len != x->raw : x->len >= x->raw)) {
+            free(raw);
+            return bad(f, "bad index entry");
+        }
+    }
+    free(raw);
+    return 0;
+}
+
+/* ---- parallel read ----------------------------------------------------- */
+
+typedef struct {
+    const CkFile *f;
+    size_t r0, c0, ti0, tj0, ntj;
+    Mat *dst;
+    Split sp;
+    atomic_int err;    /* 1 read, 2 checksum, 3 decode, 4 memory */
+    atomic_size_t bad_tile;
+} ReadJob;
+
+/* Rows [i0, i1) x cols [j0, j1) of a decoded tile (tc columns, origin ti0, tj0) into dst. */
+static void scatter(const ReadJob *a, const uint8_t *tile, size_t tc, size_t ti0, size_t tj0,
+                    size_t i0, size_t i1, size_t j0, size_t j1) {
+    const DType from = a->f->dt, to = a->dst->dt;
+    const size_t fe = dt_size(from), te = dt_size(to), w = j1 - j0;
+    for (size_t i = i0; i < i1; i++) {
+        const uint8_t *s = tile + ((i - ti0) * tc + (j0 - tj0)) * fe;
+        char *d = (char*)a->dst->data + ((i - a->r0) * a->dst->ld + (j0 - a->c0)) * te;
+        if (from == to) memcpy(d, s, w * fe);
+        else if (to == DT_F32) for (size_t j = 0; j < w; j++) { double v; memcpy(&v, s + j * 8, 8); ((float*)d)[j] = (float)v; }
+        else for (size_t j = 0; j < w; j++) { float v; memcpy(&v, s + j * 4, 4); ((double*)d)[j] = v; }
+    }
+}
+
+static void read_worker(void *p, int tid, int nt) {
+    ReadJob *a = (ReadJob*)p;
+    const CkFile *f = a->f;
+    const size_t cap = f->tile_r * f->tile_c * dt_size(f->dt);
+    uint8_t *st = (uint8_t*)malloc(cap), *dec = (uint8_t*)malloc(cap), *tmp = (uint8_t*)malloc(cap);
+    if (!st || !dec || !tmp) { atomic_store(&a->err, 4); free(st); free(dec); free(tmp); return; }
+    int taken = 0;
+    size_t t0, t1;
+    while (!atomic_load_explicit(&a->err, memory_order_relaxed) && split_next(&a->sp, tid, nt, &taken, &t0, &t1)) {
+        for (size_t t = t0; t < t1; t++) {
+            const size_t ti = a->ti0 + t / a->ntj, tj = a->tj0 + t % a->ntj;
+            const CkEntry *e = &f->idx[ti * f->gc + tj];
+            int err = 0;
+            if (pread_full(f->fd, st, e->len, (off_t)e->off) != 0) err = 1;
+            else if (crc32c(st, e->len) != e->crc) err = 2;
+            const uint8_t *tile = st;
+            if (!err && e->codec == CODEC_LZ) {
+                err = lz_decode(st, e->len, dec, e->raw) != 0 ? 3 : 0;
+                tile = dec;
+            } else if (!err && e->codec == CODEC_SHUF) {
+                err = lz_decode(st, e->len, tmp, e->raw) != 0 ? 3 : 0;
+                if (!err) unshuffle(tmp, dec, e->raw / dt_size(f->dt), dt_size(f->dt));
+                tile = dec;
+            }
+            if (err) {
+                atomic_store(&a->bad_tile, ti * f->gc + tj);
+                atomic_store(&a->err, err);
+                break;
+            }
+            const size_t gi = ti * f->tile_r, gj = tj * f->tile_c;
+            const size_t tc = min_sz(f->tile_c, f->cols - gj);
+            const size_t i0 = gi > a->r0 ? gi : a->r0, j0 = gj > a->c0 ? gj : a->c0;
+            const size_t i1 = min_sz(gi + f->tile_r, a->r0 + a->dst->rows);
+            const size_t j1 = min_sz(gj + tc, a->c0 + a->dst->cols);
+            scatter(a, tile, tc, gi, gj, i0, i1, j0, j1);
+        }
+    }
+    free(st); free(dec); free(tmp);
+}
+
+int ck_read(const CkFile *f, size_t r0, size_t c0, Mat *dst, Pool *p, int nt) {
+    if (!f || !dst || (!dst->data && dst->rows && dst->cols)) return -1;
+    if (!dst->rows || !dst->cols) return 0;
+    if (r0 > f->rows || dst->rows > f->rows - r0 || c0 > f->cols || dst->cols > f->cols - c0) return -1;
+    ReadJob a = { .f = f, .r0 = r0, .c0 = c0, .dst = dst };
+    a.ti0 = r0 / f->tile_r; a.tj0 = c0 / f->tile_c;
+    const size_t nti = (r0 + dst->rows - 1) / f->tile_r - a.ti0 + 1;
+    a.ntj = (c0 + dst->cols - 1) / f->tile_c - a.tj0 + 1;
+    split_init(&a.sp, nti * a.ntj, SCHED_DYNAMIC, 1);
+    atomic_init(&a.err, 0);
+    atomic_init(&a.bad_tile, 0);
+    if (nt > (int)(nti * a.ntj)) nt = (int)(nti * a.ntj);
+    if (!p || nt <= 1) read_worker(&a, 0, 1);
+    else if (pool_run(p, nt, read_worker, &a) < 0) return -1;
+    const int err = atomic_load(&a.err);
+    if (!err) return 0;
+    static const char *why[] = { "", "read failed", "checksum mismatch", "corrupt data", "allocation failure" };
+    fprintf(stderr, "[chunk] %s: tile %zu: %s\n", f->path, atomic_load(&a.bad_tile), why[err]);
+    return -1;
+}
+
+/* ---- parallel write ---------------------------------------------------- */
+
+typedef struct {
+    CkFile f;               /* geometry and index being built; fd is the output */
+    const char *data;
+    size_t ld;
+    Codec codec;
+    Split sp;
+    atomic_ullong off;      /* next free byte: tiles land in completion order */
+    atomic_int err;
+} WriteJob;
+
+static void write_worker(void *p, int tid, int nt) {
+    WriteJob *a = (WriteJob*)p;
+    CkFile *f = &a->f;
+    const size_t esz = dt_size(f->dt), cap = f->tile_r * f->tile_c * esz;
+    uint8_t *raw = (uint8_t*)malloc(cap), *tmp = (uint8_t*)malloc(cap), *enc = (uint8_t*)malloc(cap);
+    if (!raw || !tmp || !enc) { atomic_store(&a->err, 1); free(raw); free(tmp); free(enc); return; }
+    int taken = 0;
+    size_t t0, t1;
+    while (!atomic_load_explicit(&a->err, memory_order_relaxed) && split_next(&a->sp, tid, nt, &taken, &t0, &t1)) {
+        for (size_t t = t0; t < t1; t++) {
+            const size_t ti = t / f->gc, tj = t % f->gc, gi = ti * f->tile_r, gj = tj * f->tile_c;
+            const size_t tr = min_sz(f->tile_r, f->rows - gi), tc = min_sz(f->tile_c, f->cols - gj);
+            const size_t n = tr * tc * esz;
+            for (size_t i = 0; i < tr; i++)
+                memcpy(raw + i * tc * esz, a->data + ((gi + i) * a->ld + gj) * esz, tc * esz);
+
+            /* Keep the encoding only if it is smaller than the raw tile. */
+            const uint8_t *out = raw;
+            size_t len = n;
+            Codec used = CODEC_NONE;
+            if (a->codec == CODEC_LZ) {
+                size_t z = lz_encode(raw, n, enc, n - 1);
+                if (z) { out = enc; len = z; used = CODEC_LZ; }
+            } else if (a->codec == CODEC_SHUF) {
+                shuffle(raw, tmp, n / esz, esz);
+                size_t z = lz_encode(tmp, n, enc, n - 1);
+                if (z) { out = enc; len = z; used = CODEC_SHUF; }
+            }
+            const uint64_t off = atomic_fetch_add(&a->off, (unsigned long long)len);
+            if (pwrite_full(f->fd, out, len, (off_t)off) != 0) { atomic_store(&a->err, 1); break; }
+            f->idx[t] = (CkEntry){ .off = off, .len = (uint32_t)len, .raw = (uint32_t)n,
+                                   .codec = used, .crc = crc32c(out, len) };
+        }
+    }
+    free(raw); free(tmp); free(enc);
+}
+
+static int ck_write(const char *path, const void *data, size_t rows, size_t cols, size_t ld, DType dt,
+                    int vec, const CkOpts *o) {
+    if (!path || !data || !rows || !cols) return -1;
+    WriteJob a;
+    memset(&a, 0, sizeof(a));
+    CkFile *f = &a.f;
+    f->vec = vec; f->dt = dt; f->rows = rows; f->cols = cols;
+    f->codec = a.codec = o ? o->codec : CODEC_SHUF;
+    f->tile_r = o && o->tile_r ? o->tile_r : vec ? CK_VTILE : CK_TILE;
+    f->tile_c = vec ? 1 : o && o->tile_c ? o->tile_c : CK_TILE;
+    if (f->tile_r > rows) f->tile_r = rows;
+    if (f->tile_c > cols) f->tile_c = cols;
+    if (f->tile_r > UINT32_MAX / f->tile_c / 8) {
+        fprintf(stderr, "[chunk] Tiles of %zux%zu are too large\n", f->tile_r, f->tile_c);
+        return -1;
+    }
+    f->gr = (rows + f->tile_r - 1) / f->tile_r;
+    f->gc = (cols + f->tile_c - 1) / f->tile_c;
+    const size_t n = f->gr * f->gc;
+    a.data = (const char*)data;
+    a.ld = ld;
+    f->idx = (CkEntry*)calloc(n, sizeof(CkEntry));
+    uint8_t *ib = (uint8_t*)malloc(n * CK_ENTRY);
+    f->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (f->fd < 0) perror(path);
+    if (!f->idx || !ib || f->fd < 0) {
+        free(f->idx); free(ib);
+        if (f->fd >= 0) close(f->fd);
+        return -1;
+    }
+
+    split_init(&a.sp, n, SCHED_DYNAMIC, 1);
+    atomic_init(&a.off, CK_HDR);
+    atomic_init(&a.err, 0);
+    int nt = o ? o->nt : 1;
+    if (nt > (int)n) nt = (int)n;
+    if (!o || !o->pool || nt <= 1) write_worker(&a, 0, 1);
+    else if (pool_run(o->pool, nt, write_worker, &a) < 0) atomic_store(&a.err, 1);
+
+    int rc = atomic_load(&a.err) ? -1 : 0;
+    const uint64_t ioff = atomic_load(&a.off);
+    for (size_t t = 0; t < n; t++) {
+        uint8_t *e = ib + t * CK_ENTRY;
+        put64(e, f->idx[t].off); put32(e + 8, f->idx[t].len); put32(e + 12, f->idx[t].raw);
+        put32(e + 16, f->idx[t].codec); put32(e + 20, f->idx[t].crc);
+    }
+    uint8_t h[CK_HDR];
+    memcpy(h, CK_MAGIC, 8);
+    put32(h + 8, CK_VERSION); put32(h + 12, (uint32_t)vec); put32(h + 16, (uint32_t)dt); put32(h + 20, a.codec);
+    put64(h + 24, rows); put64(h + 32, cols); put64(h + 40, f->tile_r); put64(h + 48, f->tile_c);
+    put64(h + 56, ioff); put64(h + 64, n);
+    put32(h + 72, crc32c(ib, n * CK_ENTRY));
+    put32(h + 76, crc32c(h, 76));
+    if (rc == 0 && (pwrite_full(f->fd, ib, n * CK_ENTRY, (off_t)ioff) != 0 ||
+                    pwrite_full(f->fd, h, CK_HDR, 0) != 0)) rc = -1;
+    if (close(f->fd) != 0) rc = -1;
+    if (rc != 0) { fprintf(stderr, "[chunk] Failed to write %s\n", path); unlink(path); }
+    free(f->idx); free(ib);
+    return rc;
+}
+
+int ck_save_mat(const char *path, const Mat *A, const CkOpts *o) {
+    if (!A) return -1;
+    return ck_write(path, A->data, A->rows, A->cols, A->ld, A->dt, 0, o);
+}
+
+int ck_save_vec(const char *path, const Vec *v, const CkOpts *o) {
+    if (!v) return -1;
+    return ck_write(path, v->data, v->len, 1, 1, v->dt, 1, o);
+}
@@ -0,0 +1,74 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include "matrix.h"
+
+/*
+ * Chunked container (FMT_CHUNK): a matrix (or vector, as len x 1) cut
+ * into tile_r x tile_c tiles, each stored row-major on its own, encoded
+ * with a codec and checksummed (CRC32C of the stored bytes), followed
+ * by an index of every tile's offset, sizes, codec and checksum.
+ *
+ *   0   "MCECHUNK", u32 version, u32 flags (1 = vector), u32 dt, u32 codec
+ *   24  u64 rows, cols, tile_r, tile_c, index offset, tile count
+ *   72  u32 index CRC, u32 CRC of bytes [0, 76)
+ *   80  tiles in any order, then the index: per tile (row-major grid)
+ *       u64 offset, u32 stored bytes, u32 raw bytes, u32 codec, u32 CRC
+ *
+ * Tiles are independent, so any block can be read by decoding only the
+ * tiles it overlaps, and a load decodes tiles on all pool threads.
+ */
+#define CK_MAGIC  "MCECHUNK"
+#define CK_HDR    80
+#define CK_TILE   256      /* default matrix tile edge */
+#define CK_VTILE  65536    /* default vector chunk length */
+
+/*
+ * CODEC_LZ: LZ4-style byte-oriented LZ77 (64 KiB window), fast to decode.
+ * CODEC_SHUF: byte shuffle (byte b of every element together) then LZ;
+ * sign and exponent bytes of doubles repeat far more often than whole
+ * values do. A tile that does not shrink is stored as CODEC_NONE.
+ */
+typedef enum { CODEC_NONE, CODEC_LZ, CODEC_SHUF } Codec;
+
+typedef struct {
+    Codec codec;
+    size_t tile_r, tile_c;   /* 0 = CK_TILE (CK_VTILE x 1 for vectors) */
+    Pool *pool;              /* encode tiles on nt threads of pool */
+    int nt;
+} CkOpts;
+
+typedef struct { uint64_t off; uint32_t len, raw, codec, crc; } CkEntry;
+
+typedef struct {
+    int fd;
+    char *path;
+    int vec;
+    DType dt;
+    Codec codec;
+    size_t rows, cols, tile_r, tile_c, gr, gc;   /* gr x gc tiles */
+    CkEntry *idx;
+} CkFile;
+
+const char *ck_codec_name(Codec c);
+
+/* 1 if path starts with CK_MAGIC. */
+int  ck_is_chunk(const char *path);
+
+/* Reads and verifies the header and index. */
+int  ck_open(const char *path, CkFile *f);
+void ck_close(CkFile *f);
+
+/*
+ * dst->rows x dst->cols elements at (r0, c0) into dst (any ld, dst->dt;
+ * the stored type is converted). Each overlapped tile is read with
+ * pread, checked and decoded once, on nt threads of p (p == NULL or
+ * nt <= 1: the calling thread). -1 on I/O, checksum or decode errors.
+ */
+int  ck_read(const CkFile *f, size_t r0, size_t c0, Mat *dst, Pool *p, int nt);
+
+/* o may be NULL: CODEC_SHUF, default tiles, one thread. */
+int  ck_save_mat(const char *path, const Mat *A, const CkOpts *o);
+int  ck_save_vec(const char *path, const Vec *v, const CkOpts *o);
+
+#endif
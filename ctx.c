@@ -0,0 +1,100 @@
+#define _POSIX_C_SOURCE 200809L
+#include "ctx.h"
+#include "simd.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+volatile sig_atomic_t g_stop = 0;
+
+void ctx_opts_init(CtxOpts *o) {
+    *o = (CtxOpts){ .nt = 1, .dt = DT_F64, .arena_keep = ARENA_KEEP_DEFAULT, .huge = HUGE_OFF };
+    o->cfg = (KCfg){ .nt = 1, .tile = 64, .mm_algo = MM_TILED, .acc = ACC_NATIVE,
+                     .sched = SCHED_STATIC, .red = RED_FAST };
+}
+
+static int online_cpus(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n < 1 ? 1 : n > POOL_MAX_THREADS ? POOL_MAX_THREADS : (int)n;
+}
+
+int ctx_init(ExecCtx *c, const CtxOpts *o) {
+    memset(c, 0, sizeof(*c));
+    c->fixed = o->fixed;
+    arena_config(o->arena_keep, o->huge);
+
+    /* The profile is per ISA, so it is read after simd_select. */
+    if (!o->profile || strcmp(o->profile, "none") != 0) {
+        if (o->profile) snprintf(c->prof_path, sizeof(c->prof_path), "%s", o->profile);
+        else if (profile_default_path(c->prof_path, sizeof(c->prof_path)) != 0) c->prof_path[0] = '\0';
+        if (c->prof_path[0]) {
+            if (profile_load(&c->prof, c->prof_path) == 0) c->tuned = &c->prof;
+            else c->prof_err = 1;
+        }
+    }
+
+    int nt = o->nt > 0 ? o->nt : online_cpus();
+    if (c->tuned && !(o->fixed & TUNE_FIX_THREADS)) {
+        int want = profile_max_threads(c->tuned, simd_ops()->name);
+        if (want > nt) nt = want > POOL_MAX_THREADS ? POOL_MAX_THREADS : want;
+    }
+    c->pool = pool_create(nt);
+    if (!c->pool) { profile_free(&c->prof); return -1; }
+    c->nt = pool_size(c->pool);
+    if (o->numa) c->nodes = pool_pin(c->pool);
+
+    c->cfg = o->cfg;
+    c->cfg.pool = c->pool;
+    c->cfg.nt = o->nt > 0 ? o->nt : c->nt;
+    c->lo = (LoadOpts){ .nt = c->nt, .pool = c->pool, .numa = o->numa, .dt = o->dt };
+    return 0;
+}
+
+void ctx_free(ExecCtx *c) {
+    pool_destroy(c->pool);
+    profile_free(&c->prof);
+    arena_trim();
+    memset(c, 0, sizeof(*c));
+}
+
+KCfg ctx_cfg(const ExecCtx *c, const char *op, double bytes) {
+    KCfg cfg = c->cfg;
+    if (!c->tuned) return cfg;
+    const char *dtype = c->lo.dt == DT_F64 ? "f64" : cfg.acc == ACC_F64 ? "mixed" : "f32";
+    const TuneEntry *e = profile_find(c->tuned, op, dtype, simd_ops()->name, tune_class(bytes));
+    if (!e) return cfg;
+    if (strcmp(op, "mm") == 0) {
+        if (!(c->fixed & TUNE_FIX_TILE) && e->tile > 0) cfg.tile = e->tile;
+        if (!(c->fixed & TUNE_FIX_ALGO)) {
+            cfg.mm_algo = e->algo;
+            cfg.mc = e->mc; cfg.kc = e->kc; cfg.nc = e->nc;
+        }
+    }
+    if (!(c->fixed & TUNE_FIX_THREADS) && e->threads > 0)
+        cfg.nt = e->threads < c->nt ? e->threads : c->nt;
+    return cfg;
+}
+
+int ctx_mm(const ExecCtx *c, const Mat *A, const Mat *B, Mat *C) {
+    *C = (Mat){0};
+    if (A->cols != B->rows) return -1;
+    double e = (double)dt_size(A->dt);
+    double bytes = e * ((double)A->rows * A->cols + (double)B->rows * B->cols + (double)A->rows * B->cols);
+    KCfg cfg = ctx_cfg(c, "mm", bytes);
+    *C = c->lo.numa ? m_alloc_local(A->rows, B->cols, A->dt, c->pool, c->nt)
+                    : m_alloc_arena(A->rows, B->cols, A->dt);
+    if (!C->data) return -1;
+    if (mm_mt(A, TR_N, B, TR_N, C, cfg) != 0) { m_free(C); return -1; }
+    return g_stop ? 2 : 0;
+}
+
+int ctx_mv(const ExecCtx *c, const Mat *A, const Vec *x, Vec *y) {
+    *y = (Vec){0};
+    if (A->cols != x->len) return -1;
+    double bytes = (double)dt_size(A->dt) * ((double)A->rows * A->cols + A->cols + A->rows);
+    KCfg cfg = ctx_cfg(c, "mv", bytes);
+    *y = c->lo.numa ? v_alloc_local(A->rows, A->dt, c->pool, c->nt) : v_alloc_arena(A->rows, A->dt);
+    if (!y->data) return -1;
+    if (mv_mt(A, TR_N, x, y, cfg) != 0) { v_free(y); return -1; }
+    return g_stop ? 2 : 0;
+}
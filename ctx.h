@@ -0,0 +1,74 @@
+#ifndef CTX_H
+#define CTX_H
+
+#include "kernels.h"
+#include "tune.h"
+#include "arena.h"
+#include <limits.h>
+#include <signal.h>
+
+/*
+ * Execution context of the library (libmce.a, libmce.so): everything a
+ * process sets up once and every call then reuses. The worker pool, the
+ * kernel settings and the per-host tuning profile, and the buffer arena
+ * behind results and scratch. The pool is not reentrant, so one thread
+ * at a time may call through a context. The SIMD variant is process-wide:
+ * choose it with simd_select() before ctx_init if not "auto".
+ */
+
+/* Set to 1 (from a signal handler, say) to make running kernels return early; cleared by the caller. */
+extern volatile sig_atomic_t g_stop;
+
+typedef struct {
+    int nt;                 /* pool threads; 0 = every online CPU */
+    int numa;               /* pin the pool across NUMA nodes; loads and results first-touch on it */
+    DType dt;               /* element type operands load into */
+    KCfg cfg;               /* base kernel settings; nt and pool are filled in */
+    unsigned fixed;         /* TUNE_FIX_* settings the profile must not override */
+    const char *profile;    /* profile path; NULL = profile_default_path(), "none" = untuned */
+    size_t arena_keep;      /* passed to arena_config with huge */
+    HugeMode huge;
+} CtxOpts;
+
+typedef struct {
+    Pool *pool;
+    int nt;                 /* pool size */
+    int nodes;              /* NUMA nodes pinned across; 0 if not asked, -1 if pinning failed */
+    KCfg cfg;
+    LoadOpts lo;            /* loads on the pool into opts dt */
+    unsigned fixed;
+    Profile prof;
+    Profile *tuned;         /* &prof once read, NULL when untuned */
+    char prof_path[PATH_MAX];   /* "" when there is none */
+    int prof_err;           /* prof_path exists but could not be read */
+} ExecCtx;
+
+/* Defaults of the command line: one thread, f64, tile 64, the default profile and arena. */
+void ctx_opts_init(CtxOpts *o);
+
+/*
+ * Starts the pool, reads the profile and configures the arena. Without
+ * TUNE_FIX_THREADS the pool grows to the most threads a profile entry
+ * asks for. An unreadable profile leaves the context untuned (prof_err).
+ * -1 if the pool cannot start.
+ */
+int  ctx_init(ExecCtx *c, const CtxOpts *o);
+/* Stops the pool, frees the profile and trims the arena. */
+void ctx_free(ExecCtx *c);
+
+/*
+ * c->cfg with the profile entry for op (a profile key such as "mm" or
+ * "mv") at the size class of bytes of traffic applied, where
+ * c->fixed allows.
+ */
+KCfg ctx_cfg(const ExecCtx *c, const char *op, double bytes);
+
+/*
+ * C = A * B and y = A * x with ctx_cfg settings. The result is allocated
+ * like the benchmark's (arena, or first-touch with numa) and freed
+ * with m_free/v_free. 0, -1 on a shape or kernel error, 2 if interrupted.
+ */
+int ctx_mm(const ExecCtx *c, const Mat *A, const Mat *B, Mat *C);
+int ctx_mv(const ExecCtx *c, const Mat *A, const Vec *x, Vec *y);
+
+#endif
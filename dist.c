@@ -0,0 +1,425 @@
+#include "dist.h"
+#include "simd.h"
+#include "arena.h"
+#include <mpi.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <math.h>
+
+extern volatile sig_atomic_t g_stop;
+
+static int g_init;
+
+/*
+ * SIGINT only raises g_int while distributed ops run; dist_call turns it
+ * into g_stop on every rank at once, so all ranks leave bench_run after
+ * the same sample and meet at the same collectives.
+ */
+static volatile sig_atomic_t g_int;
+static void on_int(int signo) { (void)signo; g_int = 1; }
+
+int dist_init(int *argc, char ***argv) {
+    int prov = MPI_THREAD_SINGLE;
+    if (MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED, &prov) != MPI_SUCCESS) return -1;
+    g_init = 1;
+    /* Pool threads never call MPI, so funneled is all that is needed. */
+    return prov >= MPI_THREAD_FUNNELED ? 0 : -1;
+}
+
+void dist_finalize(void) {
+    if (g_init) MPI_Finalize();
+    g_init = 0;
+}
+
+int dist_rank(void) {
+    int r = 0;
+    if (g_init) MPI_Comm_rank(MPI_COMM_WORLD, &r);
+    return r;
+}
+
+int dist_size(void) {
+    int s = 1;
+    if (g_init) MPI_Comm_size(MPI_COMM_WORLD, &s);
+    return s;
+}
+
+static inline size_t min_sz(size_t a, size_t b) { return a < b ? a : b; }
+
+/* Elements of [0, len) in the nb-blocks dealt cyclically to part p of np. */
+static size_t cyc_len(size_t len, size_t nb, int p, int np) {
+    size_t nblk = (len + nb - 1) / nb, n = 0;
+    for (size_t b = (size_t)p; b < nblk; b += (size_t)np) n += min_sz(nb, len - b * nb);
+    return n;
+}
+
+typedef struct {
+    MPI_Comm comm;
+    int rank, size;
+    DistLayout layout;
+    int mv;
+    int pr, pc, myr, myc;   /* SUMMA grid */
+    MPI_Comm rowc, colc;    /* SUMMA: this rank's grid row and grid column */
+    size_t m, k, n, nb;     /* global shape: C (or y) is m x n, n = 1 for mv */
+    Mat A, B, C;            /* local blocks; B unused for mv */
+    Vec x, y;
+    void *buf[2][2];        /* ring: [0][slot] blocks in flight, [1][0] own block; SUMMA: [0] A and [1] B panels */
+    MPI_Datatype ety;
+    KCfg cfg;
+} DistJob;
+
+static Mat flat(void *p, size_t r, size_t c, DType dt) {
+    return (Mat){ .rows = r, .cols = c, .data = (double*)p, .ld = c, .dt = dt, .mem = MEM_VIEW };
+}
+
+static void zero_mat(Mat *C) {
+    const size_t esz = dt_size(C->dt);
+    for (size_t i = 0; i < C->rows; i++) memset((char*)C->data + i * C->ld * esz, 0, C->cols * esz);
+}
+
+/* ---- 1-D ring ---------------------------------------------------------- */
+
+/* Rows of B (elements of x) that rank r owns. */
+static void ring_range(const DistJob *d, int r, size_t *k0, size_t *k1) {
+    row_range(d->k, r, d->size, k0, k1);
+}
+
+/*
+ * P steps; at step s a rank holds the block of rank (rank + s) % P. It
+ * sends that block on to rank - 1 and receives the next from rank + 1
+ * while it multiplies the matching columns of its A. The own block
+ * stays in place, so every call starts from it.
+ */
+static int ring_run(DistJob *d) {
+    const DType dt = d->A.dt;
+    const size_t w = d->mv ? 1 : d->n;
+    const int next = (d->rank + 1) % d->size, prev = (d->rank + d->size - 1) % d->size;
+    if (!d->mv) zero_mat(&d->C);   /* y is overwritten at step 0 */
+    int rc = 0;
+    for (int s = 0; s < d->size && rc == 0; s++) {
+        const int o = (d->rank + s) % d->size;
+        void *cur = s ? d->buf[0][(s - 1) & 1] : d->buf[1][0];
+        size_t k0, k1, n0, n1;
+        ring_range(d, o, &k0, &k1);
+        MPI_Request rq[2];
+        int nrq = 0;
+        if (s + 1 < d->size) {
+            ring_range(d, (o + 1) % d->size, &n0, &n1);
+            MPI_Irecv(d->buf[0][s & 1], (int)((n1 - n0) * w), d->ety, next, s, d->comm, &rq[nrq++]);
+            MPI_Isend(cur, (int)((k1 - k0) * w), d->ety, prev, s, d->comm, &rq[nrq++]);
+        }
+        if (d->A.rows && k1 > k0) {
+            Mat Ab = m_view(&d->A, 0, k0, d->A.rows, k1 - k0);
+            if (d->mv) {
+                Vec xb = { .len = k1 - k0, .data = (double*)cur, .dt = dt, .mem = MEM_VIEW };
+                rc = gemv_mt(1.0, &Ab, &xb, s == 0 ? 0.0 : 1.0, &d->y, d->cfg);
+            } else {
+                Mat Bb = flat(cur, k1 - k0, d->n, dt);
+                rc = mm_acc_mt(&Ab, &Bb, &d->C, d->cfg);
+            }
+        } else if (d->mv && s == 0) {
+            memset(d->y.data, 0, d->y.len * dt_size(dt));
+        }
+        if (nrq) MPI_Waitall(nrq, rq, MPI_STATUSES_IGNORE);
+    }
+    return rc;
+}
+
+/* ---- SUMMA ------------------------------------------------------------- */
+
+/* Copies this rank's share of k block K into panel slot and starts both broadcasts. */
+static void summa_post(DistJob *d, size_t K, int slot, MPI_Request *rq) {
+    const size_t kb = min_sz(d->nb, d->k - K * d->nb), esz = dt_size(d->A.dt);
+    const int ac = (int)(K % (size_t)d->pc), br = (int)(K % (size_t)d->pr);
+    char *ap = (char*)d->buf[0][slot], *bp = (char*)d->buf[1][slot];
+    if (d->myc == ac) {
+        const size_t c0 = K / (size_t)d->pc * d->nb;
+        for (size_t i = 0; i < d->A.rows; i++)
+            memcpy(ap + i * kb * esz, (char*)d->A.data + (i * d->A.ld + c0) * esz, kb * esz);
+    }
+    if (d->myr == br) {
+        const size_t r0 = K / (size_t)d->pr * d->nb;
+        for (size_t i = 0; i < kb; i++)
+            memcpy(bp + i * d->B.cols * esz, (char*)d->B.data + (r0 + i) * d->B.ld * esz, d->B.cols * esz);
+    }
+    MPI_Ibcast(ap, (int)(d->A.rows * kb), d->ety, ac, d->rowc, &rq[0]);
+    MPI_Ibcast(bp, (int)(kb * d->B.cols), d->ety, br, d->colc, &rq[1]);
+}
+
+static int summa_run(DistJob *d) {
+    const size_t KB = (d->k + d->nb - 1) / d->nb;
+    MPI_Request rq[2][2];
+    zero_mat(&d->C);
+    summa_post(d, 0, 0, rq[0]);
+    int rc = 0;
+    for (size_t K = 0; K < KB; K++) {
+        const int slot = (int)(K & 1);
+        MPI_Waitall(2, rq[slot], MPI_STATUSES_IGNORE);
+        if (K + 1 < KB) summa_post(d, K + 1, slot ^ 1, rq[slot ^ 1]);
+        const size_t kb = min_sz(d->nb, d->k - K * d->nb);
+        if (rc == 0 && d->C.rows && d->C.cols) {
+            Mat Ap = flat(d->buf[0][slot], d->C.rows, kb, d->A.dt);
+            Mat Bp = flat(d->buf[1][slot], kb, d->C.cols, d->A.dt);
+            rc = mm_acc_mt(&Ap, &Bp, &d->C, d->cfg);
+        }
+    }
+    return rc;
+}
+
+/* Starts with a barrier that also spreads an interrupt (g_int above). */
+static int dist_call(void *p) {
+    DistJob *d = (DistJob*)p;
+    int stop = g_int, any = 0;
+    MPI_Allreduce(&stop, &any, 1, MPI_INT, MPI_MAX, d->comm);
+    if (any) { g_stop = 1; return 0; }
+    return d->layout == DIST_SUMMA ? summa_run(d) : ring_run(d);
+}
+
+/* ---- setup ------------------------------------------------------------- */
+
+static void job_free(DistJob *d) {
+    m_free(&d->A); m_free(&d->B); m_free(&d->C);
+    v_free(&d->x); v_free(&d->y);
+    for (int i = 0; i < 2; i++)
+        for (int s = 0; s < 2; s++) arena_put(d->buf[i][s]);
+    if (d->rowc != MPI_COMM_NULL) MPI_Comm_free(&d->rowc);
+    if (d->colc != MPI_COMM_NULL) MPI_Comm_free(&d->colc);
+}
+
+/* Reads every nb x nb block this grid position owns into the local matrix M. */
+static int read_cyclic(const char *path, Mat *M, size_t rows, size_t cols, size_t nb,
+                       int p, int np, int q, int nq) {
+    for (size_t I = (size_t)p, li = 0; I * nb < rows; I += (size_t)np, li++)
+        for (size_t J = (size_t)q, lj = 0; J * nb < cols; J += (size_t)nq, lj++) {
+            Mat v = m_view(M, li * nb, lj * nb, min_sz(nb, rows - I * nb), min_sz(nb, cols - J * nb));
+            if (m_read_block(path, I * nb, J * nb, &v) != 0) return -1;
+        }
+    return 0;
+}
+
+/* The local blocks for the first m rows of A on comm; collective, 0 only if every rank succeeded. */
+static int job_setup(DistJob *d, MPI_Comm comm, const DistOpts *o, KCfg cfg, int mv,
+                     const char *Apath, const char *Bpath, size_t m, size_t k, size_t n) {
+    memset(d, 0, sizeof(*d));
+    d->comm = comm; d->layout = mv ? DIST_1D : o->layout; d->mv = mv; d->cfg = cfg;
+    d->m = m; d->k = k; d->n = n; d->nb = o->nb ? o->nb : DIST_NB;
+    d->rowc = d->colc = MPI_COMM_NULL;
+    d->ety = o->dt == DT_F32 ? MPI_FLOAT : MPI_DOUBLE;
+    MPI_Comm_rank(comm, &d->rank);
+    MPI_Comm_size(comm, &d->size);
+    const DType dt = o->dt;
+    const size_t esz = dt_size(dt);
+    int ok = 1;
+
+    if (d->layout == DIST_1D) {
+        size_t i0, i1, kmax = (k + (size_t)d->size - 1) / (size_t)d->size, k0, k1;
+        row_range(m, d->rank, d->size, &i0, &i1);
+        ring_range(d, d->rank, &k0, &k1);
+        const size_t w = mv ? 1 : n;
+        if (kmax * w > INT_MAX) ok = 0;
+        d->A = m_alloc_dt(i1 - i0, k, dt);
+        for (int s = 0; s < 2; s++) d->buf[0][s] = arena_get((kmax ? kmax : 1) * w * esz, 0);
+        d->buf[1][0] = arena_get((kmax ? kmax : 1) * w * esz, 0);
+        if (mv) d->y = v_alloc_dt(i1 - i0 ? i1 - i0 : 1, dt), d->y.len = i1 - i0;
+        else d->C = m_alloc_dt(i1 - i0 ? i1 - i0 : 1, n, dt), d->C.rows = i1 - i0;
+        if (!d->buf[0][0] || !d->buf[0][1] || !d->buf[1][0] || (mv ? !d->y.data : !d->C.data) || (i1 > i0 && !d->A.data)) ok = 0;
+        if (ok && i1 > i0 && m_read_block(Apath, i0, 0, &d->A) != 0) ok = 0;
+        if (ok && k1 > k0) {
+            if (mv) {
+                Vec xb = { .len = k1 - k0, .data = (double*)d->buf[1][0], .dt = dt, .mem = MEM_VIEW };
+                ok = v_read_block(Bpath, k0, &xb) == 0;
+            } else {
+                Mat Bb = flat(d->buf[1][0], k1 - k0, n, dt);
+                ok = m_read_block(Bpath, k0, 0, &Bb) == 0;
+            }
+        }
+    } else {
+        /* pr x pc grid, pr the largest divisor of P not above sqrt(P). */
+        d->pr = 1;
+        for (int r = 1; r * r <= d->size; r++) if (d->size % r == 0) d->pr = r;
+        d->pc = d->size / d->pr;
+        d->myr = d->rank / d->pc; d->myc = d->rank % d->pc;
+        MPI_Comm_split(comm, d->myr, d->myc, &d->rowc);
+        MPI_Comm_split(comm, d->myc, d->myr, &d->colc);
+        const size_t nb = d->nb;
+        const size_t ma = cyc_len(m, nb, d->myr, d->pr), ka = cyc_len(k, nb, d->myc, d->pc);
+        const size_t kbr = cyc_len(k, nb, d->myr, d->pr), nbc = cyc_len(n, nb, d->myc, d->pc);
+        if (ma * nb > INT_MAX || nb * nbc > INT_MAX) ok = 0;
+        d->A = m_alloc_dt(ma ? ma : 1, ka ? ka : 1, dt);
+        d->B = m_alloc_dt(kbr ? kbr : 1, nbc ? nbc : 1, dt);
+        d->C = m_alloc_dt(ma ? ma : 1, nbc ? nbc : 1, dt);
+        d->A.rows = ma; d->A.cols = ka; d->B.rows = kbr; d->B.cols = nbc; d->C.rows = ma; d->C.cols = nbc;
+        for (int s = 0; s < 2; s++) {
+            d->buf[0][s] = arena_get((ma ? ma : 1) * nb * esz, 0);
+            d->buf[1][s] = arena_get(nb * (nbc ? nbc : 1) * esz, 0);
+            if (!d->buf[0][s] || !d->buf[1][s]) ok = 0;
+        }
+        if (!d->A.data || !d->B.data || !d->C.data) ok = 0;
+        if (ok && read_cyclic(Apath, &d->A, m, k, nb, d->myr, d->pr, d->myc, d->pc) != 0) ok = 0;
+        if (ok && read_cyclic(Bpath, &d->B, k, n, nb, d->myr, d->pr, d->myc, d->pc) != 0) ok = 0;
+    }
+
+    int all = 0;
+    MPI_Allreduce(&ok, &all, 1, MPI_INT, MPI_MIN, comm);
+    return all ? 0 : -1;
+}
+
+/* ---- timing and reports ------------------------------------------------ */
+
+/*
+ * Times the job on every rank of its communicator with one sample count
+ * for all (calibrated from the slowest rank when reps is 0), then
+ * reduces the per-rank statistics to their maximum on rank 0.
+ */
+static int time_job(DistJob *d, const BenchOpts *bo, BenchStats *st) {
+    BenchOpts o = *bo;
+    o.perf = NULL;
+    for (int w = 0; w < bo->warmup && !g_stop; w++) if (dist_call(d) != 0) return -1;
+    o.warmup = 0;
+    if (o.reps <= 0 && !g_stop) {
+        double t0 = now_s();
+        if (dist_call(d) != 0) return -1;
+        double t = now_s() - t0, tmax = 0.0;
+        MPI_Allreduce(&t, &tmax, 1, MPI_DOUBLE, MPI_MAX, d->comm);
+        o.reps = tmax > 0 ? (int)ceil(bo->min_time / tmax) : BENCH_MAX_SAMPLES;
+        if (o.reps < 1) o.reps = 1;
+        if (o.reps > BENCH_MAX_SAMPLES) o.reps = BENCH_MAX_SAMPLES;
+    }
+    if (g_stop) return 2;
+    int rc = bench_run(dist_call, NULL, d, &o, st);
+    double loc[3] = { st->median, st->min, st->p95 }, red[3];
+    MPI_Reduce(loc, red, 3, MPI_DOUBLE, MPI_MAX, 0, d->comm);
+    if (d->rank == 0) { st->median = red[0]; st->min = red[1]; st->p95 = red[2]; }
+    return rc;
+}
+
+/* Result preview and checksum: rank 0 holds the top-left block in both layouts. */
+static void job_summary(const DistJob *d) {
+    double s = 0.0, tot = 0.0;
+    if (d->mv) for (size_t i = 0; i < d->y.len; i++) s += v_get(&d->y, i);
+    else for (size_t i = 0; i < d->C.rows; i++) for (size_t j = 0; j < d->C.cols; j++) s += m_get(&d->C, i, j);
+    MPI_Reduce(&s, &tot, 1, MPI_DOUBLE, MPI_SUM, 0, d->comm);
+    if (d->rank != 0) return;
+    if (d->mv) {
+        printf("y preview:\n[");
+        for (size_t i = 0; i < d->y.len && i < 10; i++) printf("%s%.6g", i ? ", " : "", v_get(&d->y, i));
+        printf("%s]\n", d->y.len > 10 ? ", ..." : "");
+    } else {
+        printf("C preview (top-left):\n");
+        for (size_t i = 0; i < d->C.rows && i < 4; i++) {
+            printf("[");
+            for (size_t j = 0; j < d->C.cols && j < 4; j++) printf("%s%.6g", j ? ", " : "", m_get(&d->C, i, j));
+            printf("%s]\n", d->C.cols > 4 ? ", ..." : "");
+        }
+    }
+    printf("[dist] sum of all %s entries = %.12g\n", d->mv ? "y" : "C", tot);
+}
+
+typedef struct { int ranks; size_t m; BenchStats st; } DistPoint;
+
+static void report_points(const char *op, const DistOpts *o, KCfg cfg, const DistPoint *pt, int np,
+                          size_t k, size_t n, int mv, int weak) {
+    Report rep;
+    if (report_open(&rep, o->out_base, op) != 0) return;
+    const double esz = (double)dt_size(o->dt), t1 = pt[0].st.median;
+    for (int i = 0; i < np; i++) {
+        const double m = (double)pt[i].m, t = pt[i].st.median;
+        const double flops = mv ? 2.0 * m * k : 2.0 * m * n * k;
+        const double bytes = esz * (mv ? m * k + k + m : m * k + (double)k * n + m * n);
+        BenchRow row = { .op = op, .fmt = o->fmt, .isa = simd_ops()->name, .dtype = o->dtype,
+                         .m = pt[i].m, .n = mv ? k : n, .k = mv ? 0 : k, .threads = cfg.nt, .ranks = pt[i].ranks,
+                         .st = pt[i].st };
+        row.gflops = t > 0 ? flops / 1e9 / t : 0.0;
+        row.gbs = t > 0 ? bytes / 1e9 / t : 0.0;
+        /* Weak scaling grows the problem with the ranks: scaled speedup, efficiency t1 / t. */
+        row.speedup = t > 0 ? (weak ? pt[i].ranks * t1 / t : t1 / t) : 0.0;
+        row.efficiency = 100.0 * row.speedup * pt[0].ranks / pt[i].ranks;
+        report_row(&rep, &row);
+    }
+    report_close(&rep);
+}
+
+/* Rank counts to time: powers of two below P, then P; only P without a sweep. */
+static int sweep_counts(int P, int sweep, int *c) {
+    int n = 0;
+    if (sweep) for (int s = 1; s < P && n < 30; s *= 2) c[n++] = s;
+    c[n++] = P;
+    return n;
+}
+
+static int dist_op(const char *Apath, const char *Bpath, const DistOpts *o, KCfg cfg, int mv) {
+    size_t m, k, kb, n = 1;
+    DType fdt;
+    if (m_bin_info(Apath, &m, &k, &fdt) != 0 ||
+        (mv ? v_bin_info(Bpath, &kb, &fdt) : m_bin_info(Bpath, &kb, &n, &fdt)) != 0) {
+        if (dist_rank() == 0) fprintf(stderr, "[dist] Cannot read the bin headers of %s / %s\n", Apath, Bpath);
+        return -1;
+    }
+    if (k != kb) {
+        if (dist_rank() == 0) fprintf(stderr, "[dist] Dimension mismatch: A=%zux%zu, %s has %zu rows\n",
+                                      m, k, mv ? "x" : "B", kb);
+        return -1;
+    }
+    const int P = dist_size(), rank = dist_rank();
+    const DistLayout lay = mv ? DIST_1D : o->layout;
+    const char *base = mv ? "mv_1d" : lay == DIST_SUMMA ? "mm_summa" : "mm_1d";
+    if (rank == 0) {
+        printf("\n[dist] %s on %d rank(s) x %d thread(s): A=%zux%zu, %s=%zux%zu", base, P, cfg.nt, m, k,
+               mv ? "x" : "B", k, mv ? (size_t)1 : n);
+        if (lay == DIST_SUMMA) printf(", %zu-blocks", o->nb ? o->nb : (size_t)DIST_NB);
+        printf("\n");
+    }
+
+    void (*old)(int) = signal(SIGINT, on_int);
+    int counts[32];
+    const int nc = sweep_counts(P, o->sweep, counts);
+    DistPoint strong[32], weak[32];
+    int rc = 0;
+    for (int c = 0; c < nc && rc == 0; c++) {
+        const int s = counts[c];
+        for (int w = 0; w < (o->sweep ? 2 : 1) && rc == 0; w++) {
+            /* Weak: A's first m * s / P rows, so each rank keeps the work it has at P. */
+            const size_t mu = w ? (m * (size_t)s + (size_t)P - 1) / (size_t)P : m;
+            if (w && s == P) { weak[c] = strong[c]; continue; }
+            MPI_Comm sub;
+            MPI_Comm_split(MPI_COMM_WORLD, rank < s ? 0 : MPI_UNDEFINED, rank, &sub);
+            int r = 0;
+            if (sub != MPI_COMM_NULL) {
+                DistJob d;
+                BenchStats st = {0};
+                r = job_setup(&d, sub, o, cfg, mv, Apath, Bpath, mu, k, n);
+                if (r != 0 && rank == 0) fprintf(stderr, "[dist] Failed to load or allocate the local blocks\n");
+                if (r == 0) r = time_job(&d, &o->bo, &st);
+                if (r == 0 && s == P && !w) job_summary(&d);
+                job_free(&d);
+                MPI_Comm_free(&sub);
+                DistPoint pt = { s, mu, st };
+                if (w) weak[c] = pt; else strong[c] = pt;
+            }
+            /* Ranks outside the sub-communicator learn the outcome from rank 0. */
+            MPI_Bcast(&r, 1, MPI_INT, 0, MPI_COMM_WORLD);
+            rc = r;
+        }
+    }
+    signal(SIGINT, old);
+    if (g_int) g_stop = 1;
+    if (rc == 0 && rank == 0) {
+        report_points(base, o, cfg, strong, nc, k, n, mv, 0);
+        if (o->sweep) {
+            char wname[32];
+            snprintf(wname, sizeof(wname), "%s_weak", base);
+            report_points(wname, o, cfg, weak, nc, k, n, mv, 1);
+        }
+    }
+    return rc;
+}
+
+int dist_mm(const char *Apath, const char *Bpath, const DistOpts *o, KCfg cfg) {
+    return dist_op(Apath, Bpath, o, cfg, 0);
+}
+
+int dist_mv(const char *Apath, const char *xpath, const DistOpts *o, KCfg cfg) {
+    return dist_op(Apath, xpath, o, cfg, 1);
+}
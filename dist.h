@@ -0,0 +1,53 @@
+#ifndef DIST_H
+#define DIST_H
+
+#include "kernels.h"
+#include "bench.h"
+
+/*
+ * Distributed mm/mv over MPI, built with make MPI=1. Every rank reads
+ * only its own blocks of the FMT_BIN (or FMT_CHUNK) inputs and runs the
+ * threaded kernels on them with its own pool; only the main thread
+ * calls MPI.
+ *
+ * DIST_1D: rank r of P owns row_range(r, P) of A, of C (or y), and of B
+ * (or x). B's row blocks (x's blocks) travel round a ring: while a rank
+ * multiplies its A columns for the block it holds, the next block is
+ * already in flight to it, so nothing is replicated.
+ *
+ * DIST_SUMMA: a pr x pc grid with a block-cyclic layout of nb x nb
+ * blocks. For each k block, its owners broadcast the A panel along grid
+ * rows and the B panel along grid columns; the next panels are
+ * broadcast (MPI_Ibcast) while mm_acc_mt adds the current ones into C.
+ */
+typedef enum { DIST_1D, DIST_SUMMA } DistLayout;
+
+typedef struct {
+    DistLayout layout;
+    size_t nb;              /* SUMMA block size; 0 = DIST_NB */
+    int sweep;              /* also time 1, 2, 4, ... ranks: strong and weak scaling rows */
+    BenchOpts bo;           /* reps == 0: calibrated once for all ranks */
+    const char *out_base;
+    DType dt;
+    const char *dtype;      /* dtype and format columns of the report rows */
+    const char *fmt;
+} DistOpts;
+
+#define DIST_NB 256
+
+/* MPI_Init_thread (funneled) and MPI_Finalize; dist_rank is 0 before init. */
+int  dist_init(int *argc, char ***argv);
+void dist_finalize(void);
+int  dist_rank(void);
+int  dist_size(void);
+
+/*
+ * C = A * B or y = A * x on every rank of the run, from the FMT_BIN or
+ * FMT_CHUNK inputs. Rank 0 reports one row per rank count: strong
+ * scaling on the full problem and, with o->sweep, weak scaling with A's
+ * rows cut to m * ranks / P. 0 on success, -1 on error, 2 if interrupted.
+ */
+int dist_mm(const char *Apath, const char *Bpath, const DistOpts *o, KCfg cfg);
+int dist_mv(const char *Apath, const char *xpath, const DistOpts *o, KCfg cfg);
+
+#endif
@@ -0,0 +1,572 @@
+#include "gemm.h"
+#include "simd.h"
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+extern volatile sig_atomic_t g_stop;
+
+#define GEMM_ALIGN 64
+
+static inline size_t min_sz(size_t a, size_t b) { return a < b ? a : b; }
+static inline size_t round_up(size_t x, size_t m) { return (x + m - 1) / m * m; }
+
+/* Packing buffers come from the arena, so repeated calls reuse them. */
+static double *abuf(size_t n) {
+    size_t bytes = round_up(n * sizeof(double), GEMM_ALIGN);
+    return (double*)arena_get(bytes ? bytes : GEMM_ALIGN, 0);
+}
+
+/*
+ * op(A)[i0:i0+mb, k0:k0+kb] into MR-row micro-panels, k-major, zero
+ * padded. With TR_T the panel is read from A's columns, so the transpose
+ * costs nothing beyond the packing pass that runs anyway.
+ */
+static void pack_a(const Mat *A, Trans ta, size_t i0, size_t mb, size_t k0, size_t kb,
+                   size_t MR, double *dst) {
+    const size_t lda = A->ld;
+    /* Element (r, k) of the panel is src[r * rs + k * ks]. */
+    const size_t rs = ta == TR_T ? 1 : lda, ks = ta == TR_T ? lda : 1;
+    for (size_t ir = 0; ir < mb; ir += MR) {
+        size_t mr = min_sz(MR, mb - ir);
+        const double *src = &A->data[(i0 + ir) * rs + k0 * ks];
+        for (size_t k = 0; k < kb; k++) {
+            size_t r = 0;
+            for (; r < mr; r++) dst[r] = src[r * rs + k * ks];
+            for (; r < MR; r++) dst[r] = 0.0;
+            dst += MR;
+        }
+    }
+}
+
+/* op(B)[k0:k0+kb, j0:j0+nb] into NR-column micro-panels, k-major, zero padded. */
+static void pack_b(const Mat *B, Trans tb, size_t k0, size_t kb, size_t j0, size_t nb,
+                   size_t NR, double *dst) {
+    const size_t ldb = B->ld;
+    /* Element (k, c) of the panel is src[k * ks + c * cs]. */
+    const size_t ks = tb == TR_T ? 1 : ldb, cs = tb == TR_T ? ldb : 1;
+    for (size_t jr = 0; jr < nb; jr += NR) {
+        size_t nr = min_sz(NR, nb - jr);
+        const double *src = &B->data[k0 * ks + (j0 + jr) * cs];
+        for (size_t k = 0; k < kb; k++) {
+            size_t c = 0;
+            for (; c < nr; c++) dst[c] = src[k * ks + c * cs];
+            for (; c < NR; c++) dst[c] = 0.0;
+            dst += NR;
+        }
+    }
+}
+
+typedef struct {
+    const Mat *A;
+    const Mat *B;
+    Mat *C;
+    Trans ta, tb;
+    size_t M;                /* rows of op(A) and C */
+    const SimdOps *ops;
+    size_t mr, nr;           /* micro-kernel tile */
+    size_t mc, kc, nc;
+    size_t jc, nb, pc, kb;   /* current B panel */
+    double *bp;              /* packed B panel, shared */
+    double **ap;             /* packed A block, one per thread */
+    Split split;             /* mc-row blocks of the current B panel */
+} GemmJob;
+
+static void pack_b_worker(void *p, int tid, int nt) {
+    GemmJob *j = (GemmJob*)p;
+    const size_t NR = j->nr;
+    size_t panels = (j->nb + NR - 1) / NR;
+    for (size_t q = (size_t)tid; q < panels; q += (size_t)nt) {
+        size_t jr = q * NR;
+        pack_b(j->B, j->tb, j->pc, j->kb, j->jc + jr, min_sz(NR, j->nb - jr), NR, &j->bp[jr * j->kb]);
+    }
+}
+
+static void macro_kernel(const GemmJob *j, size_t ic, size_t mb, const double *ap) {
+    Mat *C = j->C;
+    const size_t ldc = C->ld;
+    const size_t kb = j->kb;
+    const size_t MR = j->mr, NR = j->nr;
+    void (*ukr)(size_t, const double*, const double*, double*, size_t) = j->ops->ukr;
+    double tmp[SIMD_MAX_MR * SIMD_MAX_NR];
+
+    for (size_t jr = 0; jr < j->nb; jr += NR) {
+        size_t nr = min_sz(NR, j->nb - jr);
+        const double *bp = &j->bp[jr * kb];
+        for (size_t ir = 0; ir < mb; ir += MR) {
+            size_t mr = min_sz(MR, mb - ir);
+            double *c = &C->data[(ic + ir) * ldc + j->jc + jr];
+            if (mr == MR && nr == NR) {
+                ukr(kb, &ap[ir * kb], bp, c, ldc);
+            } else {
+                memset(tmp, 0, sizeof(tmp));
+                ukr(kb, &ap[ir * kb], bp, tmp, NR);
+                for (size_t r = 0; r < mr; r++)
+                    for (size_t s = 0; s < nr; s++) c[r * ldc + s] += tmp[r * NR + s];
+            }
+        }
+    }
+}
+
+static void gemm_worker(void *p, int tid, int nt) {
+    GemmJob *j = (GemmJob*)p;
+    const size_t M = j->M;
+    double *ap = j->ap[tid];
+
+    size_t b0, b1;
+    int taken = 0;
+    while (split_next(&j->split, tid, nt, &taken, &b0, &b1)) {
+        for (size_t b = b0; b < b1; b++) {
+            if (g_stop) return;
+            size_t ic = b * j->mc;
+            size_t mb = min_sz(j->mc, M - ic);
+            pack_a(j->A, j->ta, ic, mb, j->pc, j->kb, j->mr, ap);
+            macro_kernel(j, ic, mb, ap);
+        }
+    }
+}
+
+int gemm_packed(const Mat *A, Trans ta, const Mat *B, Trans tb, Mat *C, KCfg cfg) {
+    const size_t M = C->rows, N = C->cols, K = ta == TR_T ? A->rows : A->cols;
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+    if (cfg.pool && nt > pool_size(cfg.pool)) nt = pool_size(cfg.pool);
+    if (nt > POOL_MAX_THREADS) nt = POOL_MAX_THREADS;
+
+    const SimdOps *ops = simd_ops();
+    const size_t MR = (size_t)ops->mr, NR = (size_t)ops->nr;
+    size_t mc = cfg.mc > 0 ? (size_t)cfg.mc : GEMM_MC;
+    size_t kc = cfg.kc > 0 ? (size_t)cfg.kc : GEMM_KC;
+    size_t nc = cfg.nc > 0 ? (size_t)cfg.nc : GEMM_NC;
+    mc = round_up(mc, MR);
+    nc = round_up(nc, NR);
+    /* Keep every thread busy when M is small relative to mc * nt. */
+    if ((M + mc - 1) / mc < (size_t)nt) mc = round_up((M + (size_t)nt - 1) / (size_t)nt, MR);
+    kc = min_sz(kc, K);
+    nc = min_sz(nc, round_up(N, NR));
+
+    GemmJob job = { .A=A, .B=B, .C=C, .ta=ta, .tb=tb, .M=M, .ops=ops, .mr=MR, .nr=NR,
+                    .mc=mc, .kc=kc, .nc=nc };
+    const size_t blocks = (M + mc - 1) / mc;
+    double *ap[POOL_MAX_THREADS] = {0};
+    job.bp = abuf(kc * nc);
+    job.ap = ap;
+    int rc = job.bp ? 0 : -1;
+    for (int t = 0; t < nt && rc == 0; t++) {
+        job.ap[t] = abuf(mc * kc);
+        if (!job.ap[t]) rc = -1;
+    }
+
+    for (size_t jc = 0; jc < N && rc == 0 && !g_stop; jc += nc) {
+        job.jc = jc;
+        job.nb = min_sz(nc, N - jc);
+        for (size_t pc = 0; pc < K && !g_stop; pc += kc) {
+            job.pc = pc;
+            job.kb = min_sz(kc, K - pc);
+            split_init(&job.split, blocks, cfg.sched, 1);
+            if (pool_run(cfg.pool, nt, pack_b_worker, &job) < 0 ||
+                pool_run(cfg.pool, nt, gemm_worker, &job) < 0) {
+                rc = -1; break;
+            }
+        }
+    }
+
+    for (int t = 0; t < nt; t++) arena_put(ap[t]);
+    arena_put(job.bp);
+    return rc;
+}
+
+/* ---- recursive, optionally Strassen-Winograd ---------------------------
+ * C is split into independent blocks (tasks) handed out to the pool.
+ * Each task halves its largest dimension until the block fits the leaf
+ * limits, then runs one packed multiply there. Above cfg.strassen,
+ * Winograd's 7-product form replaces the 8 half-size products once per
+ * level; the 7 products of the last level run as one batch of tasks.
+ */
+
+/*
+ * Leaf block: B (kb x nb) is packed once and reused over up to REC_ML
+ * rows of A, packed REC_MB rows at a time (A block in L2, B in L2/L3).
+ */
+#define REC_MB 128
+#define REC_ML 512
+#define REC_KB 256
+#define REC_NB 256
+#define REC_MAX_LEVELS 8
+#define REC_MIN_STRASSEN 16   /* smallest dimension a Winograd level is ever applied to */
+
+typedef struct { Mat A, B, C; } RecTask;
+
+typedef struct {
+    const SimdOps *ops;
+    size_t mr, nr;
+    KCfg cfg;
+    int nt;
+    double *ap[POOL_MAX_THREADS], *bp[POOL_MAX_THREADS];   /* per-thread leaf packing buffers */
+    RecTask *task;
+    size_t ntask, cap;
+    Split split;
+} RecCtx;
+
+/* C += A * B for one leaf block. */
+static void rec_leaf(const RecCtx *x, int tid, const Mat *A, const Mat *B, Mat *C) {
+    const size_t m = A->rows, k = A->cols, n = B->cols;
+    if (!m || !k || !n) return;
+    GemmJob j = { .A=A, .B=B, .C=C, .M=m, .ops=x->ops, .mr=x->mr, .nr=x->nr,
+                  .jc=0, .nb=n, .pc=0, .kb=k, .bp=x->bp[tid] };
+    for (size_t jr = 0; jr < n; jr += x->nr)
+        pack_b(B, TR_N, 0, k, jr, min_sz(x->nr, n - jr), x->nr, &j.bp[jr * k]);
+    for (size_t ic = 0; ic < m; ic += REC_MB) {
+        size_t mb = min_sz(REC_MB, m - ic);
+        pack_a(A, TR_N, ic, mb, 0, k, x->mr, x->ap[tid]);
+        macro_kernel(&j, ic, mb, x->ap[tid]);
+    }
+}
+
+/* Serial cache-oblivious C += A * B: halve the dimension furthest past its leaf limit. */
+static void rec_mul(const RecCtx *x, int tid, const Mat *A, const Mat *B, Mat *C) {
+    const size_t m = A->rows, k = A->cols, n = B->cols;
+    if (g_stop) return;
+    if (m <= REC_ML && k <= REC_KB && n <= REC_NB) {
+        rec_leaf(x, tid, A, B, C);
+        return;
+    }
+    double rm = (double)m / REC_ML, rk = (double)k / REC_KB, rn = (double)n / REC_NB;
+    if (rm >= rk && rm >= rn) {
+        size_t h = round_up(m / 2, x->mr);
+        Mat A0 = m_view(A, 0, 0, h, k), A1 = m_view(A, h, 0, m - h, k);
+        Mat C0 = m_view(C, 0, 0, h, n), C1 = m_view(C, h, 0, m - h, n);
+        rec_mul(x, tid, &A0, B, &C0);
+        rec_mul(x, tid, &A1, B, &C1);
+    } else if (rn >= rk) {
+        size_t h = round_up(n / 2, x->nr);
+        Mat B0 = m_view(B, 0, 0, k, h), B1 = m_view(B, 0, h, k, n - h);
+        Mat C0 = m_view(C, 0, 0, m, h), C1 = m_view(C, 0, h, m, n - h);
+        rec_mul(x, tid, A, &B0, &C0);
+        rec_mul(x, tid, A, &B1, &C1);
+    } else {
+        size_t h = k / 2;
+        Mat A0 = m_view(A, 0, 0, m, h), A1 = m_view(A, 0, h, m, k - h);
+        Mat B0 = m_view(B, 0, 0, h, n), B1 = m_view(B, h, 0, k - h, n);
+        rec_mul(x, tid, &A0, &B0, C);
+        rec_mul(x, tid, &A1, &B1, C);
+    }
+}
+
+static void rec_worker(void *p, int tid, int nt) {
+    RecCtx *x = (RecCtx*)p;
+    size_t t0, t1;
+    int taken = 0;
+    while (!g_stop && split_next(&x->split, tid, nt, &taken, &t0, &t1)) {
+        for (size_t t = t0; t < t1; t++) {
+            RecTask *r = &x->task[t];
+            rec_mul(x, tid, &r->A, &r->B, &r->C);
+        }
+    }
+}
+
+static int rec_push(RecCtx *x, Mat A, Mat B, Mat C) {
+    if (x->ntask == x->cap) {
+        size_t cap = x->cap ? 2 * x->cap : 64;
+        RecTask *t = (RecTask*)arena_get(cap * sizeof(RecTask), 0);
+        if (!t) return -1;
+        if (x->ntask) memcpy(t, x->task, x->ntask * sizeof(RecTask));
+        arena_put(x->task);
+        x->task = t; x->cap = cap;
+    }
+    x->task[x->ntask++] = (RecTask){ A, B, C };
+    return 0;
+}
+
+/* Queues C += A * B as a grid of at least min_tasks C blocks, where big enough. */
+static int rec_product(RecCtx *x, const Mat *A, const Mat *B, Mat *C, size_t min_tasks) {
+    const size_t m = A->rows, k = A->cols, n = B->cols;
+    if (!m || !k || !n) return 0;
+    size_t gm = 1, gn = 1;
+    while (gm * gn < min_tasks) {
+        if (m / gm >= n / gn && m / gm >= 2 * REC_MB) gm *= 2;
+        else if (n / gn >= 2 * REC_NB) gn *= 2;
+        else if (m / gm >= 2 * REC_MB) gm *= 2;
+        else break;
+    }
+    for (size_t bi = 0; bi < gm; bi++) {
+        size_t i0, i1;
+        row_range(m, (int)bi, (int)gm, &i0, &i1);
+        for (size_t bj = 0; bj < gn; bj++) {
+            size_t j0, j1;
+            row_range(n, (int)bj, (int)gn, &j0, &j1);
+            if (rec_push(x, m_view(A, i0, 0, i1 - i0, k), m_view(B, 0, j0, k, j1 - j0),
+                         m_view(C, i0, j0, i1 - i0, j1 - j0)) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+static int rec_run(RecCtx *x) {
+    split_init(&x->split, x->ntask, x->cfg.sched, 1);
+    int rc = x->ntask ? pool_run(x->cfg.pool, x->nt, rec_worker, x) : 0;
+    x->ntask = 0;
+    return rc < 0 ? -1 : 0;
+}
+
+typedef struct {
+    Mat *Z;
+    const Mat *X, *Y;
+    double s;
+    const SimdOps *ops;
+} MaddJob;
+
+static void madd_worker(void *p, int tid, int nt) {
+    MaddJob *j = (MaddJob*)p;
+    size_t i0, i1;
+    row_range(j->Z->rows, tid, nt, &i0, &i1);
+    const size_t n = j->Z->cols;
+    const double s = j->s;
+    for (size_t i = i0; i < i1; i++) {
+        double *z = &j->Z->data[i * j->Z->ld];
+        const double *xr = &j->X->data[i * j->X->ld];
+        if (!j->Y) {
+            j->ops->axpy(1.0, xr, z, n);
+            continue;
+        }
+        /* One pass: this is bandwidth-bound, and two axpy calls would stream z twice. */
+        const double *yr = &j->Y->data[i * j->Y->ld];
+        for (size_t c = 0; c < n; c++) z[c] += xr[c] + s * yr[c];
+    }
+}
+
+/* Z += X + s * Y (Y may be NULL) */
+static int madd(const RecCtx *x, Mat *Z, const Mat *X, double s, const Mat *Y) {
+    MaddJob j = { Z, X, Y, s, x->ops };
+    return pool_run(x->cfg.pool, x->nt, madd_worker, &j) < 0 ? -1 : 0;
+}
+
+static int sw_mul(RecCtx *x, const Mat *A, const Mat *B, Mat *C, int depth);
+
+/* One Winograd level on the even part of A and B, then classic fix-ups for odd edges. */
+static int sw_level(RecCtx *x, const Mat *A, const Mat *B, Mat *C, int depth) {
+    const size_t m = A->rows, k = A->cols, n = B->cols;
+    const size_t h = m / 2, kh = k / 2, nh = n / 2;
+    const size_t m2 = 2 * h, k2 = 2 * kh, n2 = 2 * nh;
+
+    Mat A11 = m_view(A, 0, 0, h, kh), A12 = m_view(A, 0, kh, h, kh);
+    Mat A21 = m_view(A, h, 0, h, kh), A22 = m_view(A, h, kh, h, kh);
+    Mat B11 = m_view(B, 0, 0, kh, nh), B12 = m_view(B, 0, nh, kh, nh);
+    Mat B21 = m_view(B, kh, 0, kh, nh), B22 = m_view(B, kh, nh, kh, nh);
+    Mat C11 = m_view(C, 0, 0, h, nh), C12 = m_view(C, 0, nh, h, nh);
+    Mat C21 = m_view(C, h, 0, h, nh), C22 = m_view(C, h, nh, h, nh);
+
+    /* Zeroed temporaries: S = A-side sums, T = B-side sums, P = the 7 products. */
+    Mat S[4], T[4], P[7];
+    int rc = 0;
+    for (int i = 0; i < 4; i++) { S[i] = m_alloc_arena(h, kh, DT_F64); T[i] = m_alloc_arena(kh, nh, DT_F64); }
+    for (int i = 0; i < 7; i++) P[i] = m_alloc_arena(h, nh, DT_F64);
+    for (int i = 0; i < 4; i++) if (!S[i].data || !T[i].data) rc = -1;
+    for (int i = 0; i < 7; i++) if (!P[i].data) rc = -1;
+
+    if (rc == 0) {
+        rc |= madd(x, &S[0], &A21, 1.0, &A22);
+        rc |= madd(x, &S[1], &S[0], -1.0, &A11);
+        rc |= madd(x, &S[2], &A11, -1.0, &A21);
+        rc |= madd(x, &S[3], &A12, -1.0, &S[1]);
+        rc |= madd(x, &T[0], &B12, -1.0, &B11);
+        rc |= madd(x, &T[1], &B22, -1.0, &T[0]);
+        rc |= madd(x, &T[2], &B22, -1.0, &B12);
+        rc |= madd(x, &T[3], &T[1], -1.0, &B21);
+    }
+    if (rc == 0) {
+        const Mat *L[7] = { &A11, &A12, &S[3], &A22, &S[0], &S[1], &S[2] };
+        const Mat *R[7] = { &B11, &B21, &B22, &T[3], &T[0], &T[1], &T[2] };
+        size_t per = ((size_t)x->nt * 4 + 6) / 7;
+        for (int i = 0; i < 7 && rc == 0 && !g_stop; i++) {
+            rc = depth > 1 ? sw_mul(x, L[i], R[i], &P[i], depth - 1)
+                           : rec_product(x, L[i], R[i], &P[i], per);
+        }
+        if (rc == 0 && depth == 1) rc = rec_run(x);
+        x->ntask = 0;
+    }
+    if (rc == 0 && !g_stop) {
+        /* C11 = P1+P2, C12 = P1+P6+P5+P3, C21 = P1+P6+P7-P4, C22 = P1+P6+P7+P5 */
+        rc |= madd(x, &C11, &P[0], 1.0, &P[1]);
+        rc |= madd(x, &P[0], &P[5], 0.0, NULL);
+        rc |= madd(x, &P[6], &P[0], 0.0, NULL);
+        rc |= madd(x, &P[0], &P[4], 0.0, NULL);
+        rc |= madd(x, &C12, &P[0], 1.0, &P[2]);
+        rc |= madd(x, &C21, &P[6], -1.0, &P[3]);
+        rc |= madd(x, &C22, &P[6], 1.0, &P[4]);
+    }
+    for (int i = 0; i < 4; i++) { m_free(&S[i]); m_free(&T[i]); }
+    for (int i = 0; i < 7; i++) m_free(&P[i]);
+    if (rc != 0 || g_stop) return rc;
+
+    /* Disjoint edge blocks: the odd k slice, then the odd column, then the odd row. */
+    size_t per = (size_t)x->nt * 2;
+    if (k2 < k) {
+        Mat a = m_view(A, 0, k2, m2, 1), b = m_view(B, k2, 0, 1, n2), c = m_view(C, 0, 0, m2, n2);
+        rc |= rec_product(x, &a, &b, &c, per);
+    }
+    if (n2 < n) {
+        Mat a = m_view(A, 0, 0, m2, k), b = m_view(B, 0, n2, k, 1), c = m_view(C, 0, n2, m2, 1);
+        rc |= rec_product(x, &a, &b, &c, per);
+    }
+    if (m2 < m) {
+        Mat a = m_view(A, m2, 0, 1, k), c = m_view(C, m2, 0, 1, n);
+        rc |= rec_product(x, &a, B, &c, per);
+    }
+    if (rc == 0) rc = rec_run(x);
+    x->ntask = 0;
+    return rc;
+}
+
+static int sw_mul(RecCtx *x, const Mat *A, const Mat *B, Mat *C, int depth) {
+    if (depth > 0) return sw_level(x, A, B, C, depth);
+    if (rec_product(x, A, B, C, (size_t)x->nt * 4) != 0) return -1;
+    return rec_run(x);
+}
+
+int gemm_recursive(const Mat *A, const Mat *B, Mat *C, KCfg cfg) {
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+    if (cfg.pool && nt > pool_size(cfg.pool)) nt = pool_size(cfg.pool);
+    if (nt > POOL_MAX_THREADS) nt = POOL_MAX_THREADS;
+
+    const SimdOps *ops = simd_ops();
+    RecCtx x = { .ops=ops, .mr=(size_t)ops->mr, .nr=(size_t)ops->nr, .cfg=cfg, .nt=nt };
+    int levels = 0;
+    size_t d = min_sz(A->rows, min_sz(A->cols, B->cols));
+    while (cfg.strassen > 0 && d >= (size_t)cfg.strassen && d >= REC_MIN_STRASSEN &&
+           levels < REC_MAX_LEVELS) {
+        levels++;
+        d /= 2;
+    }
+
+    int rc = 0;
+    for (int t = 0; t < nt && rc == 0; t++) {
+        x.ap[t] = abuf(round_up(REC_MB, x.mr) * REC_KB);
+        x.bp[t] = abuf(REC_KB * round_up(REC_NB, x.nr));
+        if (!x.ap[t] || !x.bp[t]) rc = -1;
+    }
+    if (rc == 0) rc = sw_mul(&x, A, B, C, levels);
+
+    for (int t = 0; t < nt; t++) {
+        arena_put(x.ap[t]);
+        arena_put(x.bp[t]);
+    }
+    arena_put(x.task);
+    return rc;
+}
+
+/* ---- SYRK --------------------------------------------------------------
+ * C = op(A) * op(A)^T for the stored triangle only. C is cut into
+ * SYRK_NB-square tiles and only the T(T+1)/2 tiles on the lower side of
+ * the diagonal are multiplied, about half the flops of a full product.
+ * As in gemm_packed, K is stepped kc at a time: every row block of op(A)
+ * is packed once per step, as A panels and as B panels, and then the
+ * tiles run from those. Each tile is built in a per-thread scratch block
+ * and added into the packed rows of C (transposed for UPLO_U).
+ */
+#define SYRK_NB 128
+
+typedef struct {
+    const Mat *A;
+    Trans ta;
+    Tri *C;
+    const SimdOps *ops;
+    size_t mr, nr, kc, K, T;
+    size_t pc, kb;             /* current K step */
+    double *ap, *bp;           /* row block b at b * astride / b * bstride, shared */
+    size_t astride, bstride;
+    double *ct[POOL_MAX_THREADS];
+    Split split;               /* tiles, row by row over the lower triangle of tiles */
+} SyrkJob;
+
+static void syrk_pack_worker(void *p, int tid, int nt) {
+    SyrkJob *s = (SyrkJob*)p;
+    const size_t n = s->C->n;
+    /* op(A)^T as the B operand is A read under the opposite flag. */
+    const Trans tb = s->ta == TR_T ? TR_N : TR_T;
+    for (size_t q = (size_t)tid; q < 2 * s->T; q += (size_t)nt) {
+        const size_t b = q % s->T, i0 = b * SYRK_NB, mb = min_sz(SYRK_NB, n - i0);
+        if (q < s->T) {
+            pack_a(s->A, s->ta, i0, mb, s->pc, s->kb, s->mr, &s->ap[b * s->astride]);
+            continue;
+        }
+        double *dst = &s->bp[b * s->bstride];
+        for (size_t jr = 0; jr < mb; jr += s->nr)
+            pack_b(s->A, tb, s->pc, s->kb, i0 + jr, min_sz(s->nr, mb - jr), s->nr, &dst[jr * s->kb]);
+    }
+}
+
+static void syrk_tile(const SyrkJob *s, int tid, size_t bi, size_t bj) {
+    const size_t n = s->C->n, i0 = bi * SYRK_NB, j0 = bj * SYRK_NB;
+    const size_t mb = min_sz(SYRK_NB, n - i0), nb = min_sz(SYRK_NB, n - j0);
+    Mat ct = { .rows = mb, .cols = nb, .data = s->ct[tid], .ld = SYRK_NB, .dt = DT_F64, .mem = MEM_VIEW };
+    memset(ct.data, 0, mb * SYRK_NB * sizeof(double));
+    GemmJob j = { .C=&ct, .M=mb, .ops=s->ops, .mr=s->mr, .nr=s->nr, .jc=0, .nb=nb,
+                  .pc=s->pc, .kb=s->kb, .bp=&s->bp[bj * s->bstride] };
+    macro_kernel(&j, 0, mb, &s->ap[bi * s->astride]);
+
+    Tri *C = s->C;
+    double *c = C->v.data;
+    const int first = s->pc == 0;
+    for (size_t r = 0; r < mb; r++) {
+        const size_t i = i0 + r, w = bi == bj ? r + 1 : nb;
+        const double *src = &ct.data[r * SYRK_NB];
+        for (size_t q = 0; q < w; q++) {
+            const size_t e = C->uplo == UPLO_L ? tri_row(C, i) + j0 + q : tri_row(C, j0 + q) + i - (j0 + q);
+            c[e] = first ? src[q] : c[e] + src[q];
+        }
+    }
+}
+
+static void syrk_worker(void *p, int tid, int nt) {
+    SyrkJob *s = (SyrkJob*)p;
+    size_t t0, t1;
+    int taken = 0;
+    while (split_next(&s->split, tid, nt, &taken, &t0, &t1)) {
+        size_t bi = 0;
+        while ((bi + 1) * (bi + 2) / 2 <= t0) bi++;
+        size_t bj = t0 - bi * (bi + 1) / 2;
+        for (size_t t = t0; t < t1; t++) {
+            if (g_stop) return;
+            syrk_tile(s, tid, bi, bj);
+            if (++bj > bi) { bi++; bj = 0; }
+        }
+    }
+}
+
+int gemm_syrk(const Mat *A, Trans ta, Tri *C, KCfg cfg) {
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+    if (cfg.pool && nt > pool_size(cfg.pool)) nt = pool_size(cfg.pool);
+    if (nt > POOL_MAX_THREADS) nt = POOL_MAX_THREADS;
+
+    const SimdOps *ops = simd_ops();
+    SyrkJob s = { .A=A, .ta=ta, .C=C, .ops=ops, .mr=(size_t)ops->mr, .nr=(size_t)ops->nr,
+                  .K = ta == TR_T ? A->rows : A->cols, .T = (C->n + SYRK_NB - 1) / SYRK_NB };
+    s.kc = min_sz(cfg.kc > 0 ? (size_t)cfg.kc : GEMM_KC, s.K);
+    if (s.kc == 0) {
+        memset(C->v.data, 0, C->v.len * sizeof(double));
+        return 0;
+    }
+    s.astride = round_up(SYRK_NB, s.mr) * s.kc;
+    s.bstride = round_up(SYRK_NB, s.nr) * s.kc;
+    s.ap = abuf(s.T * s.astride);
+    s.bp = abuf(s.T * s.bstride);
+    int rc = s.ap && s.bp ? 0 : -1;
+    for (int t = 0; t < nt && rc == 0; t++) {
+        s.ct[t] = abuf(SYRK_NB * SYRK_NB);
+        if (!s.ct[t]) rc = -1;
+    }
+
+    for (size_t pc = 0; pc < s.K && rc == 0 && !g_stop; pc += s.kc) {
+        s.pc = pc;
+        s.kb = min_sz(s.kc, s.K - pc);
+        split_init(&s.split, s.T * (s.T + 1) / 2, cfg.sched, 1);
+        if (pool_run(cfg.pool, nt, syrk_pack_worker, &s) < 0 ||
+            pool_run(cfg.pool, nt, syrk_worker, &s) < 0) rc = -1;
+    }
+
+    for (int t = 0; t < nt; t++) arena_put(s.ct[t]);
+    arena_put(s.ap);
+    arena_put(s.bp);
+    return rc;
+}
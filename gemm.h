@@ -0,0 +1,33 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include "kernels.h"
+
+/* Default cache blocking, in elements: A block mc x kc fits L2, B panel kc x nc fits L3. */
+#define GEMM_MC 128
+#define GEMM_KC 256
+#define GEMM_NC 4096
+
+/*
+ * C += op(A) * op(B) through packed A/B panels and an MR x NR
+ * register-blocked micro-kernel; the packing reads transposed operands
+ * in place. Shapes are assumed checked by the caller.
+ */
+int gemm_packed(const Mat *A, Trans ta, const Mat *B, Trans tb, Mat *C, KCfg cfg);
+
+/*
+ * C += A * B (untransposed only) by cache-oblivious recursion down to packed leaf blocks,
+ * with one Strassen-Winograd level per halving while the smallest
+ * dimension is >= cfg.strassen (0: never). Strassen trades 1/8 of the
+ * flops per level for larger rounding error; see the mm accuracy line.
+ */
+int gemm_recursive(const Mat *A, const Mat *B, Mat *C, KCfg cfg);
+
+/*
+ * C = op(A) * op(A)^T into the packed triangle C (f64). Only the square
+ * tiles on one side of the diagonal are computed; threads split the tile
+ * list by count, so the triangular work stays balanced.
+ */
+int gemm_syrk(const Mat *A, Trans ta, Tri *C, KCfg cfg);
+
+#endif
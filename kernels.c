@@ -1,99 +1,654 @@
 #include "kernels.h"
-#include <pthread.h>
+#include "gemm.h"
+#include "simd.h"
+#include "arena.h"
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 
 extern volatile sig_atomic_t g_stop;
 
-static void row_range(size_t nrows, int tid, int nt, size_t *i0, size_t *i1) {
-    size_t base = nrows / (size_t)nt;
-    size_t rem  = nrows % (size_t)nt;
-    size_t start = (size_t)tid * base + (size_t)((tid < (int)rem) ? tid : rem);
-    size_t extra = (tid < (int)rem) ? 1u : 0u;
-    size_t end = start + base + extra;
-    *i0 = start; *i1 = end;
+/* Elements (or rows, for mv) handled between checks of g_stop. */
+#define STOP_CHUNK 16384
+#define STOP_ROWS  64
+
+/* Default SCHED_DYNAMIC grain: an mm row is K*N flops, so a few suffice. */
+#define MM_CHUNK_ROWS 4
+
+static inline size_t grain(const KCfg *cfg, size_t def) {
+    return cfg->chunk > 0 ? (size_t)cfg->chunk : def;
+}
+
+/* y[i:i+m] = A[i:i+m, :] . x, writing to out (y's storage or a scratch block). */
+static inline void mv_block(const SimdOps *ops, Accum acc, const Mat *A, const Vec *x,
+                            void *out, size_t i, size_t m) {
+    const size_t n = A->cols, lda = A->ld;
+    if (A->dt == DT_F64) ops->mv(&A->data[i * lda], lda, x->data, (double*)out, m, n);
+    else if (acc == ACC_F64) ops->dsmv(&A->f32[i * lda], lda, x->f32, (float*)out, m, n);
+    else ops->smv(&A->f32[i * lda], lda, x->f32, (float*)out, m, n);
+}
+
+/* x[i:i+m] . y[i:i+m] */
+static inline double vdot(const SimdOps *ops, Accum acc, const Vec *x, const Vec *y,
+                          size_t i, size_t m) {
+    if (x->dt == DT_F64) return ops->dot(&x->data[i], &y->data[i], m);
+    if (acc == ACC_F64) return ops->dsdot(&x->f32[i], &y->f32[i], m);
+    return ops->sdot(&x->f32[i], &y->f32[i], m);
+}
+
+/* Address of element i of v. */
+static inline void *vat(const Vec *v, size_t i) {
+    return v->dt == DT_F32 ? (void*)&v->f32[i] : (void*)&v->data[i];
+}
+
+static inline size_t min_sz(size_t a, size_t b) { return a < b ? a : b; }
+
+/*
+ * Touches the first line of each of rows [r0, r1), which are lda
+ * elements of esz bytes apart. A row usually starts a new page, so the
+ * TLB walk and the first miss happen early; the hardware prefetcher
+ * follows the rest of the row but does not cross into the next page.
+ */
+static inline void prefetch_rows(const void *base, size_t lda, size_t esz, size_t r0, size_t r1) {
+    for (size_t r = r0; r < r1; r++) __builtin_prefetch((const char*)base + r * lda * esz, 0, 0);
 }
 
 
+/* y at least this large is written with non-temporal stores: it will not be reread from cache. */
+#define NT_MIN_BYTES ((size_t)8 << 20)
+
 typedef struct {
     const Mat *A;
     const Vec *x;
     Vec *y;
-    int tid, nt;
+    const SimdOps *ops;
+    Accum acc;
+    Reduce red;
+    int stream;     /* compute each block into a buffer, then stream it to y */
+    size_t pf;      /* prefetch rows this far ahead of the block being computed */
+    Split split;
 } MVJob;
 
-static void* mv_worker(void *p) {
+/* RED_REPRO: one dot per row, so a row's sum does not depend on the rows sharing its pass. */
+static void mv_repro(const MVJob *j, void *out, size_t i, size_t m) {
+    const Mat *A = j->A;
+    const size_t n = A->cols, lda = A->ld;
+    for (size_t r = 0; r < m; r++) {
+        const size_t row = (i + r) * lda;
+        if (A->dt == DT_F64) ((double*)out)[r] = j->ops->dot(&A->data[row], j->x->data, n);
+        else if (j->acc == ACC_F64) ((float*)out)[r] = (float)j->ops->dsdot(&A->f32[row], j->x->f32, n);
+        else ((float*)out)[r] = j->ops->sdot(&A->f32[row], j->x->f32, n);
+    }
+}
+
+static void mv_worker(void *p, int tid, int nt) {
     MVJob *j = (MVJob*)p;
+    union { double d[STOP_ROWS]; float f[STOP_ROWS]; } t;
+    const size_t esz = dt_size(j->y->dt);
     size_t i0, i1;
-    row_range(j->A->rows, j->tid, j->nt, &i0, &i1);
+    int taken = 0;
+    while (split_next(&j->split, tid, nt, &taken, &i0, &i1)) {
+        for (size_t i = i0; i < i1; i += STOP_ROWS) {
+            if (g_stop) return;
+            size_t m = min_sz(i1 - i, STOP_ROWS);
+            if (j->pf && i + j->pf < j->A->rows)
+                prefetch_rows(j->A->data, j->A->ld, esz, i + j->pf, min_sz(i + j->pf + m, j->A->rows));
+            void *out = j->stream ? (void*)&t : vat(j->y, i);
+            if (j->red == RED_REPRO) mv_repro(j, out, i, m);
+            else mv_block(j->ops, j->acc, j->A, j->x, out, i, m);
+            if (j->stream) j->ops->stream(vat(j->y, i), &t, m * esz);
+        }
+    }
+}
 
-    const size_t n = j->A->cols;
-    for (size_t i = i0; i < i1; i++) {
-        if (g_stop) break;
-        double sum = 0.0;
-        const double *row = &j->A->data[i * n];
-        for (size_t k = 0; k < n; k++) sum += row[k] * j->x->data[k];
-        j->y->data[i] = sum;
+/* A^T x, RED_REPRO: columns per pass, accumulated on the stack so a row slice is read once per pass. */
+#define MVT_COLS 512
+
+typedef struct {
+    const Mat *A;
+    const Vec *x;
+    Vec *y;
+    const SimdOps *ops;
+    Accum acc;
+    int wide;           /* partials and column sums in double (DT_F64 or ACC_F64) */
+    void *part;         /* RED_FAST: one partial y per thread, pstride elements apart */
+    size_t pstride;
+    int np;             /* threads that wrote a partial */
+    Split split;        /* rows of A (RED_FAST), or columns (RED_REPRO) */
+} MVTJob;
+
+/* p[0:n] += a * A[i, c0:c0+n], in the accumulator type of the job. */
+static inline void mvt_axpy(const MVTJob *j, size_t i, size_t c0, size_t n, void *p) {
+    const Mat *A = j->A;
+    const size_t at = i * A->ld + c0;
+    if (A->dt == DT_F64) {
+        j->ops->axpy(j->x->data[i], &A->data[at], (double*)p, n);
+    } else if (j->wide) {
+        const double a = (double)j->x->f32[i];
+        const float *r = &A->f32[at];
+        double *d = (double*)p;
+        for (size_t c = 0; c < n; c++) d[c] += a * (double)r[c];
+    } else {
+        j->ops->saxpy(j->x->f32[i], &A->f32[at], (float*)p, n);
+    }
+}
+
+/* RED_FAST: each thread sums x[i] * A[i, :] over its rows into its own partial. */
+static void mvt_rows_worker(void *p, int tid, int nt) {
+    MVTJob *j = (MVTJob*)p;
+    const size_t n = j->A->cols, pesz = j->wide ? sizeof(double) : sizeof(float);
+    char *part = (char*)j->part + (size_t)tid * j->pstride * pesz;
+    memset(part, 0, n * pesz);
+    size_t i0, i1;
+    int taken = 0;
+    while (split_next(&j->split, tid, nt, &taken, &i0, &i1)) {
+        for (size_t i = i0; i < i1; i++) {
+            if (g_stop) return;
+            mvt_axpy(j, i, 0, n, part);
+        }
     }
-    return NULL;
 }
 
-int mv_mt(const Mat *A, const Vec *x, Vec *y, KCfg cfg) {
+/* Then y[c] = sum of the partials in thread order, by line-aligned column ranges. */
+static void mvt_sum_worker(void *p, int tid, int nt) {
+    MVTJob *j = (MVTJob*)p;
+    const size_t esz = dt_size(j->y->dt);
+    size_t c0, c1;
+    row_range_al(j->y->len, pool_line_unit(esz), tid, nt, &c0, &c1);
+    if (c1 <= c0) return;
+    if (j->y->dt == DT_F64) {
+        const double *part = (const double*)j->part;
+        memcpy(&j->y->data[c0], &part[c0], (c1 - c0) * sizeof(double));
+        for (int t = 1; t < j->np; t++)
+            j->ops->axpy(1.0, &part[(size_t)t * j->pstride + c0], &j->y->data[c0], c1 - c0);
+    } else if (j->wide) {
+        const double *part = (const double*)j->part;
+        for (size_t c = c0; c < c1; c++) {
+            double s = 0.0;
+            for (int t = 0; t < j->np; t++) s += part[(size_t)t * j->pstride + c];
+            j->y->f32[c] = (float)s;
+        }
+    } else {
+        const float *part = (const float*)j->part;
+        memcpy(&j->y->f32[c0], &part[c0], (c1 - c0) * sizeof(float));
+        for (int t = 1; t < j->np; t++)
+            j->ops->saxpy(1.0f, &part[(size_t)t * j->pstride + c0], &j->y->f32[c0], c1 - c0);
+    }
+}
+
+/* RED_REPRO: a thread owns whole columns and adds the rows into them in order. */
+static void mvt_cols_worker(void *p, int tid, int nt) {
+    MVTJob *j = (MVTJob*)p;
+    const size_t m = j->A->rows;
+    union { double d[MVT_COLS]; float f[MVT_COLS]; } acc;
+    size_t c0, c1;
+    int taken = 0;
+    while (split_next(&j->split, tid, nt, &taken, &c0, &c1)) {
+        for (size_t c = c0; c < c1; c += MVT_COLS) {
+            if (g_stop) return;
+            size_t w = min_sz(MVT_COLS, c1 - c);
+            memset(&acc, 0, sizeof(acc));
+            for (size_t i = 0; i < m; i++) mvt_axpy(j, i, c, w, &acc);
+            if (j->y->dt == DT_F64) memcpy(&j->y->data[c], acc.d, w * sizeof(double));
+            else if (j->wide) for (size_t k = 0; k < w; k++) j->y->f32[c + k] = (float)acc.d[k];
+            else memcpy(&j->y->f32[c], acc.f, w * sizeof(float));
+        }
+    }
+}
+
+static int mvt_run(const Mat *A, const Vec *x, Vec *y, KCfg cfg, int nt) {
+    MVTJob job = { .A=A, .x=x, .y=y, .ops=simd_ops(), .acc=cfg.acc,
+                   .wide = A->dt == DT_F64 || cfg.acc == ACC_F64 };
+    const size_t unit = pool_line_unit(dt_size(y->dt));
+    if (cfg.red == RED_REPRO) {
+        split_init(&job.split, A->cols, cfg.sched, grain(&cfg, MVT_COLS));
+        split_align(&job.split, unit);
+        return pool_run(cfg.pool, nt, mvt_cols_worker, &job) < 0 ? -1 : 0;
+    }
+    const size_t pesz = job.wide ? sizeof(double) : sizeof(float);
+    job.pstride = (A->cols + unit - 1) / unit * unit;
+    job.part = arena_get((size_t)nt * job.pstride * pesz, 0);
+    if (!job.part) return -1;
+    split_init(&job.split, A->rows, cfg.sched, grain(&cfg, STOP_ROWS));
+    job.np = pool_run(cfg.pool, nt, mvt_rows_worker, &job);
+    int rc = job.np < 0 ? -1 : 0;
+    if (rc == 0 && !g_stop && pool_run(cfg.pool, job.np, mvt_sum_worker, &job) < 0) rc = -1;
+    arena_put(job.part);
+    return rc;
+}
+
+int mv_mt(const Mat *A, Trans ta, const Vec *x, Vec *y, KCfg cfg) {
     if (!A || !x || !y || !A->data || !x->data || !y->data) return -1;
-    if (A->cols != x->len || A->rows != y->len) return -1;
+    if (x->dt != A->dt || y->dt != A->dt) return -1;
     int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+    if (ta == TR_T) {
+        if (A->rows != x->len || A->cols != y->len) return -1;
+        return mvt_run(A, x, y, cfg, nt);
+    }
+    if (A->cols != x->len || A->rows != y->len) return -1;
+
+    MVJob job = { .A=A, .x=x, .y=y, .ops=simd_ops(), .acc=cfg.acc, .red=cfg.red,
+                  .stream = y->len * dt_size(y->dt) >= NT_MIN_BYTES,
+                  .pf = cfg.pf > 0 ? (size_t)cfg.pf : 0 };
+    split_init(&job.split, A->rows, cfg.sched, grain(&cfg, STOP_ROWS));
+    split_align(&job.split, pool_line_unit(dt_size(y->dt)));
+    return pool_run(cfg.pool, nt, mv_worker, &job) < 0 ? -1 : 0;
+}
+
 
-    pthread_t *ths = (pthread_t*)calloc((size_t)nt, sizeof(pthread_t));
-    MVJob  *jobs = (MVJob*)calloc((size_t)nt, sizeof(MVJob));
-    if (!ths || !jobs) { free(ths); free(jobs); return -1; }
+typedef struct {
+    const Csr *A;
+    const Vec *x;
+    Vec *y;
+    Accum acc;
+    Split split;   /* over nnz + 1: the extra slot picks up trailing empty rows */
+} SpMVJob;
 
-    for (int t = 0; t < nt; t++) {
-        jobs[t] = (MVJob){ .A=A, .x=x, .y=y, .tid=t, .nt=nt };
-        if (pthread_create(&ths[t], NULL, mv_worker, &jobs[t]) != 0) {
-            nt = t; break;
+/* First row whose nonzeros start at or after nonzero k. */
+static size_t row_at(const Csr *A, size_t k) {
+    size_t lo = 0, hi = A->rows;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (A->rowptr[mid] < k) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static void spmv_rows(const SpMVJob *j, size_t r0, size_t r1) {
+    const Csr *A = j->A;
+    const size_t *rp = A->rowptr;
+    const uint32_t *ci = A->colidx;
+    for (size_t i = r0; i < r1; i++) {
+        /* Two chains so the gathered loads of one do not wait on the other's adds. */
+        double s0 = 0.0, s1 = 0.0;
+        size_t k = rp[i], e = rp[i + 1];
+        if (A->dt == DT_F64) {
+            const double *v = A->val, *x = j->x->data;
+            for (; k + 1 < e; k += 2) { s0 += v[k] * x[ci[k]]; s1 += v[k + 1] * x[ci[k + 1]]; }
+            if (k < e) s0 += v[k] * x[ci[k]];
+            j->y->data[i] = s0 + s1;
+        } else if (j->acc == ACC_F64) {
+            const float *v = A->val32, *x = j->x->f32;
+            for (; k + 1 < e; k += 2) {
+                s0 += (double)v[k] * x[ci[k]];
+                s1 += (double)v[k + 1] * x[ci[k + 1]];
+            }
+            if (k < e) s0 += (double)v[k] * x[ci[k]];
+            j->y->f32[i] = (float)(s0 + s1);
+        } else {
+            const float *v = A->val32, *x = j->x->f32;
+            float f0 = 0.0f, f1 = 0.0f;
+            for (; k + 1 < e; k += 2) { f0 += v[k] * x[ci[k]]; f1 += v[k + 1] * x[ci[k + 1]]; }
+            if (k < e) f0 += v[k] * x[ci[k]];
+            j->y->f32[i] = f0 + f1;
         }
     }
-    for (int t = 0; t < nt; t++) pthread_join(ths[t], NULL);
+}
+
+static void spmv_worker(void *p, int tid, int nt) {
+    SpMVJob *j = (SpMVJob*)p;
+    size_t k0, k1;
+    int taken = 0;
+    while (!g_stop && split_next(&j->split, tid, nt, &taken, &k0, &k1)) {
+        size_t r0 = row_at(j->A, k0);
+        size_t r1 = k1 > j->A->nnz ? j->A->rows : row_at(j->A, k1);
+        spmv_rows(j, r0, r1);
+    }
+}
+
+int spmv_mt(const Csr *A, const Vec *x, Vec *y, KCfg cfg) {
+    if (!A || !x || !y || !A->rowptr || !x->data || !y->data) return -1;
+    if (A->cols != x->len || A->rows != y->len) return -1;
+    if (x->dt != A->dt || y->dt != A->dt) return -1;
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+
+    SpMVJob job = { .A=A, .x=x, .y=y, .acc=cfg.acc };
+    split_init(&job.split, A->nnz + 1, cfg.sched, grain(&cfg, STOP_CHUNK));
+    return pool_run(cfg.pool, nt, spmv_worker, &job) < 0 ? -1 : 0;
+}
+
+/* ---- packed triangles ----------------------------------------------------
+ * Row i of a packed triangle holds i + 1 (UPLO_L) or n - i (UPLO_U)
+ * elements, so a row split would give one thread most of the matrix.
+ * Splits run over the packed elements instead; each piece takes the rows
+ * that start inside it.
+ */
 
-    free(ths); free(jobs);
+/* First row whose stored elements start at or after element e. */
+static size_t tri_row_at(const Tri *T, size_t e) {
+    size_t lo = 0, hi = T->n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (tri_row(T, mid) < e) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* Next rows [*r0, *r1) of T from an element split; 0 when done. */
+static int tri_next(const Tri *T, Split *s, int tid, int nt, int *taken, size_t *r0, size_t *r1) {
+    size_t e0, e1;
+    while (split_next(s, tid, nt, taken, &e0, &e1)) {
+        *r0 = tri_row_at(T, e0);
+        *r1 = e1 >= T->v.len ? T->n : tri_row_at(T, e1);
+        if (*r1 > *r0) return 1;
+    }
     return 0;
 }
 
+typedef struct {
+    const Tri *A;
+    const Vec *x;
+    Vec *y;
+    const SimdOps *ops;
+    int wide;           /* f32 with ACC_F64: dots and partials in double */
+    void *part;         /* symv RED_FAST: one partial y per thread, pstride elements apart */
+    size_t pstride;
+    Split split;        /* packed elements; fixed column blocks for symv RED_REPRO */
+} TriJob;
+
+/* sum_q A.v[k + q] * x[c0 + q] for q < w */
+static inline double tri_dot(const TriJob *j, size_t k, size_t c0, size_t w) {
+    const Vec *v = &j->A->v;
+    if (v->dt == DT_F64) return j->ops->dot(&v->data[k], &j->x->data[c0], w);
+    if (j->wide) return j->ops->dsdot(&v->f32[k], &j->x->f32[c0], w);
+    return (double)j->ops->sdot(&v->f32[k], &j->x->f32[c0], w);
+}
+
+/* p[0:w] += x[i] * A.v[k:k+w], p in the accumulator type of the job. */
+static inline void tri_axpy(const TriJob *j, size_t i, size_t k, size_t w, void *p) {
+    const Vec *v = &j->A->v;
+    if (v->dt == DT_F64) {
+        j->ops->axpy(j->x->data[i], &v->data[k], (double*)p, w);
+    } else if (j->wide) {
+        const double a = (double)j->x->f32[i];
+        double *d = (double*)p;
+        for (size_t q = 0; q < w; q++) d[q] += a * (double)v->f32[k + q];
+    } else {
+        j->ops->saxpy(j->x->f32[i], &v->f32[k], (float*)p, w);
+    }
+}
+
+static inline size_t tri_pesz(const TriJob *j) {
+    return j->wide || j->A->v.dt == DT_F64 ? sizeof(double) : sizeof(float);
+}
+
+static inline void part_add(const TriJob *j, void *p, size_t i, double s) {
+    if (tri_pesz(j) == sizeof(double)) ((double*)p)[i] += s;
+    else ((float*)p)[i] += (float)s;
+}
+
+static void trmv_worker(void *p, int tid, int nt) {
+    TriJob *j = (TriJob*)p;
+    const Tri *A = j->A;
+    size_t r0, r1;
+    int taken = 0;
+    while (!g_stop && tri_next(A, &j->split, tid, nt, &taken, &r0, &r1))
+        for (size_t i = r0; i < r1; i++) {
+            size_t k = tri_row(A, i);
+            v_set(j->y, i, tri_dot(j, k, tri_col0(A, i), tri_row(A, i + 1) - k));
+        }
+}
+
+int trmv_mt(const Tri *A, const Vec *x, Vec *y, KCfg cfg) {
+    if (!A || !x || !y || !A->v.data || !x->data || !y->data) return -1;
+    if (A->n != x->len || A->n != y->len) return -1;
+    if (x->dt != A->v.dt || y->dt != A->v.dt) return -1;
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+
+    TriJob job = { .A=A, .x=x, .y=y, .ops=simd_ops(), .wide = A->v.dt == DT_F32 && cfg.acc == ACC_F64 };
+    split_init(&job.split, A->v.len, cfg.sched, grain(&cfg, STOP_CHUNK));
+    return pool_run(cfg.pool, nt, trmv_worker, &job) < 0 ? -1 : 0;
+}
+
+/*
+ * symv RED_FAST: row i adds its dot into y[i] and x[i] times its
+ * off-diagonal part into the mirrored entries, both in the thread's
+ * partial, so the row is read once.
+ */
+static void symv_rows_worker(void *p, int tid, int nt) {
+    TriJob *j = (TriJob*)p;
+    const Tri *A = j->A;
+    const size_t n = A->n, pesz = tri_pesz(j);
+    char *part = (char*)j->part + (size_t)tid * j->pstride * pesz;
+    memset(part, 0, n * pesz);
+    size_t r0, r1;
+    int taken = 0;
+    while (tri_next(A, &j->split, tid, nt, &taken, &r0, &r1)) {
+        for (size_t i = r0; i < r1; i++) {
+            if (g_stop) return;
+            const size_t k = tri_row(A, i);
+            /* Off-diagonal part: columns [0, i) or (i, n); the diagonal is at its end or start. */
+            const size_t c0 = A->uplo == UPLO_L ? 0 : i + 1, w = A->uplo == UPLO_L ? i : n - i - 1;
+            const size_t off = A->uplo == UPLO_L ? k : k + 1, diag = A->uplo == UPLO_L ? k + i : k;
+            part_add(j, part, i, tri_dot(j, off, c0, w) + v_get(&A->v, diag) * v_get(j->x, i));
+            tri_axpy(j, i, off, w, part + c0 * pesz);
+        }
+    }
+}
+
+/*
+ * symv RED_REPRO: a thread owns y[c, c+w) for fixed blocks of
+ * MVT_COLS. Rows add their part of the block in row order and each
+ * owned row adds its full dot, so every sum has one order for any
+ * thread count.
+ */
+static void symv_cols_worker(void *p, int tid, int nt) {
+    TriJob *j = (TriJob*)p;
+    const Tri *A = j->A;
+    const size_t n = A->n, pesz = tri_pesz(j);
+    union { double d[MVT_COLS]; float f[MVT_COLS]; } acc;
+    char *a = (char*)&acc;
+    size_t b0, b1;
+    int taken = 0;
+    while (split_next(&j->split, tid, nt, &taken, &b0, &b1)) {
+        for (size_t b = b0; b < b1; b++) {
+            if (g_stop) return;
+            const size_t c = b * MVT_COLS, w = min_sz(MVT_COLS, n - c);
+            memset(&acc, 0, sizeof(acc));
+            if (A->uplo == UPLO_L) {
+                for (size_t i = c; i < n; i++) {
+                    const size_t k = tri_row(A, i);
+                    if (i >= c + w) { tri_axpy(j, i, k + c, w, a); continue; }
+                    tri_axpy(j, i, k + c, i - c, a);
+                    part_add(j, a, i - c, tri_dot(j, k, 0, i + 1));
+                }
+            } else {
+                for (size_t i = 0; i < c + w; i++) {
+                    const size_t k = tri_row(A, i);
+                    if (i < c) { tri_axpy(j, i, k + c - i, w, a); continue; }
+                    part_add(j, a, i - c, tri_dot(j, k, i, n - i));
+                    tri_axpy(j, i, k + 1, w - (i - c) - 1, a + (i - c + 1) * pesz);
+                }
+            }
+            for (size_t q = 0; q < w; q++)
+                v_set(j->y, c + q, pesz == sizeof(double) ? acc.d[q] : (double)acc.f[q]);
+        }
+    }
+}
+
+int symv_mt(const Tri *A, const Vec *x, Vec *y, KCfg cfg) {
+    if (!A || !x || !y || !A->v.data || !x->data || !y->data) return -1;
+    if (A->n != x->len || A->n != y->len) return -1;
+    if (x->dt != A->v.dt || y->dt != A->v.dt) return -1;
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+
+    TriJob job = { .A=A, .x=x, .y=y, .ops=simd_ops(), .wide = A->v.dt == DT_F32 && cfg.acc == ACC_F64 };
+    if (cfg.red == RED_REPRO) {
+        split_init(&job.split, (A->n + MVT_COLS - 1) / MVT_COLS, cfg.sched, 1);
+        return pool_run(cfg.pool, nt, symv_cols_worker, &job) < 0 ? -1 : 0;
+    }
+    const size_t pesz = tri_pesz(&job), unit = pool_line_unit(dt_size(y->dt));
+    job.pstride = (A->n + unit - 1) / unit * unit;
+    job.part = arena_get((size_t)nt * job.pstride * pesz, 0);
+    if (!job.part) return -1;
+    split_init(&job.split, A->v.len, cfg.sched, grain(&cfg, STOP_CHUNK));
+    int np = pool_run(cfg.pool, nt, symv_rows_worker, &job);
+    int rc = np < 0 ? -1 : 0;
+    /* The partials are summed exactly as mv_mt sums A^T x partials. */
+    MVTJob sum = { .y=y, .ops=job.ops, .wide = pesz == sizeof(double), .part=job.part,
+                   .pstride=job.pstride, .np=np };
+    if (rc == 0 && !g_stop && pool_run(cfg.pool, np, mvt_sum_worker, &sum) < 0) rc = -1;
+    arena_put(job.part);
+    return rc;
+}
+
+typedef struct {
+    const Mat *A;
+    Trans ta;
+    Tri *C;
+    const SimdOps *ops;
+    Accum acc;
+    Split split;   /* packed elements of C */
+} SyrkRowJob;
+
+/* f32 SYRK row i of C: dots of rows of A (TR_N), or axpys of A's rows into the packed row (TR_T). */
+static void syrk_row(const SyrkRowJob *j, size_t i) {
+    const Mat *A = j->A;
+    Tri *C = j->C;
+    const size_t k = tri_row(C, i), c0 = tri_col0(C, i), w = tri_row(C, i + 1) - k;
+    float *c = &C->v.f32[k];
+    if (j->ta == TR_N) {
+        const float *ai = &A->f32[i * A->ld];
+        for (size_t q = 0; q < w; q++) {
+            const float *aj = &A->f32[(c0 + q) * A->ld];
+            c[q] = j->acc == ACC_F64 ? (float)j->ops->dsdot(ai, aj, A->cols) : j->ops->sdot(ai, aj, A->cols);
+        }
+        return;
+    }
+    memset(c, 0, w * sizeof(float));
+    for (size_t r = 0; r < A->rows; r++)
+        j->ops->saxpy(A->f32[r * A->ld + i], &A->f32[r * A->ld + c0], c, w);
+}
+
+static void syrk_rows_worker(void *p, int tid, int nt) {
+    SyrkRowJob *j = (SyrkRowJob*)p;
+    size_t r0, r1;
+    int taken = 0;
+    while (tri_next(j->C, &j->split, tid, nt, &taken, &r0, &r1))
+        for (size_t i = r0; i < r1; i++) {
+            if (g_stop) return;
+            syrk_row(j, i);
+        }
+}
+
+int syrk_mt(const Mat *A, Trans ta, Tri *C, KCfg cfg) {
+    if (!A || !C || !A->data || !C->v.data) return -1;
+    if (C->v.dt != A->dt || C->n != (ta == TR_T ? A->cols : A->rows)) return -1;
+    if (A->dt == DT_F64) return gemm_syrk(A, ta, C, cfg);
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+
+    SyrkRowJob job = { .A=A, .ta=ta, .C=C, .ops=simd_ops(), .acc=cfg.acc };
+    split_init(&job.split, C->v.len, cfg.sched, grain(&cfg, STOP_CHUNK));
+    return pool_run(cfg.pool, nt, syrk_rows_worker, &job) < 0 ? -1 : 0;
+}
 
 typedef struct {
     const Mat *A;
     const Mat *B;
     Mat *C;
-    int tid, nt;
+    Trans ta, tb;
     int tile;
+    const SimdOps *ops;
+    size_t pf;      /* prefetch the B row this many k ahead */
+    Split split;    /* rows of C; columns for A^T B^T */
 } MMJob;
 
-static inline size_t min_sz(size_t a, size_t b) { return a < b ? a : b; }
+/* C[i, c0:c0+len] += op(A)[i, k] * B[k, c0:c0+len] */
+static inline void mm_axpy(const MMJob *j, size_t i, size_t k, size_t c0, size_t len) {
+    const Mat *A = j->A, *B = j->B;
+    Mat *C = j->C;
+    const size_t a = j->ta == TR_T ? k*A->ld + i : i*A->ld + k;
+    if (A->dt == DT_F32)
+        j->ops->saxpy(A->f32[a], &B->f32[k*B->ld + c0], &C->f32[i*C->ld + c0], len);
+    else
+        j->ops->axpy(A->data[a], &B->data[k*B->ld + c0], &C->data[i*C->ld + c0], len);
+}
 
-static void* mm_worker(void *p) {
-    MMJob *j = (MMJob*)p;
-    const Mat *A = j->A;
+/* Pulls B[k, c0:c0+len] into the cache ahead of its mm_axpy; one prefetch per line. */
+static inline void mm_prefetch(const MMJob *j, size_t k, size_t c0, size_t len) {
     const Mat *B = j->B;
+    const size_t esz = dt_size(B->dt);
+    const char *p = (const char*)B->data + (k * B->ld + c0) * esz;
+    for (size_t off = 0; off < len * esz; off += POOL_LINE) __builtin_prefetch(p + off, 0, 3);
+}
+
+/* A B^T: C[i, c] += A[i, k0:k0+len] . B[c, k0:k0+len], both contiguous rows. */
+static void mm_rows_nt(const MMJob *j, size_t i0, size_t i1) {
+    const Mat *A = j->A, *B = j->B;
     Mat *C = j->C;
+    const size_t K = A->cols, N = C->cols;
+    const size_t T = j->tile > 0 ? (size_t)j->tile : (N > K ? N : K);
+    for (size_t i = i0; i < i1; i++) {
+        if (g_stop) break;
+        for (size_t jj = 0; jj < N; jj += T) {
+            size_t jend = min_sz(jj + T, N);
+            for (size_t kk = 0; kk < K; kk += T) {
+                size_t len = min_sz(kk + T, K) - kk;
+                for (size_t c = jj; c < jend; c++) {
+                    if (A->dt == DT_F32)
+                        C->f32[i*C->ld + c] += j->ops->sdot(&A->f32[i*A->ld + kk], &B->f32[c*B->ld + kk], len);
+                    else
+                        C->data[i*C->ld + c] += j->ops->dot(&A->data[i*A->ld + kk], &B->data[c*B->ld + kk], len);
+                }
+            }
+        }
+    }
+}
 
-    size_t i0, i1;
-    row_range(A->rows, j->tid, j->nt, &i0, &i1);
+/*
+ * A^T B^T: column c of C is the sum over k of B[c, k] * A[k, :]. Rows of A
+ * are added into a stack block of TT_COLS columns by TT_ROWS rows, which
+ * is then added to C row by row; threads own line-aligned column ranges.
+ */
+#define TT_ROWS 256
+#define TT_COLS 16    /* >= pool_line_unit() of every element size */
 
-    size_t M = A->rows, K = A->cols, N = B->cols;
-    (void)M;
+static void mm_cols_tt(const MMJob *j, size_t c0, size_t c1) {
+    const Mat *A = j->A, *B = j->B;
+    Mat *C = j->C;
+    const size_t M = C->rows, K = A->rows;
+    union { double d[TT_COLS * TT_ROWS]; float f[TT_COLS * TT_ROWS]; } t;
+    for (size_t cb = c0; cb < c1; cb += TT_COLS) {
+        size_t w = min_sz(TT_COLS, c1 - cb);
+        for (size_t ib = 0; ib < M; ib += TT_ROWS) {
+            if (g_stop) return;
+            size_t h = min_sz(TT_ROWS, M - ib);
+            memset(&t, 0, sizeof(t));
+            for (size_t k = 0; k < K; k++) {
+                for (size_t c = 0; c < w; c++) {
+                    const size_t b = (cb + c) * B->ld + k;
+                    if (A->dt == DT_F32)
+                        j->ops->saxpy(B->f32[b], &A->f32[k*A->ld + ib], &t.f[c * TT_ROWS], h);
+                    else
+                        j->ops->axpy(B->data[b], &A->data[k*A->ld + ib], &t.d[c * TT_ROWS], h);
+                }
+            }
+            for (size_t i = 0; i < h; i++) {
+                for (size_t c = 0; c < w; c++) {
+                    if (A->dt == DT_F32) C->f32[(ib + i)*C->ld + cb + c] += t.f[c * TT_ROWS + i];
+                    else C->data[(ib + i)*C->ld + cb + c] += t.d[c * TT_ROWS + i];
+                }
+            }
+        }
+    }
+}
+
+/* A B and A^T B: rows of C built from rows of B, scaled by op(A) elements. */
+static void mm_rows(const MMJob *j, size_t i0, size_t i1) {
+    const size_t K = j->ta == TR_T ? j->A->rows : j->A->cols, N = j->B->cols, pf = j->pf;
 
     if (j->tile <= 0) {
         for (size_t i = i0; i < i1; i++) {
             if (g_stop) break;
             for (size_t k = 0; k < K; k++) {
-                double a = A->data[i*K + k];
-                const double *brow = &B->data[k*N];
-                double *crow = &C->data[i*N];
-                for (size_t jj = 0; jj < N; jj++) crow[jj] += a * brow[jj];
+                /* A whole row is one long stream: the hardware follows it after the first line. */
+                if (pf && k + pf < K) mm_prefetch(j, k + pf, 0, 1);
+                mm_axpy(j, i, k, 0, N);
             }
         }
-        return NULL;
+        return;
     }
 
     size_t T = (size_t)j->tile;
@@ -104,88 +659,227 @@ static void* mm_worker(void *p) {
             for (size_t kk = 0; kk < K; kk += T) {
                 size_t kend = min_sz(kk + T, K);
                 for (size_t k = kk; k < kend; k++) {
-                    double a = A->data[i*K + k];
-                    const double *brow = &B->data[k*N];
-                    double *crow = &C->data[i*N];
-                    for (size_t col = jj; col < jend; col++) {
-                        crow[col] += a * brow[col];
-                    }
+                    if (pf && k + pf < K) mm_prefetch(j, k + pf, jj, jend - jj);
+                    mm_axpy(j, i, k, jj, jend - jj);
                 }
             }
         }
     }
-    return NULL;
 }
 
-int mm_mt(const Mat *A, const Mat *B, Mat *C, KCfg cfg) {
-    if (!A || !B || !C || !A->data || !B->data || !C->data) return -1;
-    if (A->cols != B->rows) return -1;
-    if (C->rows != A->rows || C->cols != B->cols) return -1;
+static void mm_worker(void *p, int tid, int nt) {
+    MMJob *j = (MMJob*)p;
+    size_t i0, i1;
+    int taken = 0;
+    while (!g_stop && split_next(&j->split, tid, nt, &taken, &i0, &i1)) {
+        if (j->tb == TR_N) mm_rows(j, i0, i1);
+        else if (j->ta == TR_N) mm_rows_nt(j, i0, i1);
+        else mm_cols_tt(j, i0, i1);
+    }
+}
+
+typedef struct {
+    Mat *C;
+} ZeroJob;
 
-    memset(C->data, 0, sizeof(double) * C->rows * C->cols);
+/* Clears C by row blocks so zeroing keeps the first-touch page placement. */
+static void zero_worker(void *p, int tid, int nt) {
+    Mat *C = ((ZeroJob*)p)->C;
+    size_t i0, i1;
+    const size_t esz = dt_size(C->dt), rb = C->ld * esz;
+    row_range_al(C->rows, pool_line_unit(esz), tid, nt, &i0, &i1);
+    char *base = (char*)C->data;
+    if (C->ld == C->cols) {
+        if (i1 > i0) memset(base + i0 * rb, 0, (i1 - i0) * rb);
+        return;
+    }
+    for (size_t i = i0; i < i1; i++) memset(base + i * rb, 0, esz * C->cols);
+}
+
+static int mm_shape_ok(const Mat *A, Trans ta, const Mat *B, Trans tb, const Mat *C) {
+    if (!A || !B || !C || !A->data || !B->data || !C->data) return 0;
+    const size_t m = ta == TR_T ? A->cols : A->rows, k = ta == TR_T ? A->rows : A->cols;
+    const size_t kb = tb == TR_T ? B->cols : B->rows, n = tb == TR_T ? B->rows : B->cols;
+    if (k != kb || C->rows != m || C->cols != n) return 0;
+    return B->dt == A->dt && C->dt == A->dt;
+}
+
+static int mm_run(const Mat *A, Trans ta, const Mat *B, Trans tb, Mat *C, KCfg cfg, int zero) {
+    if (!mm_shape_ok(A, ta, B, tb, C)) return -1;
 
     int nt = cfg.nt <= 0 ? 1 : cfg.nt;
-    pthread_t *ths = (pthread_t*)calloc((size_t)nt, sizeof(pthread_t));
-    MMJob  *jobs = (MMJob*)calloc((size_t)nt, sizeof(MMJob));
-    if (!ths || !jobs) { free(ths); free(jobs); return -1; }
+    ZeroJob zj = { .C=C };
+    if (zero && pool_run(cfg.pool, nt, zero_worker, &zj) < 0) return -1;
+    /* The recursion splits untransposed views; transposed operands take the packed path. */
+    if (A->dt == DT_F64 && (cfg.mm_algo == MM_PACKED || (cfg.mm_algo == MM_RECURSIVE && (ta == TR_T || tb == TR_T))))
+        return gemm_packed(A, ta, B, tb, C, cfg);
+    if (cfg.mm_algo == MM_RECURSIVE && A->dt == DT_F64) return gemm_recursive(A, B, C, cfg);
 
-    for (int t = 0; t < nt; t++) {
-        jobs[t] = (MMJob){ .A=A, .B=B, .C=C, .tid=t, .nt=nt, .tile=cfg.tile };
-        if (pthread_create(&ths[t], NULL, mm_worker, &jobs[t]) != 0) {
-            nt = t; break;
-        }
+    MMJob job = { .A=A, .B=B, .C=C, .ta=ta, .tb=tb, .tile=cfg.tile, .ops=simd_ops(),
+                  .pf = cfg.pf > 0 ? (size_t)cfg.pf : 0 };
+    if (ta == TR_T && tb == TR_T) {
+        split_init(&job.split, C->cols, cfg.sched, grain(&cfg, TT_COLS));
+        split_align(&job.split, pool_line_unit(dt_size(C->dt)));
+    } else {
+        split_init(&job.split, C->rows, cfg.sched, grain(&cfg, MM_CHUNK_ROWS));
+        split_align(&job.split, pool_line_unit(dt_size(C->dt)));
     }
-    for (int t = 0; t < nt; t++) pthread_join(ths[t], NULL);
+    return pool_run(cfg.pool, nt, mm_worker, &job) < 0 ? -1 : 0;
+}
 
-    free(ths); free(jobs);
-    return 0;
+int mm_mt(const Mat *A, Trans ta, const Mat *B, Trans tb, Mat *C, KCfg cfg) {
+    return mm_run(A, ta, B, tb, C, cfg, 1);
+}
+
+int mm_acc_mt(const Mat *A, const Mat *B, Mat *C, KCfg cfg) {
+    return mm_run(A, TR_N, B, TR_N, C, cfg, 0);
+}
+
+
+/* Default SCHED_DYNAMIC grain of the batched kernels, in items. */
+#define BATCH_CHUNK 8
+
+typedef struct {
+    const Mat *A;
+    const Mat *B;   /* mm */
+    Mat *C;
+    const Vec *x;   /* mv */
+    Vec *y;
+    int tile;
+    Accum acc;
+    const SimdOps *ops;
+    Split split;
+} BatchJob;
+
+static void mm_item(const BatchJob *j, size_t b) {
+    const Mat *A = &j->A[b], *B = &j->B[b];
+    Mat *C = &j->C[b];
+    int f = A->dt == DT_F64 && A->rows == A->cols && B->cols == A->cols ? simd_fix_index(A->rows) : -1;
+    if (f >= 0) {
+        j->ops->mmfix[f](A->data, A->ld, B->data, B->ld, C->data, C->ld);
+        return;
+    }
+    const size_t esz = dt_size(C->dt);
+    for (size_t i = 0; i < C->rows; i++) memset((char*)C->data + i * C->ld * esz, 0, C->cols * esz);
+    MMJob mj = { .A=A, .B=B, .C=C, .tile=j->tile, .ops=j->ops };
+    mm_rows(&mj, 0, A->rows);
+}
+
+static void mm_batch_worker(void *p, int tid, int nt) {
+    BatchJob *j = (BatchJob*)p;
+    size_t b0, b1;
+    int taken = 0;
+    while (!g_stop && split_next(&j->split, tid, nt, &taken, &b0, &b1))
+        for (size_t b = b0; b < b1; b++) mm_item(j, b);
+}
+
+int mm_batch(const Mat *A, const Mat *B, Mat *C, size_t count, KCfg cfg) {
+    if (!A || !B || !C) return -1;
+    for (size_t b = 0; b < count; b++)
+        if (!mm_shape_ok(&A[b], TR_N, &B[b], TR_N, &C[b])) return -1;
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+
+    BatchJob job = { .A=A, .B=B, .C=C, .tile=cfg.tile, .ops=simd_ops() };
+    split_init(&job.split, count, cfg.sched, grain(&cfg, BATCH_CHUNK));
+    return pool_run(cfg.pool, nt, mm_batch_worker, &job) < 0 ? -1 : 0;
+}
+
+static void mv_batch_worker(void *p, int tid, int nt) {
+    BatchJob *j = (BatchJob*)p;
+    size_t b0, b1;
+    int taken = 0;
+    while (!g_stop && split_next(&j->split, tid, nt, &taken, &b0, &b1))
+        for (size_t b = b0; b < b1; b++)
+            mv_block(j->ops, j->acc, &j->A[b], &j->x[b], j->y[b].data, 0, j->A[b].rows);
 }
 
+int mv_batch(const Mat *A, const Vec *x, Vec *y, size_t count, KCfg cfg) {
+    if (!A || !x || !y) return -1;
+    for (size_t b = 0; b < count; b++) {
+        if (!A[b].data || !x[b].data || !y[b].data) return -1;
+        if (A[b].cols != x[b].len || A[b].rows != y[b].len) return -1;
+        if (x[b].dt != A[b].dt || y[b].dt != A[b].dt) return -1;
+    }
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+
+    BatchJob job = { .A=A, .x=x, .y=y, .acc=cfg.acc, .ops=simd_ops() };
+    split_init(&job.split, count, cfg.sched, grain(&cfg, BATCH_CHUNK));
+    return pool_run(cfg.pool, nt, mv_batch_worker, &job) < 0 ? -1 : 0;
+}
+
+/* RED_REPRO dot: elements per block sum; up to REPRO_STACK block sums live on the stack. */
+#define REPRO_BLOCK 4096
+#define REPRO_STACK 1024
 
 typedef struct {
     const Vec *x;
     const Vec *y;
-    double partial;
-    int tid, nt;
+    const SimdOps *ops;
+    Accum acc;
+    Split split;            /* over elements, or over blocks with RED_REPRO */
+    double *blocks;         /* RED_REPRO: one sum per REPRO_BLOCK elements */
+    PoolSlot partial[POOL_MAX_THREADS];
 } DotJob;
 
-static void* dt_worker(void *p) {
+static void dt_worker(void *p, int tid, int nt) {
     DotJob *j = (DotJob*)p;
-    size_t n = j->x->len;
-    size_t i0, i1;
-    row_range(n, j->tid, j->nt, &i0, &i1);
+    const Vec *x = j->x, *y = j->y;
     double s = 0.0;
-    for (size_t i = i0; i < i1; i++) {
-        if (g_stop) break;
-        s += j->x->data[i] * j->y->data[i];
+    size_t i0, i1;
+    int taken = 0;
+    while (!g_stop && split_next(&j->split, tid, nt, &taken, &i0, &i1)) {
+        if (j->blocks) {
+            for (size_t b = i0; b < i1 && !g_stop; b++) {
+                size_t i = b * REPRO_BLOCK;
+                j->blocks[b] = vdot(j->ops, j->acc, x, y, i, min_sz(x->len - i, REPRO_BLOCK));
+            }
+            continue;
+        }
+        for (size_t i = i0; i < i1; i += STOP_CHUNK) {
+            if (g_stop) break;
+            size_t m = min_sz(i1 - i, STOP_CHUNK);
+            s += vdot(j->ops, j->acc, x, y, i, m);
+        }
     }
-    j->partial = s;
-    return NULL;
+    j->partial[tid].v = s;
 }
 
-int dt_mt(const Vec *x, const Vec *y, double *out, int nt) {
-    if (!x || !y || !out || !x->data || !y->data) return -1;
-    if (x->len != y->len) return -1;
-    nt = nt <= 0 ? 1 : nt;
+/* Fixed-shape tree over v[0:n]: the order depends only on n. */
+static double pairwise(const double *v, size_t n) {
+    if (n <= 8) {
+        double s = 0.0;
+        for (size_t i = 0; i < n; i++) s += v[i];
+        return s;
+    }
+    size_t h = n / 2;
+    return pairwise(v, h) + pairwise(v + h, n - h);
+}
 
-    pthread_t *ths = (pthread_t*)calloc((size_t)nt, sizeof(pthread_t));
-    DotJob   *jobs = (DotJob*)calloc((size_t)nt, sizeof(DotJob));
-    if (!ths || !jobs) { free(ths); free(jobs); return -1; }
+int dt_mt(const Vec *x, const Vec *y, double *out, KCfg cfg) {
+    if (!x || !y || !out || !x->data || !y->data) return -1;
+    if (x->len != y->len || x->dt != y->dt) return -1;
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
 
-    for (int t = 0; t < nt; t++) {
-        jobs[t] = (DotJob){ .x=x, .y=y, .partial=0.0, .tid=t, .nt=nt };
-        if (pthread_create(&ths[t], NULL, dt_worker, &jobs[t]) != 0) {
-            nt = t; break;
-        }
+    DotJob job = { .x=x, .y=y, .ops=simd_ops(), .acc=cfg.acc };
+    if (cfg.red == RED_REPRO) {
+        double stack[REPRO_STACK];
+        size_t nb = (x->len + REPRO_BLOCK - 1) / REPRO_BLOCK;
+        job.blocks = nb <= REPRO_STACK ? stack : (double*)arena_get(nb * sizeof(double), 0);
+        if (!job.blocks) return -1;
+        /* --chunk stays in elements; hand out whole blocks. */
+        split_init(&job.split, nb, cfg.sched, (grain(&cfg, STOP_CHUNK) + REPRO_BLOCK - 1) / REPRO_BLOCK);
+        int rc = pool_run(cfg.pool, nt, dt_worker, &job) < 0 ? -1 : 0;
+        if (rc == 0 && !g_stop) *out = pairwise(job.blocks, nb);
+        if (job.blocks != stack) arena_put(job.blocks);
+        return rc;
     }
+    split_init(&job.split, x->len, cfg.sched, grain(&cfg, STOP_CHUNK));
+    nt = pool_run(cfg.pool, nt, dt_worker, &job);
+    if (nt < 0) return -1;
+
     double sum = 0.0;
-    for (int t = 0; t < nt; t++) {
-        pthread_join(ths[t], NULL);
-        sum += jobs[t].partial;
-    }
+    for (int t = 0; t < nt; t++) sum += job.partial[t].v;
     *out = sum;
-
-    free(ths); free(jobs);
     return 0;
 }
 
@@ -193,38 +887,185 @@ typedef struct {
     double a;
     const Vec *x;
     Vec *y;
-    int tid, nt;
+    const SimdOps *ops;
+    Split split;
 } AXJob;
 
-static void* ax_worker(void *p) {
+static void ax_worker(void *p, int tid, int nt) {
     AXJob *j = (AXJob*)p;
-    size_t n = j->x->len;
     size_t i0, i1;
-    row_range(n, j->tid, j->nt, &i0, &i1);
-    for (size_t i = i0; i < i1; i++) {
-        if (g_stop) break;
-        j->y->data[i] = j->a * j->x->data[i] + j->y->data[i];
+    int taken = 0;
+    while (!g_stop && split_next(&j->split, tid, nt, &taken, &i0, &i1)) {
+        for (size_t i = i0; i < i1; i += STOP_CHUNK) {
+            if (g_stop) break;
+            size_t m = min_sz(i1 - i, STOP_CHUNK);
+            if (j->x->dt == DT_F32) j->ops->saxpy((float)j->a, &j->x->f32[i], &j->y->f32[i], m);
+            else j->ops->axpy(j->a, &j->x->data[i], &j->y->data[i], m);
+        }
     }
-    return NULL;
 }
 
-int ax_mt(double a, const Vec *x, Vec *y, int nt) {
+int ax_mt(double a, const Vec *x, Vec *y, KCfg cfg) {
     if (!x || !y || !x->data || !y->data) return -1;
-    if (x->len != y->len) return -1;
-    nt = nt <= 0 ? 1 : nt;
+    if (x->len != y->len || x->dt != y->dt) return -1;
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+
+    AXJob job = { .a=a, .x=x, .y=y, .ops=simd_ops() };
+    split_init(&job.split, x->len, cfg.sched, grain(&cfg, STOP_CHUNK));
+    split_align(&job.split, pool_line_unit(dt_size(y->dt)));
+    return pool_run(cfg.pool, nt, ax_worker, &job) < 0 ? -1 : 0;
+}
+
+
+/* ---- fused kernels ----------------------------------------------------
+ * One pool_run and one pass over the operands: the second step of each
+ * reads the block the first step just wrote while it is still in cache.
+ */
+
+/* f32 axdot works in blocks this size so the second pass hits L1. */
+#define FUSE_BLOCK 2048
+
+typedef struct {
+    const Mat *A;
+    const Vec *x;
+    Vec *y;
+    const Vec *z;
+    const SimdOps *ops;
+    Accum acc;
+    Split split;
+    PoolSlot partial[POOL_MAX_THREADS];
+} MVDotJob;
+
+static void mvdot_worker(void *p, int tid, int nt) {
+    MVDotJob *j = (MVDotJob*)p;
+    double s = 0.0;
+    size_t i0, i1;
+    int taken = 0;
+    while (!g_stop && split_next(&j->split, tid, nt, &taken, &i0, &i1)) {
+        for (size_t i = i0; i < i1; i += STOP_ROWS) {
+            if (g_stop) break;
+            size_t m = min_sz(i1 - i, STOP_ROWS);
+            mv_block(j->ops, j->acc, j->A, j->x, vat(j->y, i), i, m);
+            s += vdot(j->ops, j->acc, j->y, j->z, i, m);
+        }
+    }
+    j->partial[tid].v = s;
+}
+
+int mvdot_mt(const Mat *A, const Vec *x, Vec *y, const Vec *z, double *out, KCfg cfg) {
+    if (!A || !x || !y || !z || !out || !A->data || !x->data || !y->data || !z->data) return -1;
+    if (A->cols != x->len || A->rows != y->len || y->len != z->len) return -1;
+    if (x->dt != A->dt || y->dt != A->dt || z->dt != A->dt) return -1;
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+
+    MVDotJob job = { .A=A, .x=x, .y=y, .z=z, .ops=simd_ops(), .acc=cfg.acc };
+    split_init(&job.split, A->rows, cfg.sched, grain(&cfg, STOP_ROWS));
+    split_align(&job.split, pool_line_unit(dt_size(y->dt)));
+    nt = pool_run(cfg.pool, nt, mvdot_worker, &job);
+    if (nt < 0) return -1;
+
+    double sum = 0.0;
+    for (int t = 0; t < nt; t++) sum += job.partial[t].v;
+    *out = sum;
+    return 0;
+}
 
-    pthread_t *ths = (pthread_t*)calloc((size_t)nt, sizeof(pthread_t));
-    AXJob  *jobs = (AXJob*)calloc((size_t)nt, sizeof(AXJob));
-    if (!ths || !jobs) { free(ths); free(jobs); return -1; }
+typedef struct {
+    double a;
+    const Vec *x;
+    Vec *y;
+    const SimdOps *ops;
+    Accum acc;
+    Split split;
+    PoolSlot partial[POOL_MAX_THREADS];
+} AXDotJob;
 
-    for (int t = 0; t < nt; t++) {
-        jobs[t] = (AXJob){ .a=a, .x=x, .y=y, .tid=t, .nt=nt };
-        if (pthread_create(&ths[t], NULL, ax_worker, &jobs[t]) != 0) {
-            nt = t; break;
+static void axdot_worker(void *p, int tid, int nt) {
+    AXDotJob *j = (AXDotJob*)p;
+    const Vec *x = j->x, *y = j->y;
+    double s = 0.0;
+    size_t i0, i1;
+    int taken = 0;
+    while (!g_stop && split_next(&j->split, tid, nt, &taken, &i0, &i1)) {
+        for (size_t i = i0; i < i1; i += STOP_CHUNK) {
+            if (g_stop) break;
+            size_t m = min_sz(i1 - i, STOP_CHUNK);
+            if (x->dt == DT_F64) {
+                s += j->ops->axdot(j->a, &x->data[i], &y->data[i], m);
+                continue;
+            }
+            for (size_t b = i; b < i + m; b += FUSE_BLOCK) {
+                size_t mb = min_sz(i + m - b, FUSE_BLOCK);
+                j->ops->saxpy((float)j->a, &x->f32[b], &y->f32[b], mb);
+                s += vdot(j->ops, j->acc, y, y, b, mb);
+            }
         }
     }
-    for (int t = 0; t < nt; t++) pthread_join(ths[t], NULL);
+    j->partial[tid].v = s;
+}
+
+int axdot_mt(double a, const Vec *x, Vec *y, double *out, KCfg cfg) {
+    if (!x || !y || !out || !x->data || !y->data) return -1;
+    if (x->len != y->len || x->dt != y->dt) return -1;
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+
+    AXDotJob job = { .a=a, .x=x, .y=y, .ops=simd_ops(), .acc=cfg.acc };
+    split_init(&job.split, x->len, cfg.sched, grain(&cfg, STOP_CHUNK));
+    split_align(&job.split, pool_line_unit(dt_size(y->dt)));
+    nt = pool_run(cfg.pool, nt, axdot_worker, &job);
+    if (nt < 0) return -1;
 
-    free(ths); free(jobs);
+    double sum = 0.0;
+    for (int t = 0; t < nt; t++) sum += job.partial[t].v;
+    *out = sum;
     return 0;
 }
+
+typedef struct {
+    double alpha, beta;
+    const Mat *A;
+    const Vec *x;
+    Vec *y;
+    const SimdOps *ops;
+    Accum acc;
+    Split split;
+} GemvJob;
+
+static void gemv_worker(void *p, int tid, int nt) {
+    GemvJob *j = (GemvJob*)p;
+    const double alpha = j->alpha, beta = j->beta;
+    union { double d[STOP_ROWS]; float f[STOP_ROWS]; } t;
+    Vec *y = j->y;
+    size_t i0, i1;
+    int taken = 0;
+    while (split_next(&j->split, tid, nt, &taken, &i0, &i1)) {
+        for (size_t i = i0; i < i1; i += STOP_ROWS) {
+            if (g_stop) return;
+            size_t m = min_sz(i1 - i, STOP_ROWS);
+            mv_block(j->ops, j->acc, j->A, j->x, &t, i, m);
+            /* beta == 0 must not read y, so NaN/garbage in it does not leak through. */
+            if (y->dt == DT_F64) {
+                double *yi = &y->data[i];
+                if (beta == 0.0) for (size_t r = 0; r < m; r++) yi[r] = alpha * t.d[r];
+                else for (size_t r = 0; r < m; r++) yi[r] = alpha * t.d[r] + beta * yi[r];
+            } else {
+                float *yi = &y->f32[i];
+                const float fa = (float)alpha, fb = (float)beta;
+                if (beta == 0.0) for (size_t r = 0; r < m; r++) yi[r] = fa * t.f[r];
+                else for (size_t r = 0; r < m; r++) yi[r] = fa * t.f[r] + fb * yi[r];
+            }
+        }
+    }
+}
+
+int gemv_mt(double alpha, const Mat *A, const Vec *x, double beta, Vec *y, KCfg cfg) {
+    if (!A || !x || !y || !A->data || !x->data || !y->data) return -1;
+    if (A->cols != x->len || A->rows != y->len) return -1;
+    if (x->dt != A->dt || y->dt != A->dt) return -1;
+    int nt = cfg.nt <= 0 ? 1 : cfg.nt;
+
+    GemvJob job = { .alpha=alpha, .beta=beta, .A=A, .x=x, .y=y, .ops=simd_ops(), .acc=cfg.acc };
+    split_init(&job.split, A->rows, cfg.sched, grain(&cfg, STOP_ROWS));
+    split_align(&job.split, pool_line_unit(dt_size(y->dt)));
+    return pool_run(cfg.pool, nt, gemv_worker, &job) < 0 ? -1 : 0;
+}
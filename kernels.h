@@ -2,19 +2,125 @@
 #define KERNELS_H
 
 #include "matrix.h"
+#include "sparse.h"
+#include "tri.h"
+#include "pool.h"
 #include <stddef.h>
 
+typedef enum { MM_TILED, MM_PACKED, MM_RECURSIVE } MMAlgo;
+
+/* Accumulator type for DT_F32 dot and mv; DT_F64 always accumulates in double. */
+typedef enum { ACC_NATIVE, ACC_F64 } Accum;
+
+/*
+ * RED_FAST sums dot per thread and then in thread order, and mv rows in
+ * groups that depend on the split, so results change with the thread
+ * count. RED_REPRO sums dot in fixed-size blocks combined by a pairwise
+ * tree, and each mv row by itself: bitwise identical for any thread
+ * count and --sched (for one ISA).
+ */
+typedef enum { RED_FAST, RED_REPRO } Reduce;
+
+/* BLAS-style operand flag: TR_T uses the stored matrix as its transpose, in place. */
+typedef enum { TR_N, TR_T } Trans;
+
 typedef struct {
     int nt;
     int tile;
+    Pool *pool;     /* NULL: spawn threads per call */
+    MMAlgo mm_algo;
+    int mc, kc, nc; /* MM_PACKED cache blocking; 0 picks the default */
+    int strassen;   /* MM_RECURSIVE: Strassen-Winograd levels down to this size; 0 = off */
+    Accum acc;
+    Sched sched;    /* SCHED_STATIC: one row_range() block per thread */
+    int chunk;      /* SCHED_DYNAMIC grain: rows for mv/mm, elements for dot/axpy, items for batches; 0 = default */
+    Reduce red;     /* dt_mt and mv_mt summation order */
+    int pf;         /* mv and tiled mm: software-prefetch rows this far ahead; 0 = off */
 } KCfg;
 
-int mv_mt(const Mat *A, const Vec *x, Vec *y, KCfg cfg);
+/*
+ * All operands of one call must share an element type (-1 otherwise).
+ * DT_F32 mm always runs the tiled path.
+ */
+
+/*
+ * y = op(A) * x. A^T x is a column axpy: with RED_FAST each thread adds
+ * x[i] * A[i, :] over its rows into a private partial y, and the partials
+ * are then summed by column ranges. With RED_REPRO each thread owns
+ * whole columns of y and adds every row into them in order instead.
+ */
+int mv_mt(const Mat *A, Trans ta, const Vec *x, Vec *y, KCfg cfg);
+
+/*
+ * y = A * x for CSR A. Work is split by nonzeros, not rows: each thread
+ * (or, with SCHED_DYNAMIC, each chunk of cfg.chunk nonzeros) takes the
+ * rows that start inside its nnz range.
+ */
+int spmv_mt(const Csr *A, const Vec *x, Vec *y, KCfg cfg);
+
+/*
+ * C = op(A) * op(B), never forming a transpose. Tiled: A^T B scales rows
+ * of B by a column of A, A B^T is a grid of row-by-row dots, and A^T B^T
+ * builds C by column blocks. Packed GEMM reads the transpose while
+ * packing; MM_RECURSIVE with a transposed operand runs the packed path.
+ */
+int mm_mt(const Mat *A, Trans ta, const Mat *B, Trans tb, Mat *C, KCfg cfg);
+
+/*
+ * Structured kernels on packed triangles (tri.h). Triangular rows differ
+ * in length, so work is split by packed elements, not rows: each piece
+ * takes the rows that start inside it, as spmv_mt does with nonzeros.
+ */
+
+/*
+ * C = op(A) * op(A)^T into C's stored triangle, about half the flops of
+ * mm_mt. f64 runs packed GEMM tiles on one side of the diagonal (see
+ * gemm_syrk); f32 uses row dots (TR_N) or row axpys (TR_T).
+ */
+int syrk_mt(const Mat *A, Trans ta, Tri *C, KCfg cfg);
+
+/*
+ * y = A * x for symmetric A, reading each stored element once: row i
+ * gives y[i] a dot product and adds x[i] times the row into the mirrored
+ * entries. With RED_FAST those go to per-thread partial y vectors that
+ * are summed at the end. With RED_REPRO threads own fixed blocks of y
+ * instead and results do not depend on the thread count, at the cost of
+ * reading A twice.
+ */
+int symv_mt(const Tri *A, const Vec *x, Vec *y, KCfg cfg);
+
+/* y = A * x for triangular A: one dot per stored row. */
+int trmv_mt(const Tri *A, const Vec *x, Vec *y, KCfg cfg);
+
+/* C += A * B: mm_mt without clearing C first, for block-wise products. */
+int mm_acc_mt(const Mat *A, const Mat *B, Mat *C, KCfg cfg);
+
+/*
+ * Batched small problems: count independent items, each computed whole
+ * by one thread. Threads split the items (under cfg.sched, cfg.chunk
+ * items at a time), not the rows, so a batch of tiny products costs one
+ * dispatch. Items may differ in shape. Square f64 mm items of size 4,
+ * 8, 16 or 32 use the SIMD variant's fixed-size kernel.
+ */
+int mm_batch(const Mat *A, const Mat *B, Mat *C, size_t count, KCfg cfg);
+int mv_batch(const Mat *A, const Vec *x, Vec *y, size_t count, KCfg cfg);
+
+int dt_mt(const Vec *x, const Vec *y, double *out, KCfg cfg);
+
+int ax_mt(double a, const Vec *x, Vec *y, KCfg cfg);
+
+/*
+ * Fused kernels: one parallel region and one pass over memory instead
+ * of two or three separate calls.
+ */
 
-int mm_mt(const Mat *A, const Mat *B, Mat *C, KCfg cfg);
+/* y = A * x, then *out = y . z */
+int mvdot_mt(const Mat *A, const Vec *x, Vec *y, const Vec *z, double *out, KCfg cfg);
 
-int dt_mt(const Vec *x, const Vec *y, double *out, int nt);
+/* y += a * x, then *out = y . y */
+int axdot_mt(double a, const Vec *x, Vec *y, double *out, KCfg cfg);
 
-int ax_mt(double a, const Vec *x, Vec *y, int nt);
+/* y = alpha * A * x + beta * y; with beta == 0, y is not read. */
+int gemv_mt(double alpha, const Mat *A, const Vec *x, double beta, Vec *y, KCfg cfg);
 
 #endif
@@ -2,6 +2,16 @@
 #include "matrix.h"
 #include "kernels.h"
 #include "bench.h"
+#include "simd.h"
+#include "opcache.h"
+#include "roof.h"
+#include "ooc.h"
+#include "tune.h"
+#include "arena.h"
+#include "dist.h"
+#include "chunk.h"
+#include "ctx.h"
+#include "serve.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,23 +19,37 @@
 #include <getopt.h>
 #include <signal.h>
 #include <limits.h>
-
-volatile sig_atomic_t g_stop = 0;
+#include <unistd.h>
+#include <sys/stat.h>
 
 static void on_sigint(int signo) {
     (void)signo;
     g_stop = 1;
 }
 
-typedef enum { OP_NONE, OP_MM, OP_MV, OP_DOT, OP_AXPY, OP_ALL } Op;
+/* OP_SPMV is mv on a --sparse A, OP_MMB/OP_MVB mm/mv with --batch; each is reported under its own name. */
+typedef enum { OP_NONE, OP_MM, OP_MV, OP_DOT, OP_AXPY, OP_ALL, OP_SPMV, OP_MMB, OP_MVB,
+               OP_SYRK, OP_SYMV, OP_TRMV, OP_CONVERT, OP_SERVE, OP_SEND } Op;
 
 static FileFmt parse_fmt(const char *s) {
     if (!s) return FMT_TEXT;
     if (strcmp(s, "text") == 0) return FMT_TEXT;
     if (strcmp(s, "bin")  == 0) return FMT_BIN;
+    if (strcmp(s, "chunk") == 0) return FMT_CHUNK;
     return FMT_TEXT;
 }
 
+static const char *fmt_name(FileFmt f) {
+    return f == FMT_BIN ? "bin" : f == FMT_CHUNK ? "chunk" : "text";
+}
+
+static int parse_codec(const char *s, Codec *out) {
+    if (strcmp(s, "none") == 0)    { *out = CODEC_NONE; return 0; }
+    if (strcmp(s, "lz") == 0)      { *out = CODEC_LZ; return 0; }
+    if (strcmp(s, "shuffle") == 0) { *out = CODEC_SHUF; return 0; }
+    return -1;
+}
+
 static Op parse_op(const char *s) {
     if (!s) return OP_NONE;
     if (strcmp(s, "mm") == 0)   return OP_MM;
@@ -33,9 +57,67 @@ static Op parse_op(const char *s) {
     if (strcmp(s, "dot") == 0)  return OP_DOT;
     if (strcmp(s, "axpy") == 0) return OP_AXPY;
     if (strcmp(s, "all") == 0)  return OP_ALL;
+    if (strcmp(s, "syrk") == 0) return OP_SYRK;
+    if (strcmp(s, "symv") == 0) return OP_SYMV;
+    if (strcmp(s, "trmv") == 0) return OP_TRMV;
+    if (strcmp(s, "convert") == 0) return OP_CONVERT;
+    if (strcmp(s, "serve") == 0) return OP_SERVE;
+    if (strcmp(s, "send") == 0) return OP_SEND;
     return OP_NONE;
 }
 
+static int parse_mm_algo(const char *s, MMAlgo *out) {
+    if (strcmp(s, "tiled") == 0)  { *out = MM_TILED;  return 0; }
+    if (strcmp(s, "packed") == 0) { *out = MM_PACKED; return 0; }
+    if (strcmp(s, "recursive") == 0) { *out = MM_RECURSIVE; return 0; }
+    return -1;
+}
+
+/* f64; f32 storage and arithmetic; mixed = f32 storage with double accumulators. */
+static int parse_dtype(const char *s, DType *dt, Accum *acc) {
+    if (strcmp(s, "f64") == 0)   { *dt = DT_F64; *acc = ACC_NATIVE; return 0; }
+    if (strcmp(s, "f32") == 0)   { *dt = DT_F32; *acc = ACC_NATIVE; return 0; }
+    if (strcmp(s, "mixed") == 0) { *dt = DT_F32; *acc = ACC_F64;    return 0; }
+    return -1;
+}
+
+static int parse_sched(const char *s, Sched *out) {
+    if (strcmp(s, "static") == 0)  { *out = SCHED_STATIC;  return 0; }
+    if (strcmp(s, "dynamic") == 0) { *out = SCHED_DYNAMIC; return 0; }
+    return -1;
+}
+
+static int parse_reduce(const char *s, Reduce *out) {
+    if (strcmp(s, "fast") == 0)  { *out = RED_FAST;  return 0; }
+    if (strcmp(s, "repro") == 0) { *out = RED_REPRO; return 0; }
+    return -1;
+}
+
+static int parse_huge(const char *s, HugeMode *out) {
+    if (strcmp(s, "off") == 0) { *out = HUGE_OFF; return 0; }
+    if (strcmp(s, "thp") == 0) { *out = HUGE_THP; return 0; }
+    if (strcmp(s, "2M") == 0 || strcmp(s, "2m") == 0) { *out = HUGE_2M; return 0; }
+    if (strcmp(s, "1G") == 0 || strcmp(s, "1g") == 0) { *out = HUGE_1G; return 0; }
+    return -1;
+}
+
+static int parse_uplo(const char *s, Uplo *out) {
+    if (strcmp(s, "lower") == 0) { *out = UPLO_L; return 0; }
+    if (strcmp(s, "upper") == 0) { *out = UPLO_U; return 0; }
+    return -1;
+}
+
+static int parse_dist(const char *s, DistLayout *out) {
+    if (strcmp(s, "1d") == 0) { *out = DIST_1D; return 0; }
+    if (strcmp(s, "summa") == 0) { *out = DIST_SUMMA; return 0; }
+    return -1;
+}
+
+static const char *dtype_name(DType dt, Accum acc) {
+    if (dt == DT_F64) return "f64";
+    return acc == ACC_F64 ? "mixed" : "f32";
+}
+
 static const char* op_name(Op op) {
     switch (op) {
         case OP_MM:   return "mm";
@@ -43,6 +125,15 @@ static const char* op_name(Op op) {
         case OP_DOT:  return "dot";
         case OP_AXPY: return "axpy";
         case OP_ALL:  return "all";
+        case OP_SPMV: return "spmv";
+        case OP_MMB:  return "mm_batch";
+        case OP_MVB:  return "mv_batch";
+        case OP_SYRK: return "syrk";
+        case OP_SYMV: return "symv";
+        case OP_TRMV: return "trmv";
+        case OP_CONVERT: return "convert";
+        case OP_SERVE: return "serve";
+        case OP_SEND: return "send";
         default:      return "unknown";
     }
 }
@@ -50,60 +141,137 @@ static const char* op_name(Op op) {
 static void usage(const char *argv0) {
     fprintf(stderr,
         "Usage:\n"
-    "  %s --op {mm|mv|dot|axpy|all} --format {text|bin} --threads N --out OUT [--repeat R]\n"
+    "  %s --op {mm|mv|dot|axpy|all|syrk|symv|trmv|convert|serve|send} --format {text|bin|chunk} --threads N --out OUT\n"
+    "     [--warmup W] [--repeat R|auto] [--min-time S]   (auto: samples to fill S seconds)\n"
+    "     [--threads-sweep 1,2,4,...|auto]   (time each count on the same operands, with roofline bounds)\n"
+    "     [--perf]   (cycles, instructions, L1D/LLC misses per call from hardware counters)\n"
+    "     [--isa auto|scalar|avx2|avx512] [--mmap] [--numa] [--dtype f64|f32|mixed]\n"
+    "     [--sched static|dynamic] [--chunk C]   (dynamic grain: rows for mm/mv, elements otherwise)\n"
+    "     [--reduce fast|repro]   (repro: dot and mv sums identical for every thread count)\n"
+    "     [--batch N]   (mm/mv: the files hold N stacked items; run them as one batched call)\n"
+    "     [--autotune] [--profile FILE|none]   (search tile/blocking/threads per op and size; saved per host)\n"
+    "     [--ooc BUDGET]   (mm/mv: stream A/B from bin or chunk files in panels within BUDGET bytes, e.g. 256M)\n"
+    "     [--arena BYTES]   (idle result/scratch memory kept for reuse; 0 = free at once)\n"
+    "     [--huge off|thp|2M|1G] [--prefetch ROWS]   (huge-page backing; mv/mm software prefetch distance)\n"
+    "     [--trans-a] [--trans-b]   (mm/mv use A^T and B^T as stored, without a transposed copy)\n"
+    "     [--dist 1d|summa] [--dist-block NB] [--ranks-sweep]   (mm/mv over MPI ranks; make MPI=1)\n"
         "\n"
         "Ops:\n"
-        "  mm:   --A Afile --B Bfile [--tile T]\n"
-        "  mv:   --A Afile --x xfile\n"
+        "  mm:   --A Afile --B Bfile [--tile T] [--mm-algo tiled|packed|recursive]\n"
+        "        [--gemm-block MC,KC,NC]   (packed blocking, 0 = default)\n"
+        "        [--strassen N]   (recursive: Strassen-Winograd while min(m,k,n) >= N; 0 = off)\n"
+        "  mv:   --A Afile --x xfile [--sparse]   (A in CSR format: rows cols nnz, then i j v)\n"
         "  dot:  --x xfile --y yfile\n"
         "  axpy: --alpha a --x xfile --y yfile\n"
+        "  syrk: --A Afile [--trans-a] [--uplo lower|upper]   (C = A*A^T, or A^T*A, one triangle)\n"
+        "  symv: --A Afile --x xfile [--uplo lower|upper] [--packed]   (symmetric A, half read)\n"
+        "  trmv: --A Afile --x xfile [--uplo lower|upper] [--packed]   (triangular A)\n"
+        "        (--packed: A is a packed triangle file, else the --uplo half of a square A)\n"
+        "  convert: --to {text|bin|chunk} [--codec none|lz|shuffle] with any of --A --B --x --y\n"
+        "        (writes OUT_A.<ext> etc.; chunk files are reloaded, timed and compared)\n"
+        "  serve: --socket PATH [--A --B --x --y]   (keep operands resident and answer requests;\n"
+        "        --out optional; the given files are preloaded as A, B, x and y)\n"
+        "  send:  --socket PATH   (requests from stdin, one per line, with round-trip times)\n"
         "\n"
         "all:\n"
         "  Runs mm -> mv -> dot -> axpy in that order.\n"
         "  It will SKIP ops whose required inputs are missing.\n"
         "\n"
-    "Output: Results printed to terminal only.\n"
+    "Output: CSV on stdout; per op also OUT_<op>.csv and OUT_<op>.json\n"
+    "        (median/min/p95/stddev per thread count) unless OUT is /dev/null.\n"
         "\n",
         argv0);
 }
 
-static double gflops_for(Op op, size_t m, size_t n, size_t k, size_t len, double sec) {
-    if (sec <= 0) return 0.0;
-    double flops = 0.0;
+static double flops_for(Op op, size_t m, size_t n, size_t k, size_t len) {
     switch (op) {
-        case OP_MM:   flops = 2.0 * (double)m * (double)n * (double)k; break;
-        case OP_MV:   flops = 2.0 * (double)m * (double)n; break;
-        case OP_DOT:  flops = 2.0 * (double)len; break;
-        case OP_AXPY: flops = 2.0 * (double)len; break;
-        default: break;
+        case OP_MM:   return 2.0 * (double)m * (double)n * (double)k;
+        case OP_MV:   return 2.0 * (double)m * (double)n;
+        case OP_DOT:  return 2.0 * (double)len;
+        case OP_AXPY: return 2.0 * (double)len;
+        case OP_SPMV: return 2.0 * (double)len;   /* len = nnz */
+        case OP_MMB:  return 2.0 * (double)len * m * n * k;   /* len = items, m x k by k x n each */
+        case OP_MVB:  return 2.0 * (double)len * m * n;
+        case OP_SYRK: return (double)n * (n + 1) * (double)k;   /* one triangle of n x n, k deep */
+        case OP_SYMV: return 2.0 * (double)n * (double)n;
+        case OP_TRMV: return (double)n * (n + 1);
+        default:      return 0.0;
     }
-    return (flops / 1e9) / sec;
 }
 
-static void print_csv_header_stdout(void) {
-    printf("op,m,n,k,threads,seconds,gflops,speedup,efficiency,format\n");
+static double gflops_for(Op op, size_t m, size_t n, size_t k, size_t len, double sec) {
+    if (sec <= 0) return 0.0;
+    return (flops_for(op, m, n, k, len) / 1e9) / sec;
 }
 
-static void print_csv_row_stdout(const char *op,
-                                 size_t m, size_t n, size_t k,
-                                 int threads,
-                                 double seconds,
-                                 double gflops,
-                                 double speedup,
-                                 double efficiency,
-                                 const char *fmt_name) {
-    printf("%s,%zu,%zu,%zu,%d,%.9f,%.6f,%.4f,%.2f,%s\n",
-           op, m, n, k, threads, seconds, gflops, speedup, efficiency, fmt_name ? fmt_name : "");
+/* Compulsory memory traffic of one call: every operand read once, every result written once. */
+static double bytes_for(Op op, size_t m, size_t n, size_t k, size_t len, size_t esz) {
+    double e = (double)esz;
+    switch (op) {
+        case OP_MM:   return e * ((double)m * k + (double)k * n + (double)m * n);
+        case OP_MV:   return e * ((double)m * n + n + m);
+        case OP_DOT:  return e * 2.0 * (double)len;
+        case OP_AXPY: return e * 3.0 * (double)len;
+        case OP_SPMV: return e * ((double)len + n + m) + sizeof(uint32_t) * (double)len +
+                             sizeof(size_t) * ((double)m + 1);
+        case OP_MMB:  return e * (double)len * ((double)m * k + (double)k * n + (double)m * n);
+        case OP_MVB:  return e * (double)len * ((double)m * n + n + m);
+        case OP_SYRK: return e * ((double)n * k + (double)tri_len(n));
+        case OP_SYMV:
+        case OP_TRMV: return e * ((double)tri_len(n) + 2.0 * n);
+        default:      return 0.0;
+    }
 }
 
+#define MAX_COUNTS 64
+
+/*
+ * Thread counts for --threads-sweep: a comma list, or "auto" for powers
+ * of two up to the online CPU count plus the count itself.
+ */
+static int parse_counts(const char *s, int *counts, int *n) {
+    *n = 0;
+    if (strcmp(s, "auto") == 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        if (ncpu < 1) ncpu = 1;
+        if (ncpu > POOL_MAX_THREADS) ncpu = POOL_MAX_THREADS;
+        for (long t = 1; t < ncpu && *n < MAX_COUNTS - 1; t *= 2) counts[(*n)++] = (int)t;
+        counts[(*n)++] = (int)ncpu;
+        return 0;
+    }
+    while (*s) {
+        char *end;
+        long t = strtol(s, &end, 10);
+        if (end == s || t < 1 || t > POOL_MAX_THREADS || *n == MAX_COUNTS) return -1;
+        counts[(*n)++] = (int)t;
+        if (*end == ',') end++;
+        else if (*end) return -1;
+        s = end;
+    }
+    return *n > 0 ? 0 : -1;
+}
 
-
+/* "64M"-style byte counts: a number with an optional K, M or G (binary) suffix. */
+static int parse_bytes(const char *s, size_t *out) {
+    char *end;
+    double v = strtod(s, &end);
+    double mul = 1.0;
+    switch (*end) {
+        case 'k': case 'K': mul = 1024.0; end++; break;
+        case 'm': case 'M': mul = 1024.0 * 1024.0; end++; break;
+        case 'g': case 'G': mul = 1024.0 * 1024.0 * 1024.0; end++; break;
+        default: break;
+    }
+    if (end == s || *end != '\0' || v <= 0.0) return -1;
+    *out = (size_t)(v * mul);
+    return 0;
+}
 
 static void print_vector_preview(const Vec *v, size_t maxn) {
     size_t n = v->len < maxn ? v->len : maxn;
     printf("[");
     for (size_t i = 0; i < n; i++) {
-        printf("%.6g%s", v->data[i], (i + 1 == n) ? "" : ", ");
+        printf("%.6g%s", v_get(v, i), (i + 1 == n) ? "" : ", ");
     }
     if (v->len > n) printf(", ...");
     printf("]\n");
@@ -115,7 +283,7 @@ static void print_matrix_preview(const Mat *m, size_t maxr, size_t maxc) {
     for (size_t i = 0; i < r; i++) {
         printf("[");
         for (size_t j = 0; j < c; j++) {
-            printf("%.6g%s", m->data[i*m->cols + j], (j + 1 == c) ? "" : ", ");
+            printf("%.6g%s", m_get(m, i, j), (j + 1 == c) ? "" : ", ");
         }
         if (m->cols > c) printf(", ...");
         printf("]\n");
@@ -123,294 +291,869 @@ static void print_matrix_preview(const Mat *m, size_t maxr, size_t maxc) {
     if (m->rows > r) printf("...\n");
 }
 
-static int prep_logging(const char *out_base, const char *op, char *csv_path, size_t csv_path_sz) {
-    (void)out_base;  // Unused: CSV files disabled
-    (void)csv_path_sz;
-    csv_path[0] = '\0';  // Clear path
-    printf("\n[%s] Results:\n", op);
-    print_csv_header_stdout();
-    return 0;
+/* Settings shared by every op of one run. */
+typedef struct {
+    const char *out_base;
+    FileFmt fmt;
+    const LoadOpts *lo;
+    OpCache *oc;
+    KCfg cfg;
+    BenchOpts bo;
+    int counts[MAX_COUNTS];   /* thread counts to time; speedup is relative to the first */
+    int ncounts;
+    int sparse;               /* --A is a CSR file: mv runs spmv_mt, mm is skipped */
+    int roofline;             /* probe roofs[] once and report bounds against them */
+    Roof roofs[MAX_COUNTS];
+    size_t ooc_budget;        /* --ooc: stream A/B from their files within this many bytes */
+    size_t batch;             /* --batch: A, B and x hold this many stacked mm/mv items */
+    Profile *prof;            /* tuning profile, or NULL with --profile none */
+    int autotune;             /* search each op's settings and store them in prof */
+    unsigned fixed;           /* TUNE_FIX_* settings given on the command line */
+    int max_nt;               /* pool size: the most threads a search tries */
+    HugeMode huge;            /* --huge: report resident huge pages after each op */
+    Trans ta, tb;             /* --trans-a/--trans-b: mm and mv use A^T, B^T in place */
+    Uplo uplo;                /* syrk/symv/trmv: stored triangle */
+    int packed;               /* symv/trmv: --A is a packed triangle file */
+    FileFmt to;               /* convert: output format */
+    Codec codec;              /* convert to chunk: tile codec */
+} RunCtx;
+
+static LoadOpts with_advice(const LoadOpts *lo, MapAdvice adv) {
+    LoadOpts o = *lo;
+    o.advice = adv;
+    return o;
 }
 
-static void run_bench(const char *op, size_t m, size_t n, size_t k, size_t len,
-                      int nt1, int ntN, double sec1, double secN,
-                      const char *csv_path, const char *fmt_name) {
-    (void)csv_path;  // Unused: CSV output disabled
-    double g1 = gflops_for((strcmp(op,"mm")==0 ? OP_MM : strcmp(op,"mv")==0 ? OP_MV : strcmp(op,"dot")==0 ? OP_DOT : OP_AXPY), m, n, k, len, sec1);
-    double gN = gflops_for((strcmp(op,"mm")==0 ? OP_MM : strcmp(op,"mv")==0 ? OP_MV : strcmp(op,"dot")==0 ? OP_DOT : OP_AXPY), m, n, k, len, secN);
-    double sp = (secN > 0.0) ? (sec1 / secN) : 0.0;
-    double eff = (ntN > 0) ? (100.0 * sp / (double)ntN) : 0.0;
-    print_csv_row_stdout(op, m, n, k, nt1, sec1, g1, 1.0, 100.0, fmt_name);
-    print_csv_row_stdout(op, m, n, k, ntN, secN, gN, sp, eff, fmt_name);
+/* Result buffers follow the input placement policy; otherwise they are recycled through the arena. */
+static Mat out_mat(size_t r, size_t c, const LoadOpts *lo) {
+    return lo->numa ? m_alloc_local(r, c, lo->dt, lo->pool, lo->nt) : m_alloc_arena(r, c, lo->dt);
 }
 
-static int do_mm(const char *out_base, FileFmt fmt,
-                 const char *Apath, const char *Bpath,
-                 int nt, int rep, int tile) {
-    if (!Apath || !Bpath) {
-        printf("\n[mm] Skipped: need --A and --B\n");
+static Vec out_vec(size_t n, const LoadOpts *lo) {
+    return lo->numa ? v_alloc_local(n, lo->dt, lo->pool, lo->nt) : v_alloc_arena(n, lo->dt);
+}
+
+/*
+ * Times fn at every thread count of the run and reports one row per
+ * count. *cfg is the KCfg inside arg that fn passes to the kernel.
+ * Returns 0, -1 if the kernel failed, or 2 if interrupted.
+ */
+static int bench_counts(const RunCtx *rc, Op op, BenchFn fn, BenchPrep prep, void *arg, KCfg *cfg,
+                        size_t m, size_t n, size_t k, size_t len) {
+    Report rep;
+    if (report_open(&rep, rc->out_base, op_name(op)) != 0) return -1;
+
+    BenchRow row = { .op = op_name(op), .fmt = fmt_name(rc->fmt),
+                     .isa = simd_ops()->name, .dtype = dtype_name(rc->lo->dt, rc->cfg.acc),
+                     .m = m, .n = n, .k = k, .len = len };
+    PerfCount per[POOL_MAX_THREADS];
+    double base = 0.0;
+    int status = 0;
+    for (int i = 0; i < rc->ncounts && status == 0; i++) {
+        cfg->nt = rc->counts[i];
+        status = bench_run(fn, prep, arg, &rc->bo, &row.st);
+        if (status != 0) break;
+        if (i == 0) base = row.st.median;
+        row.threads = rc->counts[i];
+        row.gflops = gflops_for(op, m, n, k, len, row.st.median);
+        row.speedup = row.st.median > 0.0 ? base / row.st.median : 0.0;
+        row.efficiency = 100.0 * row.speedup * rc->counts[0] / row.threads;
+        double flops = flops_for(op, m, n, k, len);
+        double bytes = bytes_for(op, m, n, k, len, dt_size(rc->lo->dt));
+        row.gbs = row.st.median > 0.0 ? bytes / row.st.median / 1e9 : 0.0;
+        if (rc->roofline) {
+            /* The probe measures f64; a vector holds twice as many floats. */
+            Roof r = rc->roofs[i];
+            if (rc->lo->dt == DT_F32) r.gflops *= 2.0;
+            int mem;
+            row.roof = roof_bound(&r, flops, bytes, &mem);
+            row.bound = mem ? "mem" : "compute";
+        }
+        if (rc->bo.perf && row.st.calls > 0 &&
+            perf_read(rc->bo.perf, row.threads, per, &row.perf) > 0) {
+            double inv = 1.0 / (double)row.st.calls;
+            for (int e = 0; e < PE_NEV; e++) {
+                row.perf.v[e] *= inv;
+                for (int t = 0; t < row.threads; t++) per[t].v[e] *= inv;
+            }
+            row.perf_per = per;
+        }
+        report_row(&rep, &row);
+    }
+    report_close(&rep);
+
+    /* Operands and results are still mapped here, so this shows what the op ran on. */
+    size_t thp, htlb;
+    if (rc->huge != HUGE_OFF && arena_huge_resident(&thp, &htlb) == 0)
+        printf("[%s] huge pages resident: %.1f MiB THP, %.1f MiB hugetlbfs\n", op_name(op),
+               (double)thp / (1024.0 * 1024.0), (double)htlb / (1024.0 * 1024.0));
+
+    if (status == 2) fprintf(stderr, "[%s] Interrupted\n", op_name(op));
+    else if (status != 0) fprintf(stderr, "[%s] Kernel failed\n", op_name(op));
+    return status;
+}
+
+/*
+ * Starts op with its profile entry: searched now with --autotune, else
+ * looked up by size class. The entry's settings go into *cfg and, unless
+ * threads were given, its thread count into out->counts. *out is *rc
+ * otherwise. Returns 0, -1 if a candidate failed, or 2 if interrupted.
+ */
+static int tune_op(const RunCtx *rc, Op op, BenchFn fn, BenchPrep prep, void *arg, KCfg *cfg,
+                   size_t m, size_t n, size_t k, size_t len, RunCtx *out) {
+    *out = *rc;
+    if (!rc->prof) return 0;
+    const int is_mm = op == OP_MM;
+    TuneEntry key = { .cls = tune_class(bytes_for(op, m, n, k, len, dt_size(rc->lo->dt))) };
+    /* Each transpose pattern has its own kernels, so it is tuned under its own name. */
+    if (op == OP_MM && (rc->ta == TR_T || rc->tb == TR_T))
+        snprintf(key.op, sizeof(key.op), "mm_%c%c", rc->ta == TR_T ? 't' : 'n', rc->tb == TR_T ? 't' : 'n');
+    else if (op == OP_MV && rc->ta == TR_T)
+        snprintf(key.op, sizeof(key.op), "mv_t");
+    else
+        snprintf(key.op, sizeof(key.op), "%s", op_name(op));
+    snprintf(key.dtype, sizeof(key.dtype), "%s", dtype_name(rc->lo->dt, rc->cfg.acc));
+    snprintf(key.isa, sizeof(key.isa), "%s", simd_ops()->name);
+
+    const TuneEntry *e;
+    int trials = 0;
+    if (rc->autotune) {
+        KCfg keep = *cfg;
+        trials = tune_search(fn, prep, arg, cfg, is_mm, rc->lo->dt == DT_F64, rc->max_nt,
+                             flops_for(op, m, n, k, len), &key);
+        *cfg = keep;
+        if (trials < 0) return trials == -2 ? 2 : -1;
+        if (profile_put(rc->prof, &key) != 0) return -1;
+        e = &key;
+    } else if (!(e = profile_find(rc->prof, key.op, key.dtype, key.isa, key.cls))) {
         return 0;
     }
 
-    char csv_path[PATH_MAX];
-    if (prep_logging(out_base, "mm", csv_path, sizeof(csv_path)) != 0) return -1;
+    if (is_mm && !(rc->fixed & TUNE_FIX_TILE) && e->tile > 0) cfg->tile = e->tile;
+    if (is_mm && !(rc->fixed & TUNE_FIX_ALGO)) {
+        cfg->mm_algo = e->algo;
+        cfg->mc = e->mc; cfg->kc = e->kc; cfg->nc = e->nc;
+    }
+    if (!(rc->fixed & TUNE_FIX_THREADS)) {
+        int t = e->threads < rc->max_nt ? e->threads : rc->max_nt;
+        out->counts[0] = 1;
+        out->counts[1] = t;
+        out->ncounts = t > 1 ? 2 : 1;
+    }
+    /* What this run uses, which is the entry unless the command line overrode it. */
+    printf("\n[tune] %s %s %s class %d: ", key.op, key.dtype, key.isa, key.cls);
+    if (is_mm) {
+        printf("%s", cfg->mm_algo == MM_PACKED ? "packed" : cfg->mm_algo == MM_RECURSIVE ? "recursive" : "tiled");
+        if (cfg->mm_algo == MM_PACKED) printf(" mc=%d kc=%d", cfg->mc, cfg->kc);
+        else if (cfg->mm_algo == MM_TILED) printf(" tile=%d", cfg->tile);
+        printf(", ");
+    }
+    printf("%d thread(s) (tuned: %d thread(s) at %.3f GFLOPS, ", out->counts[out->ncounts - 1],
+           e->threads, e->gflops);
+    if (trials > 0) printf("searched %d candidate(s))\n", trials);
+    else printf("profile class %d)\n", e->cls);
+    return 0;
+}
 
-    const char *fmt_name = (fmt == FMT_BIN) ? "bin" : "text";
-    KCfg cfg = { .nt = nt, .tile = tile };
-    KCfg cfg1 = cfg; cfg1.nt = 1;
+typedef struct { const Mat *A, *B; Mat *C; KCfg cfg; Trans ta, tb; } MMArgs;
+typedef struct { const Mat *A; const Vec *x; Vec *y; KCfg cfg; Trans ta; } MVArgs;
+typedef struct { const Csr *A; const Vec *x; Vec *y; KCfg cfg; } SpMVArgs;
+typedef struct { const Mat *A; Tri *C; KCfg cfg; Trans ta; } SyrkArgs;
+typedef struct { const Tri *A; const Vec *x; Vec *y; KCfg cfg; } TriArgs;
+typedef struct { const Mat *A, *B; Mat *C; const Vec *x; Vec *y; size_t count; KCfg cfg; } BatchArgs;
+typedef struct { const Vec *x, *y; double out; KCfg cfg; } DotArgs;
+typedef struct { double a; const Vec *x, *y0; Vec *y; size_t bytes; KCfg cfg; } AxpyArgs;
+
+static int mm_call(void *p)  { MMArgs *a = p;  return mm_mt(a->A, a->ta, a->B, a->tb, a->C, a->cfg); }
+static int mv_call(void *p)  { MVArgs *a = p;  return mv_mt(a->A, a->ta, a->x, a->y, a->cfg); }
+static int spmv_call(void *p) { SpMVArgs *a = p; return spmv_mt(a->A, a->x, a->y, a->cfg); }
+static int syrk_call(void *p) { SyrkArgs *a = p; return syrk_mt(a->A, a->ta, a->C, a->cfg); }
+static int symv_call(void *p) { TriArgs *a = p; return symv_mt(a->A, a->x, a->y, a->cfg); }
+static int trmv_call(void *p) { TriArgs *a = p; return trmv_mt(a->A, a->x, a->y, a->cfg); }
+static int mmb_call(void *p) { BatchArgs *a = p; return mm_batch(a->A, a->B, a->C, a->count, a->cfg); }
+static int mvb_call(void *p) { BatchArgs *a = p; return mv_batch(a->A, a->x, a->y, a->count, a->cfg); }
+static int dot_call(void *p) { DotArgs *a = p; return dt_mt(a->x, a->y, &a->out, a->cfg); }
+static int ax_call(void *p)  { AxpyArgs *a = p; return ax_mt(a->a, a->x, a->y, a->cfg); }
+
+/* axpy updates y in place: every timed call starts from the loaded y. */
+static void ax_prep(void *p) {
+    AxpyArgs *a = p;
+    memcpy(a->y->data, a->y0->data, a->bytes);
+}
 
-    Mat A={0}, B={0};
-    if (m_load(Apath, fmt, &A) || m_load(Bpath, fmt, &B)) {
-        fprintf(stderr, "[mm] Failed to load A/B\n");
+/*
+ * Compares C against the classic tiled product: the max elementwise
+ * error, absolute and relative to max |C_ref|.
+ */
+static int mm_accuracy(const Mat *A, Trans ta, const Mat *B, Trans tb, const Mat *C, KCfg cfg) {
+    Mat R = m_alloc_arena(C->rows, C->cols, C->dt);
+    if (!R.data) return -1;
+    cfg.mm_algo = MM_TILED;
+    if (cfg.tile <= 0) cfg.tile = 64;
+    int status = mm_mt(A, ta, B, tb, &R, cfg);
+    if (status == 0) {
+        double err = 0.0, ref = 0.0;
+        for (size_t i = 0; i < C->rows; i++) {
+            for (size_t j = 0; j < C->cols; j++) {
+                double r = m_get(&R, i, j), d = m_get(C, i, j) - r;
+                if (d < 0) d = -d;
+                if (r < 0) r = -r;
+                if (d > err) err = d;
+                if (r > ref) ref = r;
+            }
+        }
+        printf("accuracy vs tiled: max_abs_err=%.3e max_rel_err=%.3e (strassen=%d)\n",
+               err, ref > 0 ? err / ref : 0.0, cfg.strassen);
+    }
+    m_free(&R);
+    return status;
+}
+
+/* --ooc: one timed call is a full streaming pass over the files. */
+typedef struct { const char *A, *B; const Vec *x; Vec *y; Mat *C; OocOpts o; OocStats st; KCfg cfg; } OocArgs;
+
+static int ooc_mm_call(void *p) { OocArgs *a = p; return ooc_mm(a->A, a->B, a->C, &a->o, a->cfg, &a->st); }
+static int ooc_mv_call(void *p) { OocArgs *a = p; return ooc_mv(a->A, a->x, a->y, &a->o, a->cfg, &a->st); }
+
+/* Tile shape, peak buffer use and how much of the last pass waited on I/O. */
+static void print_ooc(const char *op, const OocStats *st) {
+    double mb = 1024.0 * 1024.0;
+    printf("[ooc] %s: tile %zux%zu, %d pass(es), peak %.1f MiB, read %.1f MiB at %.2f GB/s, stalled %.3f s\n",
+           op, st->mb, st->kb, st->passes, (double)st->peak / mb, (double)st->bytes / mb,
+           st->read_s > 0.0 ? (double)st->bytes / st->read_s / 1e9 : 0.0, st->wait_s);
+}
+
+static int do_mm_ooc(const RunCtx *rc, const char *Apath, const char *Bpath) {
+    size_t m, k, kb, n;
+    DType dt;
+    if (m_bin_info(Apath, &m, &k, &dt) != 0 || m_bin_info(Bpath, &kb, &n, &dt) != 0) {
+        fprintf(stderr, "[mm] Failed to read A/B headers\n");
         return -1;
     }
-    if (A.cols != B.rows) {
-        fprintf(stderr, "[mm] Dimension mismatch: A=%zux%zu, B=%zux%zu\n", A.rows, A.cols, B.rows, B.cols);
-        m_free(&A); m_free(&B);
+    if (k != kb) {
+        fprintf(stderr, "[mm] Dimension mismatch: A=%zux%zu, B=%zux%zu\n", m, k, kb, n);
         return -1;
     }
-
-    Mat C1 = m_alloc(A.rows, B.cols);
-    Mat CN = m_alloc(A.rows, B.cols);
-    if (!C1.data || !CN.data) {
+    Mat C = out_mat(m, n, rc->lo);
+    if (!C.data) {
         fprintf(stderr, "[mm] Allocation failure\n");
-        m_free(&A); m_free(&B);
-        m_free(&C1); m_free(&CN);
         return -1;
     }
 
-    double total1 = 0.0;
-    for (int r = 0; r < rep && !g_stop; r++) {
-        double t0 = now_s();
-        mm_mt(&A, &B, &C1, cfg1);
-        total1 += now_s() - t0;
+    OocArgs args = { .A = Apath, .B = Bpath, .C = &C, .o = { rc->ooc_budget }, .cfg = rc->cfg };
+    int status = bench_counts(rc, OP_MM, ooc_mm_call, NULL, &args, &args.cfg, m, n, k, 0);
+    if (status == 0) {
+        print_ooc("mm", &args.st);
+        printf("C preview (top-left):\n");
+        print_matrix_preview(&C, 4, 4);
     }
-    if (g_stop) {
-        fprintf(stderr, "[mm] Interrupted\n");
-        m_free(&A); m_free(&B); m_free(&C1); m_free(&CN);
-        return 2;
+
+    m_free(&C);
+    return status;
+}
+
+static int do_mv_ooc(const RunCtx *rc, const char *Apath, const char *xpath) {
+    size_t m, n;
+    DType dt;
+    LoadOpts lx = with_advice(rc->lo, ADV_WILLNEED);
+    const Vec *x = oc_vec(rc->oc, xpath, rc->fmt, &lx);
+    if (!x || m_bin_info(Apath, &m, &n, &dt) != 0) {
+        fprintf(stderr, "[mv] Failed to load A header/x\n");
+        return -1;
+    }
+    if (n != x->len) {
+        fprintf(stderr, "[mv] Dimension mismatch: A=%zux%zu, x=%zu\n", m, n, x->len);
+        return -1;
+    }
+    Vec y = out_vec(m, rc->lo);
+    if (!y.data) {
+        fprintf(stderr, "[mv] Allocation failure\n");
+        return -1;
+    }
+
+    OocArgs args = { .A = Apath, .x = x, .y = &y, .o = { rc->ooc_budget }, .cfg = rc->cfg };
+    args.cfg.tile = 0;
+    int status = bench_counts(rc, OP_MV, ooc_mv_call, NULL, &args, &args.cfg, m, n, 0, 0);
+    if (status == 0) {
+        print_ooc("mv", &args.st);
+        printf("y preview:\n");
+        print_vector_preview(&y, 10);
     }
 
-    double totalN = 0.0;
-    for (int r = 0; r < rep && !g_stop; r++) {
-        double t0 = now_s();
-        mm_mt(&A, &B, &CN, cfg);
-        totalN += now_s() - t0;
+    v_free(&y);
+    return status;
+}
+
+/*
+ * --batch N: row block b of A (and of B, C) is item b, and so is slice b
+ * of x and y. Items are views into the loaded operands.
+ */
+static int do_mm_batch(const RunCtx *rc, const Mat *A, const Mat *B) {
+    const size_t cnt = rc->batch, m = A->rows / cnt, k = A->cols, n = B->cols;
+    if (A->rows % cnt != 0 || B->rows != cnt * k) {
+        fprintf(stderr, "[mm_batch] A=%zux%zu, B=%zux%zu do not split into %zu items\n",
+                A->rows, A->cols, B->rows, B->cols, cnt);
+        return -1;
+    }
+    Mat C = out_mat(A->rows, n, rc->lo);
+    Mat *items = malloc(3 * cnt * sizeof(Mat));
+    if (!C.data || !items) {
+        fprintf(stderr, "[mm_batch] Allocation failure\n");
+        m_free(&C); free(items);
+        return -1;
     }
-    if (g_stop) {
-        fprintf(stderr, "[mm] Interrupted\n");
-        m_free(&A); m_free(&B); m_free(&C1); m_free(&CN);
-        return 2;
+    Mat *As = items, *Bs = items + cnt, *Cs = items + 2 * cnt;
+    for (size_t b = 0; b < cnt; b++) {
+        As[b] = m_view(A, b * m, 0, m, k);
+        Bs[b] = m_view(B, b * k, 0, k, n);
+        Cs[b] = m_view(&C, b * m, 0, m, n);
     }
 
-    double sec1 = total1 / (double)rep;
-    double secN = totalN / (double)rep;
-    run_bench("mm", A.rows, B.cols, A.cols, 0, 1, nt, sec1, secN, csv_path, fmt_name);
+    printf("\n[mm_batch] %zu items of %zux%zu * %zux%zu\n", cnt, m, k, k, n);
+    BatchArgs args = { .A = As, .B = Bs, .C = Cs, .count = cnt, .cfg = rc->cfg };
+    int status = bench_counts(rc, OP_MMB, mmb_call, NULL, &args, &args.cfg, m, n, k, cnt);
+    if (status == 0) {
+        printf("C[0] preview (top-left):\n");
+        print_matrix_preview(&Cs[0], 4, 4);
+    }
 
-    printf("C preview (top-left):\n");
-    print_matrix_preview(&CN, 4, 4);
+    free(items);
+    m_free(&C);
+    return status;
+}
 
-    m_free(&A); m_free(&B); m_free(&C1); m_free(&CN);
-    return g_stop ? 2 : 0;
+static int do_mv_batch(const RunCtx *rc, const Mat *A, const Vec *x) {
+    const size_t cnt = rc->batch, m = A->rows / cnt, n = A->cols;
+    if (A->rows % cnt != 0 || x->len != cnt * n) {
+        fprintf(stderr, "[mv_batch] A=%zux%zu, x=%zu do not split into %zu items\n",
+                A->rows, A->cols, x->len, cnt);
+        return -1;
+    }
+    Vec y = out_vec(A->rows, rc->lo);
+    Mat *As = malloc(cnt * sizeof(Mat));
+    Vec *vs = malloc(2 * cnt * sizeof(Vec));
+    if (!y.data || !As || !vs) {
+        fprintf(stderr, "[mv_batch] Allocation failure\n");
+        v_free(&y); free(As); free(vs);
+        return -1;
+    }
+    const size_t esz = dt_size(A->dt);
+    Vec *xs = vs, *ys = vs + cnt;
+    for (size_t b = 0; b < cnt; b++) {
+        As[b] = m_view(A, b * m, 0, m, n);
+        xs[b] = (Vec){ .len = n, .dt = x->dt, .mem = MEM_VIEW, .data = (double*)((char*)x->data + b * n * esz) };
+        ys[b] = (Vec){ .len = m, .dt = y.dt, .mem = MEM_VIEW, .data = (double*)((char*)y.data + b * m * esz) };
+    }
+
+    printf("\n[mv_batch] %zu items of %zux%zu\n", cnt, m, n);
+    BatchArgs args = { .A = As, .x = xs, .y = ys, .count = cnt, .cfg = rc->cfg };
+    args.cfg.tile = 0;
+    int status = bench_counts(rc, OP_MVB, mvb_call, NULL, &args, &args.cfg, m, n, 0, cnt);
+    if (status == 0) {
+        printf("y preview:\n");
+        print_vector_preview(&y, 10);
+    }
+
+    free(As); free(vs);
+    v_free(&y);
+    return status;
 }
 
-static int do_mv(const char *out_base, FileFmt fmt,
-                 const char *Apath, const char *xpath,
-                 int nt, int rep) {
-    if (!Apath || !xpath) {
-        printf("\n[mv] Skipped: need --A and --x\n");
+static int do_mm(const RunCtx *rc, const char *Apath, const char *Bpath) {
+    if (!Apath || !Bpath) {
+        printf("\n[mm] Skipped: need --A and --B\n");
+        return 0;
+    }
+    if (rc->sparse) {
+        printf("\n[mm] Skipped: --sparse A is only used by mv\n");
         return 0;
     }
 
-    char csv_path[PATH_MAX];
-    if (prep_logging(out_base, "mv", csv_path, sizeof(csv_path)) != 0) return -1;
+    if (rc->ooc_budget) return do_mm_ooc(rc, Apath, Bpath);
+
+    LoadOpts la = with_advice(rc->lo, ADV_SEQUENTIAL), lb = with_advice(rc->lo, ADV_WILLNEED);
+    const Mat *A = oc_mat(rc->oc, Apath, rc->fmt, &la);
+    const Mat *B = A ? oc_mat(rc->oc, Bpath, rc->fmt, &lb) : NULL;
+    if (!A || !B) {
+        fprintf(stderr, "[mm] Failed to load A/B\n");
+        return -1;
+    }
+    if (rc->batch) return do_mm_batch(rc, A, B);
+    /* m x k times k x n after the --trans-a/--trans-b flags are applied. */
+    const size_t m = rc->ta == TR_T ? A->cols : A->rows, k = rc->ta == TR_T ? A->rows : A->cols;
+    const size_t kb = rc->tb == TR_T ? B->cols : B->rows, n = rc->tb == TR_T ? B->rows : B->cols;
+    if (k != kb) {
+        fprintf(stderr, "[mm] Dimension mismatch: %s=%zux%zu, %s=%zux%zu\n", rc->ta == TR_T ? "A^T" : "A",
+                m, k, rc->tb == TR_T ? "B^T" : "B", kb, n);
+        return -1;
+    }
+    if (rc->ta == TR_T || rc->tb == TR_T)
+        printf("\n[mm] C = %s * %s (in place, no transposed copy)\n",
+               rc->ta == TR_T ? "A^T" : "A", rc->tb == TR_T ? "B^T" : "B");
+
+    Mat C = out_mat(m, n, rc->lo);
+    if (!C.data) {
+        fprintf(stderr, "[mm] Allocation failure\n");
+        return -1;
+    }
 
-    const char *fmt_name = (fmt == FMT_BIN) ? "bin" : "text";
-    KCfg cfg = { .nt = nt, .tile = 0 };
-    KCfg cfg1 = cfg; cfg1.nt = 1;
+    MMArgs args = { A, B, &C, rc->cfg, rc->ta, rc->tb };
+    RunCtx rt;
+    int status = tune_op(rc, OP_MM, mm_call, NULL, &args, &args.cfg, m, n, k, 0, &rt);
+    if (status == 0)
+        status = bench_counts(&rt, OP_MM, mm_call, NULL, &args, &args.cfg, m, n, k, 0);
+    if (status == 0) {
+        printf("C preview (top-left):\n");
+        print_matrix_preview(&C, 4, 4);
+        if (rc->cfg.mm_algo == MM_RECURSIVE && A->dt == DT_F64)
+            status = mm_accuracy(A, rc->ta, B, rc->tb, &C, args.cfg);
+    }
 
-    Mat A={0};
-    Vec x={0}, y1={0}, yN={0};
+    m_free(&C);
+    return status;
+}
 
-    if (m_load(Apath, fmt, &A) || v_load(xpath, fmt, &x)) {
-        fprintf(stderr, "[mv] Failed to load A/x\n");
+static int do_spmv(const RunCtx *rc, const char *Apath, const char *xpath) {
+    LoadOpts la = with_advice(rc->lo, ADV_SEQUENTIAL), lx = with_advice(rc->lo, ADV_WILLNEED);
+    const Csr *A = oc_csr(rc->oc, Apath, rc->fmt, &la);
+    const Vec *x = A ? oc_vec(rc->oc, xpath, rc->fmt, &lx) : NULL;
+    if (!A || !x) {
+        fprintf(stderr, "[spmv] Failed to load sparse A/x\n");
         return -1;
     }
-    if (A.cols != x.len) {
-        fprintf(stderr, "[mv] Dimension mismatch: A=%zux%zu, x=%zu\n", A.rows, A.cols, x.len);
-        m_free(&A); v_free(&x);
+    if (A->cols != x->len) {
+        fprintf(stderr, "[spmv] Dimension mismatch: A=%zux%zu, x=%zu\n", A->rows, A->cols, x->len);
         return -1;
     }
 
-    y1 = v_alloc(A.rows);
-    yN = v_alloc(A.rows);
+    Vec y = out_vec(A->rows, rc->lo);
+    if (!y.data) {
+        fprintf(stderr, "[spmv] Allocation failure\n");
+        return -1;
+    }
 
-    double total1=0.0;
-    for (int r=0; r<rep && !g_stop; r++) {
-        double t0 = now_s();
-        mv_mt(&A, &x, &y1, cfg1);
-        total1 += now_s() - t0;
+    printf("\n[spmv] A=%zux%zu nnz=%zu (%.3g%% dense)\n", A->rows, A->cols, A->nnz,
+           100.0 * (double)A->nnz / ((double)A->rows * (double)A->cols));
+    SpMVArgs args = { A, x, &y, rc->cfg };
+    int status = bench_counts(rc, OP_SPMV, spmv_call, NULL, &args, &args.cfg,
+                              A->rows, A->cols, 0, A->nnz);
+    if (status == 0) {
+        printf("y preview:\n");
+        print_vector_preview(&y, 10);
     }
-    if (g_stop) {
-        fprintf(stderr, "[mv] Interrupted\n");
-        m_free(&A); v_free(&x); v_free(&y1); v_free(&yN);
-        return 2;
+
+    v_free(&y);
+    return status;
+}
+
+static int do_mv(const RunCtx *rc, const char *Apath, const char *xpath) {
+    if (!Apath || !xpath) {
+        printf("\n[mv] Skipped: need --A and --x\n");
+        return 0;
     }
+    if (rc->sparse) return do_spmv(rc, Apath, xpath);
+    if (rc->ooc_budget) return do_mv_ooc(rc, Apath, xpath);
 
-    double totalN=0.0;
-    for (int r=0; r<rep && !g_stop; r++) {
-        double t0 = now_s();
-        mv_mt(&A, &x, &yN, cfg);
-        totalN += now_s() - t0;
+    LoadOpts la = with_advice(rc->lo, ADV_SEQUENTIAL), lx = with_advice(rc->lo, ADV_WILLNEED);
+    const Mat *A = oc_mat(rc->oc, Apath, rc->fmt, &la);
+    const Vec *x = A ? oc_vec(rc->oc, xpath, rc->fmt, &lx) : NULL;
+    if (!A || !x) {
+        fprintf(stderr, "[mv] Failed to load A/x\n");
+        return -1;
     }
-    if (g_stop) {
-        fprintf(stderr, "[mv] Interrupted\n");
-        m_free(&A); v_free(&x); v_free(&y1); v_free(&yN);
-        return 2;
+    if (rc->batch) return do_mv_batch(rc, A, x);
+    const size_t m = rc->ta == TR_T ? A->cols : A->rows, n = rc->ta == TR_T ? A->rows : A->cols;
+    if (n != x->len) {
+        fprintf(stderr, "[mv] Dimension mismatch: %s=%zux%zu, x=%zu\n", rc->ta == TR_T ? "A^T" : "A",
+                m, n, x->len);
+        return -1;
     }
+    if (rc->ta == TR_T) printf("\n[mv] y = A^T * x (in place, no transposed copy)\n");
 
-    double sec1 = total1 / (double)rep;
-    double secN = totalN / (double)rep;
-    run_bench("mv", A.rows, A.cols, 0, 0, 1, nt, sec1, secN, csv_path, fmt_name);
-
-    printf("y preview:\n");
-    print_vector_preview(&yN, 10);
+    Vec y = out_vec(m, rc->lo);
+    if (!y.data) {
+        fprintf(stderr, "[mv] Allocation failure\n");
+        return -1;
+    }
 
+    MVArgs args = { A, x, &y, rc->cfg, rc->ta };
+    args.cfg.tile = 0;
+    RunCtx rt;
+    int status = tune_op(rc, OP_MV, mv_call, NULL, &args, &args.cfg, m, n, 0, 0, &rt);
+    if (status == 0) status = bench_counts(&rt, OP_MV, mv_call, NULL, &args, &args.cfg, m, n, 0, 0);
+    if (status == 0) {
+        printf("y preview:\n");
+        print_vector_preview(&y, 10);
+    }
 
-    m_free(&A); v_free(&x); v_free(&y1); v_free(&yN);
-    return g_stop ? 2 : 0;
+    v_free(&y);
+    return status;
 }
 
-static int do_dot(const char *out_base, FileFmt fmt,
-                  const char *xpath, const char *ypath,
-                  int nt, int rep) {
+static int do_dot(const RunCtx *rc, const char *xpath, const char *ypath) {
     if (!xpath || !ypath) {
         printf("\n[dot] Skipped: need --x and --y\n");
         return 0;
     }
 
-    char csv_path[PATH_MAX];
-    if (prep_logging(out_base, "dot", csv_path, sizeof(csv_path)) != 0) return -1;
-
-    const char *fmt_name = (fmt == FMT_BIN) ? "bin" : "text";
-    Vec x={0}, y={0};
-
-    if (v_load(xpath, fmt, &x) || v_load(ypath, fmt, &y)) {
+    LoadOpts lv = with_advice(rc->lo, ADV_SEQUENTIAL);
+    const Vec *x = oc_vec(rc->oc, xpath, rc->fmt, &lv);
+    const Vec *y = x ? oc_vec(rc->oc, ypath, rc->fmt, &lv) : NULL;
+    if (!x || !y) {
         fprintf(stderr, "[dot] Failed to load x/y\n");
         return -1;
     }
-    if (x.len != y.len) {
-        fprintf(stderr, "[dot] Dimension mismatch: x=%zu, y=%zu\n", x.len, y.len);
-        v_free(&x); v_free(&y);
+    if (x->len != y->len) {
+        fprintf(stderr, "[dot] Dimension mismatch: x=%zu, y=%zu\n", x->len, y->len);
         return -1;
     }
 
-    double out1=0.0, outN=0.0;
-    double total1=0.0;
-    for (int r=0; r<rep && !g_stop; r++) {
-        double t0 = now_s();
-        dt_mt(&x, &y, &out1, 1);
-        total1 += now_s() - t0;
+    DotArgs args = { x, y, 0.0, rc->cfg };
+    args.cfg.tile = 0;
+    RunCtx rt;
+    int status = tune_op(rc, OP_DOT, dot_call, NULL, &args, &args.cfg, 0, 0, 0, x->len, &rt);
+    if (status == 0) status = bench_counts(&rt, OP_DOT, dot_call, NULL, &args, &args.cfg, 0, 0, 0, x->len);
+    if (status == 0) {
+        /* With --reduce fast the sum order depends on the thread count: show the first count's result too. */
+        double outN = args.out;
+        args.cfg.nt = rt.counts[0];
+        dot_call(&args);
+        printf("dot = %.17g (%dt), %.17g (%dt)\n", args.out, rt.counts[0],
+               outN, rt.counts[rt.ncounts - 1]);
     }
-    if (g_stop) {
-        fprintf(stderr, "[dot] Interrupted\n");
-        v_free(&x); v_free(&y);
-        return 2;
+    return status;
+}
+
+static int do_axpy(const RunCtx *rc, double a, const char *xpath, const char *ypath) {
+    if (!xpath || !ypath) {
+        printf("\n[axpy] Skipped: need --x and --y\n");
+        return 0;
     }
 
-    double totalN=0.0;
-    for (int r=0; r<rep && !g_stop; r++) {
-        double t0 = now_s();
-        dt_mt(&x, &y, &outN, nt);
-        totalN += now_s() - t0;
+    /* y is cached read-only: every call updates a restored copy of it. */
+    LoadOpts lv = with_advice(rc->lo, ADV_SEQUENTIAL);
+    const Vec *x = oc_vec(rc->oc, xpath, rc->fmt, &lv);
+    const Vec *y0 = x ? oc_vec(rc->oc, ypath, rc->fmt, &lv) : NULL;
+    if (!x || !y0) {
+        fprintf(stderr, "[axpy] Failed to load x/y\n");
+        return -1;
     }
-    if (g_stop) {
-        fprintf(stderr, "[dot] Interrupted\n");
-        v_free(&x); v_free(&y);
-        return 2;
+    if (x->len != y0->len) {
+        fprintf(stderr, "[axpy] Dimension mismatch: x=%zu, y=%zu\n", x->len, y0->len);
+        return -1;
     }
 
-    double sec1 = total1 / (double)rep;
-    double secN = totalN / (double)rep;
-    run_bench("dot", 0, 0, 0, x.len, 1, nt, sec1, secN, csv_path, fmt_name);
+    Vec y = out_vec(y0->len, rc->lo);
+    if (!y.data) {
+        fprintf(stderr, "[axpy] Allocation failure\n");
+        return -1;
+    }
 
-    printf("dot = %.17g (1t), %.17g (%dt)\n", out1, outN, nt);
+    AxpyArgs args = { a, x, y0, &y, dt_size(y0->dt) * y0->len, rc->cfg };
+    args.cfg.tile = 0;
+    RunCtx rt;
+    int status = tune_op(rc, OP_AXPY, ax_call, ax_prep, &args, &args.cfg, 0, 0, 0, x->len, &rt);
+    if (status == 0) status = bench_counts(&rt, OP_AXPY, ax_call, ax_prep, &args, &args.cfg, 0, 0, 0, x->len);
+    if (status == 0) {
+        printf("alpha=%.6g, y preview:\n", a);
+        print_vector_preview(&y, 10);
+    }
 
-    v_free(&x); v_free(&y);
-    return g_stop ? 2 : 0;
+    v_free(&y);
+    return status;
 }
 
-static int do_axpy(const char *out_base, FileFmt fmt,
-                   double a, const char *xpath, const char *ypath,
-                   int nt, int rep) {
-    if (!xpath || !ypath) {
-        printf("\n[axpy] Skipped: need --x and --y\n");
-        return 0;
+static void print_tri_preview(const Tri *T, int sym, size_t maxn) {
+    size_t r = T->n < maxn ? T->n : maxn;
+    for (size_t i = 0; i < r; i++) {
+        printf("[");
+        for (size_t j = 0; j < r; j++)
+            printf("%.6g%s", sym ? tri_sym_get(T, i, j) : tri_get(T, i, j), (j + 1 == r) ? "" : ", ");
+        if (T->n > r) printf(", ...");
+        printf("]\n");
     }
+    if (T->n > r) printf("...\n");
+}
 
-    char csv_path[PATH_MAX];
-    if (prep_logging(out_base, "axpy", csv_path, sizeof(csv_path)) != 0) return -1;
-
-    const char *fmt_name = (fmt == FMT_BIN) ? "bin" : "text";
-    Vec x={0}, y1={0}, yN={0};
-
-    if (v_load(xpath, fmt, &x) || v_load(ypath, fmt, &y1)) {
-        fprintf(stderr, "[axpy] Failed to load x/y\n");
+static int do_syrk(const RunCtx *rc, const char *Apath) {
+    if (!Apath) {
+        printf("\n[syrk] Skipped: need --A\n");
+        return 0;
+    }
+    LoadOpts la = with_advice(rc->lo, ADV_SEQUENTIAL);
+    const Mat *A = oc_mat(rc->oc, Apath, rc->fmt, &la);
+    if (!A) {
+        fprintf(stderr, "[syrk] Failed to load A\n");
         return -1;
     }
-    if (x.len != y1.len) {
-        fprintf(stderr, "[axpy] Dimension mismatch: x=%zu, y=%zu\n", x.len, y1.len);
-        v_free(&x); v_free(&y1);
+    const size_t n = rc->ta == TR_T ? A->cols : A->rows, k = rc->ta == TR_T ? A->rows : A->cols;
+    Tri C;
+    if (tri_alloc(n, rc->uplo, A->dt, &C) != 0) {
+        fprintf(stderr, "[syrk] Allocation failure\n");
         return -1;
     }
+    printf("\n[syrk] C = %s, %s triangle, %zux%zu packed (%.1f MiB, full %.1f MiB)\n",
+           rc->ta == TR_T ? "A^T * A" : "A * A^T", rc->uplo == UPLO_L ? "lower" : "upper", n, n,
+           (double)C.v.len * dt_size(A->dt) / (1024.0 * 1024.0),
+           (double)n * n * dt_size(A->dt) / (1024.0 * 1024.0));
+
+    SyrkArgs args = { A, &C, rc->cfg, rc->ta };
+    int status = bench_counts(rc, OP_SYRK, syrk_call, NULL, &args, &args.cfg, n, n, k, 0);
+    if (status == 0) {
+        printf("C preview (top-left):\n");
+        print_tri_preview(&C, 1, 4);
+    }
+    tri_free(&C);
+    return status;
+}
 
-    yN = v_alloc(y1.len);
-    if (!yN.data) {
-        fprintf(stderr, "[axpy] Allocation failure\n");
-        v_free(&x); v_free(&y1);
-        return -1;
+/* symv and trmv: A is a packed file with --packed, else the --uplo half of a dense square file. */
+static int do_tri(const RunCtx *rc, Op op, const char *Apath, const char *xpath) {
+    const char *name = op_name(op);
+    if (!Apath || !xpath) {
+        printf("\n[%s] Skipped: need --A and --x\n", name);
+        return 0;
+    }
+    Tri A;
+    if (rc->packed) {
+        if (tri_load(Apath, rc->fmt, rc->lo, &A) != 0) {
+            fprintf(stderr, "[%s] Failed to load packed A\n", name);
+            return -1;
+        }
+    } else {
+        LoadOpts la = with_advice(rc->lo, ADV_SEQUENTIAL);
+        const Mat *D = oc_mat(rc->oc, Apath, rc->fmt, &la);
+        if (!D || D->rows != D->cols) {
+            fprintf(stderr, D ? "[%s] A must be square\n" : "[%s] Failed to load A\n", name);
+            return -1;
+        }
+        int r = tri_from_dense(D, rc->uplo, &A);
+        oc_release(rc->oc, Apath);
+        if (r != 0) {
+            fprintf(stderr, "[%s] Allocation failure\n", name);
+            return -1;
+        }
+    }
+    LoadOpts lx = with_advice(rc->lo, ADV_WILLNEED);
+    const Vec *x = oc_vec(rc->oc, xpath, rc->fmt, &lx);
+    int status = 0;
+    Vec y = {0};
+    if (!x) {
+        fprintf(stderr, "[%s] Failed to load x\n", name);
+        status = -1;
+    } else if (x->len != A.n) {
+        fprintf(stderr, "[%s] Dimension mismatch: A=%zux%zu, x=%zu\n", name, A.n, A.n, x->len);
+        status = -1;
+    } else if (!(y = out_vec(A.n, rc->lo)).data) {
+        fprintf(stderr, "[%s] Allocation failure\n", name);
+        status = -1;
     }
-    memcpy(yN.data, y1.data, sizeof(double) * y1.len);
+    if (status == 0) {
+        printf("\n[%s] A=%zux%zu %s %s, packed (%zu of %zu elements)\n", name, A.n, A.n,
+               A.uplo == UPLO_L ? "lower" : "upper", op == OP_SYMV ? "symmetric" : "triangular",
+               A.v.len, A.n * A.n);
+        TriArgs args = { &A, x, &y, rc->cfg };
+        status = bench_counts(rc, op, op == OP_SYMV ? symv_call : trmv_call, NULL, &args, &args.cfg,
+                              A.n, A.n, 0, 0);
+    }
+    if (status == 0) {
+        printf("y preview:\n");
+        print_vector_preview(&y, 10);
+    }
+    v_free(&y);
+    tri_free(&A);
+    return status;
+}
 
-    double total1=0.0;
-    for (int r=0; r<rep && !g_stop; r++) {
-        Vec ytmp = v_alloc(y1.len);
-        memcpy(ytmp.data, y1.data, sizeof(double) * y1.len);
-        double t0 = now_s();
-        ax_mt(a, &x, &ytmp, 1);
-        total1 += now_s() - t0;
-        v_free(&ytmp);
+static double file_mb(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (double)st.st_size / 1e6 : 0.0;
+}
+
+static int same_mat(const Mat *a, const Mat *b) {
+    const size_t row = a->cols * dt_size(a->dt);
+    if (a->rows != b->rows || a->cols != b->cols || a->dt != b->dt) return 0;
+    for (size_t i = 0; i < a->rows; i++)
+        if (memcmp((const char*)a->data + i * a->ld * dt_size(a->dt),
+                   (const char*)b->data + i * b->ld * dt_size(b->dt), row) != 0) return 0;
+    return 1;
+}
+
+/*
+ * One input of --op convert: loaded in --format, written to
+ * OUT_<name>.<ext> in --to. Chunked output is read back on the pool
+ * and compared bit for bit with what was written.
+ */
+static int convert_one(const RunCtx *rc, const char *name, const char *path, int vec) {
+    static const char *ext[] = { "txt", "bin", "ck" };
+    char out[PATH_MAX];
+    snprintf(out, sizeof(out), "%s_%s.%s", rc->out_base, name, ext[rc->to]);
+    Mat M = {0}, M2 = {0};
+    Vec v = {0}, v2 = {0};
+    double t0 = now_s();
+    int r = vec ? v_load_ex(path, rc->fmt, rc->lo, &v) : m_load_ex(path, rc->fmt, rc->lo, &M);
+    const double load_s = now_s() - t0;
+    if (r != 0) {
+        fprintf(stderr, "[convert] Failed to load %s as %s\n", path, vec ? "a vector" : "a matrix");
+        return -1;
+    }
+    CkOpts co = { .codec = rc->codec, .pool = rc->cfg.pool, .nt = rc->cfg.nt };
+    t0 = now_s();
+    if (rc->to == FMT_CHUNK) r = vec ? ck_save_vec(out, &v, &co) : ck_save_mat(out, &M, &co);
+    else r = vec ? v_save(out, rc->to, &v) : m_save(out, rc->to, &M);
+    const double save_s = now_s() - t0;
+    if (r != 0) {
+        fprintf(stderr, "[convert] Failed to write %s\n", out);
+    } else {
+        printf("[convert] %s: %s (%s, %.1f MB) -> %s (%s%s%s, %.1f MB): load %.3f s, save %.3f s\n",
+               name, path, fmt_name(rc->fmt), file_mb(path), out, fmt_name(rc->to),
+               rc->to == FMT_CHUNK ? " " : "", rc->to == FMT_CHUNK ? ck_codec_name(rc->codec) : "",
+               file_mb(out), load_s, save_s);
     }
-    if (g_stop) {
-        fprintf(stderr, "[axpy] Interrupted\n");
-        v_free(&x); v_free(&y1); v_free(&yN);
-        return 2;
+    if (r == 0 && rc->to == FMT_CHUNK) {
+        t0 = now_s();
+        r = vec ? v_load_ex(out, FMT_CHUNK, rc->lo, &v2) : m_load_ex(out, FMT_CHUNK, rc->lo, &M2);
+        const double back_s = now_s() - t0;
+        Mat a = M, b = M2;
+        if (vec) {
+            a = (Mat){ .rows = v.len, .cols = 1, .ld = 1, .data = v.data, .dt = v.dt };
+            b = (Mat){ .rows = v2.len, .cols = 1, .ld = 1, .data = v2.data, .dt = v2.dt };
+        }
+        const int same = r == 0 && same_mat(&a, &b);
+        const double bytes = (double)a.rows * a.cols * dt_size(a.dt);
+        if (r == 0)
+            printf("[convert] %s: read back in %.3f s (%.2f GB/s decoded on %d threads), %s\n",
+                   name, back_s, back_s > 0 ? bytes / 1e9 / back_s : 0.0, rc->cfg.nt,
+                   same ? "identical" : "MISMATCH");
+        if (!same) r = -1;
     }
+    m_free(&M); m_free(&M2);
+    v_free(&v); v_free(&v2);
+    return r;
+}
 
-    double totalN=0.0;
-    for (int r=0; r<rep && !g_stop; r++) {
-        memcpy(yN.data, y1.data, sizeof(double) * y1.len);
-        double t0 = now_s();
-        ax_mt(a, &x, &yN, nt);
-        totalN += now_s() - t0;
+static int do_convert(const RunCtx *rc, const char *Apath, const char *Bpath,
+                      const char *xpath, const char *ypath) {
+    const char *path[4] = { Apath, Bpath, xpath, ypath }, *name[4] = { "A", "B", "x", "y" };
+    int any = 0;
+    for (int i = 0; i < 4 && !g_stop; i++) {
+        if (!path[i]) continue;
+        any = 1;
+        if (convert_one(rc, name[i], path[i], i >= 2) != 0) return -1;
     }
-    if (g_stop) {
-        fprintf(stderr, "[axpy] Interrupted\n");
-        v_free(&x); v_free(&y1); v_free(&yN);
-        return 2;
+    if (!any) fprintf(stderr, "[convert] Nothing to convert: give --A, --B, --x or --y\n");
+    return any ? (g_stop ? 2 : 0) : -1;
+}
+
+/* Queues the loads op will do (the same keys as its do_* function) on the cache's loader. */
+static void prefetch_op(const RunCtx *rc, Op op, const char *Apath, const char *xpath, const char *ypath) {
+    LoadOpts la = with_advice(rc->lo, ADV_SEQUENTIAL), lx = with_advice(rc->lo, ADV_WILLNEED);
+    switch (op) {
+        case OP_MV:
+            if (!Apath || !xpath) return;
+            if (rc->sparse) oc_prefetch_csr(rc->oc, Apath, rc->fmt, &la);
+            else if (!rc->ooc_budget) oc_prefetch_mat(rc->oc, Apath, rc->fmt, &la);
+            oc_prefetch_vec(rc->oc, xpath, rc->fmt, &lx);
+            break;
+        case OP_DOT:
+        case OP_AXPY:
+            if (!xpath || !ypath) return;
+            oc_prefetch_vec(rc->oc, xpath, rc->fmt, &la);
+            oc_prefetch_vec(rc->oc, ypath, rc->fmt, &la);
+            break;
+        default:
+            break;
     }
+}
 
-    double sec1 = total1 / (double)rep;
-    double secN = totalN / (double)rep;
-    run_bench("axpy", 0, 0, 0, x.len, 1, nt, sec1, secN, csv_path, fmt_name);
+/* 0 on success, 1 on error, 2 if interrupted. */
+static int run_batch(const RunCtx *rc, Op op,
+                     const char *Apath, const char *Bpath,
+                     const char *xpath, const char *ypath, double alpha) {
+    int r;
+    if (op == OP_ALL) {
+        char reps[16];
+        if (rc->bo.reps > 0) snprintf(reps, sizeof(reps), "%d", rc->bo.reps);
+        else snprintf(reps, sizeof(reps), "auto");
+        printf("[Mode] --op all\n");
+        printf("[Inputs] A=%s B=%s x=%s y=%s alpha=%.6g threads=%d warmup=%d repeat=%s tile=%d format=%s isa=%s dtype=%s sched=%s reduce=%s\n",
+               Apath?Apath:"(null)", Bpath?Bpath:"(null)", xpath?xpath:"(null)", ypath?ypath:"(null)",
+               alpha, rc->cfg.nt, rc->bo.warmup, reps, rc->cfg.tile, fmt_name(rc->fmt),
+               simd_ops()->name, dtype_name(rc->lo->dt, rc->cfg.acc),
+               rc->cfg.sched == SCHED_DYNAMIC ? "dynamic" : "static",
+               rc->cfg.red == RED_REPRO ? "repro" : "fast");
+
+        /*
+         * Pipelined: the loader reads each op's operands while the op
+         * before it computes, and inputs are freed after their last op.
+         */
+        prefetch_op(rc, OP_MV, Apath, xpath, NULL);
+        if ((r = do_mm(rc, Apath, Bpath)) != 0) return r == 2 ? 2 : 1;
+        if (Bpath && (!Apath || strcmp(Bpath, Apath) != 0)) oc_release(rc->oc, Bpath);
+        prefetch_op(rc, OP_DOT, NULL, xpath, ypath);
+        if ((r = do_mv(rc, Apath, xpath)) != 0) return r == 2 ? 2 : 1;
+        oc_release(rc->oc, Apath);
+        if ((r = do_dot(rc, xpath, ypath)) != 0) return r == 2 ? 2 : 1;
+        if ((r = do_axpy(rc, alpha, xpath, ypath)) != 0) return r == 2 ? 2 : 1;
+        return 0;
+    }
 
-    printf("alpha=%.6g, y preview:\n", a);
-    print_vector_preview(&yN, 10);
+    switch (op) {
+        case OP_MM:   r = do_mm(rc, Apath, Bpath); break;
+        case OP_MV:   r = do_mv(rc, Apath, xpath); break;
+        case OP_DOT:  r = do_dot(rc, xpath, ypath); break;
+        case OP_AXPY: r = do_axpy(rc, alpha, xpath, ypath); break;
+        case OP_SYRK: r = do_syrk(rc, Apath); break;
+        case OP_SYMV:
+        case OP_TRMV: r = do_tri(rc, op, Apath, xpath); break;
+        case OP_CONVERT: r = do_convert(rc, Apath, Bpath, xpath, ypath); break;
+        default:
+            fprintf(stderr, "Unknown op: %s\n", op_name(op));
+            return 1;
+    }
+    return r == 2 ? 2 : (r < 0 ? 1 : 0);
+}
 
-    v_free(&x); v_free(&y1); v_free(&yN);
-    return g_stop ? 2 : 0;
+/* Every input is loaded once per run and shared read-only by the ops that use it. */
+static int run_ops(RunCtx *rc, Op op,
+                   const char *Apath, const char *Bpath,
+                   const char *xpath, const char *ypath, double alpha) {
+    for (int i = 0; rc->roofline && i < rc->ncounts && !g_stop; i++) {
+        if (roof_probe(rc->cfg.pool, rc->counts[i], &rc->roofs[i]) != 0) {
+            fprintf(stderr, "[roof] Probe failed; reporting without bounds\n");
+            rc->roofline = 0;
+            break;
+        }
+        printf("[roof] threads=%d bandwidth=%.1f GB/s peak=%.1f GFLOPS (f64)\n",
+               rc->counts[i], rc->roofs[i].gbs, rc->roofs[i].gflops);
+    }
+
+    rc->oc = oc_create();
+    if (!rc->oc) {
+        fprintf(stderr, "Allocation failure\n");
+        return 1;
+    }
+    int status = run_batch(rc, op, Apath, Bpath, xpath, ypath, alpha);
+    if (op == OP_ALL) {
+        OcStats cs;
+        oc_stats(rc->oc, &cs);
+        printf("\n[cache] %d operand load(s) (%d ahead of use, %.3f s waited), %d reuse(s), %d freed early\n",
+               cs.loads, cs.ahead, cs.wait_s, cs.hits, cs.released);
+    }
+    oc_destroy(rc->oc);
+    rc->oc = NULL;
+
+    ArenaStats as;
+    arena_stats(&as);
+    printf("[arena] %zu buffer request(s), %zu reused, peak %.1f MiB\n",
+           as.gets, as.reuses, (double)as.peak_bytes / (1024.0 * 1024.0));
+    if (as.huge_fallbacks)
+        fprintf(stderr, "[huge] %zu of %zu mapping(s) found no reserved hugetlbfs pages and used THP\n",
+                as.huge_fallbacks, as.huge_maps);
+    return status;
 }
 
+
 int main(int argc, char **argv) {
     signal(SIGINT, on_sigint);
 
@@ -419,9 +1162,38 @@ int main(int argc, char **argv) {
     const char *Apath=NULL, *Bpath=NULL, *xpath=NULL, *ypath=NULL;
     const char *out_base=NULL;
     int nt = 1;
-    int rep = 1;
+    BenchOpts bo = { .warmup = BENCH_WARMUP, .reps = 0, .min_time = BENCH_MIN_TIME };
     int tile = 64;
+    MMAlgo mm_algo = MM_TILED;
+    int blk[3] = {0, 0, 0};
+    int strassen = 0;
+    LoadOpts lo = {0};
+    Accum acc = ACC_NATIVE;
+    Sched sched = SCHED_STATIC;
+    Reduce red = RED_FAST;
+    int chunk = 0;
     double alpha = 1.0;
+    int counts[MAX_COUNTS], ncounts = 0;
+    int use_perf = 0;
+    int sparse = 0;
+    size_t ooc_budget = 0;
+    long batch = 0;
+    int autotune = 0;
+    const char *prof_arg = NULL;
+    unsigned fixed = 0;
+    size_t arena_keep = ARENA_KEEP_DEFAULT;
+    HugeMode huge = HUGE_OFF;
+    int pf = 0;
+    Trans ta = TR_N, tb = TR_N;
+    Uplo uplo = UPLO_L;
+    int packed = 0;
+    int dist = 0, ranks_sweep = 0;
+    DistLayout layout = DIST_1D;
+    long dist_nb = 0;
+    FileFmt to = FMT_TEXT;
+    int have_to = 0;
+    Codec codec = CODEC_SHUF;
+    const char *sock = NULL;
 
     static struct option longopts[] = {
         {"op", required_argument, 0, 'o'},
@@ -432,8 +1204,40 @@ int main(int argc, char **argv) {
         {"y", required_argument, 0, 'y'},
         {"alpha", required_argument, 0, 'a'},
         {"threads", required_argument, 0, 't'},
+        {"threads-sweep", required_argument, 0, 'W'},
         {"repeat", required_argument, 0, 'r'},
+        {"warmup", required_argument, 0, 'w'},
+        {"min-time", required_argument, 0, 'm'},
+        {"perf", no_argument, 0, 'p'},
         {"tile", required_argument, 0, 'T'},
+        {"mmap", no_argument, 0, 'P'},
+        {"sparse", no_argument, 0, 'X'},
+        {"ooc", required_argument, 0, 'L'},
+        {"batch", required_argument, 0, 'b'},
+        {"autotune", no_argument, 0, 'U'},
+        {"profile", required_argument, 0, 'F'},
+        {"arena", required_argument, 0, 'K'},
+        {"huge", required_argument, 0, 'H'},
+        {"prefetch", required_argument, 0, 'Q'},
+        {"trans-a", no_argument, 0, 'J'},
+        {"trans-b", no_argument, 0, 'V'},
+        {"uplo", required_argument, 0, 'u'},
+        {"packed", no_argument, 0, 'k'},
+        {"dist", required_argument, 0, 'd'},
+        {"dist-block", required_argument, 0, 'g'},
+        {"ranks-sweep", no_argument, 0, 'j'},
+        {"to", required_argument, 0, 'i'},
+        {"codec", required_argument, 0, 'c'},
+        {"socket", required_argument, 0, 's'},
+        {"numa", no_argument, 0, 'N'},
+        {"isa", required_argument, 0, 'I'},
+        {"mm-algo", required_argument, 0, 'M'},
+        {"gemm-block", required_argument, 0, 'G'},
+        {"strassen", required_argument, 0, 'Z'},
+        {"dtype", required_argument, 0, 'D'},
+        {"sched", required_argument, 0, 'S'},
+        {"chunk", required_argument, 0, 'C'},
+        {"reduce", required_argument, 0, 'E'},
         {"result", required_argument, 0, 'R'},
         {"out", required_argument, 0, 'O'},
         {"help", no_argument, 0, 'h'},
@@ -441,7 +1245,7 @@ int main(int argc, char **argv) {
     };
 
     int c;
-    while ((c = getopt_long(argc, argv, "o:f:A:B:x:y:a:t:r:T:R:O:h", longopts, NULL)) != -1) {
+    while ((c = getopt_long(argc, argv, "o:f:A:B:x:y:a:t:W:r:w:m:pT:PXL:b:UF:K:H:Q:JVu:kd:g:ji:c:s:NI:M:G:Z:D:S:C:E:R:O:h", longopts, NULL)) != -1) {
         switch (c) {
             case 'o': op = parse_op(optarg); break;
             case 'f': fmt = parse_fmt(optarg); break;
@@ -450,51 +1254,254 @@ int main(int argc, char **argv) {
             case 'x': xpath = optarg; break;
             case 'y': ypath = optarg; break;
             case 'a': alpha = strtod(optarg, NULL); break;
-            case 't': nt = atoi(optarg); break;
-            case 'r': rep = atoi(optarg); break;
-            case 'T': tile = atoi(optarg); break;
+            case 't': nt = atoi(optarg); fixed |= TUNE_FIX_THREADS; break;
+            case 'W':
+                if (parse_counts(optarg, counts, &ncounts) != 0) { usage(argv[0]); return 1; }
+                fixed |= TUNE_FIX_THREADS;
+                break;
+            case 'r': bo.reps = strcmp(optarg, "auto") == 0 ? 0 : atoi(optarg); break;
+            case 'w': bo.warmup = atoi(optarg); break;
+            case 'm': bo.min_time = strtod(optarg, NULL); break;
+            case 'T': tile = atoi(optarg); fixed |= TUNE_FIX_TILE; break;
+            case 'p': use_perf = 1; break;
+            case 'P': lo.mmap = 1; break;
+            case 'X': sparse = 1; break;
+            case 'b': batch = atol(optarg); break;
+            case 'U': autotune = 1; break;
+            case 'F': prof_arg = optarg; break;
+            case 'K':
+                if (strcmp(optarg, "0") == 0) arena_keep = 0;
+                else if (parse_bytes(optarg, &arena_keep) != 0) { usage(argv[0]); return 1; }
+                break;
+            case 'H':
+                if (parse_huge(optarg, &huge) != 0) { usage(argv[0]); return 1; }
+                break;
+            case 'Q': pf = atoi(optarg); break;
+            case 'J': ta = TR_T; break;
+            case 'V': tb = TR_T; break;
+            case 'u':
+                if (parse_uplo(optarg, &uplo) != 0) { usage(argv[0]); return 1; }
+                break;
+            case 'k': packed = 1; break;
+            case 'd':
+                if (parse_dist(optarg, &layout) != 0) { usage(argv[0]); return 1; }
+                dist = 1;
+                break;
+            case 'g': dist_nb = atol(optarg); break;
+            case 'j': ranks_sweep = 1; break;
+            case 'i': to = parse_fmt(optarg); have_to = 1; break;
+            case 'c':
+                if (parse_codec(optarg, &codec) != 0) { usage(argv[0]); return 1; }
+                break;
+            case 's': sock = optarg; break;
+            case 'L':
+                if (parse_bytes(optarg, &ooc_budget) != 0) { usage(argv[0]); return 1; }
+                break;
+            case 'N': lo.numa = 1; break;
+            case 'I':
+                if (simd_select(optarg) != 0) {
+                    fprintf(stderr, "ISA '%s' is not supported on this CPU\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'M':
+                if (parse_mm_algo(optarg, &mm_algo) != 0) { usage(argv[0]); return 1; }
+                fixed |= TUNE_FIX_ALGO;
+                break;
+            case 'G':
+                if (sscanf(optarg, "%d,%d,%d", &blk[0], &blk[1], &blk[2]) != 3) {
+                    usage(argv[0]); return 1;
+                }
+                fixed |= TUNE_FIX_ALGO;
+                break;
+            case 'Z': strassen = atoi(optarg); fixed |= TUNE_FIX_ALGO; break;
+            case 'D':
+                if (parse_dtype(optarg, &lo.dt, &acc) != 0) { usage(argv[0]); return 1; }
+                break;
+            case 'S':
+                if (parse_sched(optarg, &sched) != 0) { usage(argv[0]); return 1; }
+                break;
+            case 'C': chunk = atoi(optarg); break;
+            case 'E':
+                if (parse_reduce(optarg, &red) != 0) { usage(argv[0]); return 1; }
+                break;
             case 'O': out_base = optarg; break;
             case 'h': usage(argv[0]); return 0;
             default: usage(argv[0]); return 1;
         }
     }
 
-    if (op == OP_NONE || !out_base || nt <= 0 || rep <= 0) {
+    const int serving = op == OP_SERVE || op == OP_SEND;
+    if (serving && !out_base) out_base = "/dev/null";
+    if (op == OP_NONE || !out_base || nt <= 0 || batch < 0 || pf < 0 || dist_nb < 0 ||
+        bo.reps < 0 || bo.warmup < 0 || bo.min_time <= 0.0) {
         usage(argv[0]); return 1;
     }
-
-    if (op == OP_ALL) {
-        printf("[Mode] --op all\n");
-         printf("[Inputs] A=%s B=%s x=%s y=%s alpha=%.6g threads=%d repeat=%d tile=%d format=%s\n",
-               Apath?Apath:"(null)", Bpath?Bpath:"(null)", xpath?xpath:"(null)", ypath?ypath:"(null)",
-             alpha, nt, rep, tile, (fmt==FMT_BIN?"bin":"text"));
-
-        int rc;
-
-        rc = do_mm(out_base, fmt, Apath, Bpath, nt, rep, tile);
-        if (rc == 2) return 2;
-        if (rc < 0) return 1;
-
-        rc = do_mv(out_base, fmt, Apath, xpath, nt, rep);
-        if (rc == 2) return 2;
-        if (rc < 0) return 1;
-
-        rc = do_dot(out_base, fmt, xpath, ypath, nt, rep);
-        if (rc == 2) return 2;
-        if (rc < 0) return 1;
-
-        rc = do_axpy(out_base, fmt, alpha, xpath, ypath, nt, rep);
-        if (rc == 2) return 2;
-        if (rc < 0) return 1;
-
-        return 0;
+    /* A sweep runs every count on one pool sized for the largest. */
+    for (int i = 0; i < ncounts; i++) {
+        if (i == 0 || counts[i] > nt) nt = counts[i];
+    }
+    if (lo.mmap && fmt != FMT_BIN) {
+        fprintf(stderr, "--mmap requires --format bin; loading normally\n");
+        lo.mmap = 0;
+    }
+    if (batch && (ooc_budget || sparse)) {
+        fprintf(stderr, "--batch cannot be combined with --ooc or --sparse\n");
+        return 1;
+    }
+    if ((ta == TR_T || tb == TR_T) && (batch || ooc_budget || sparse)) {
+        fprintf(stderr, "--trans-a/--trans-b cannot be combined with --batch, --ooc or --sparse\n");
+        return 1;
+    }
+    if (ooc_budget && fmt == FMT_TEXT) {
+        fprintf(stderr, "--ooc requires --format bin or chunk\n");
+        return 1;
+    }
+    if (fmt == FMT_CHUNK && (sparse || packed)) {
+        fprintf(stderr, "--sparse and --packed files are text or bin, not chunk\n");
+        return 1;
+    }
+    if ((op == OP_CONVERT) != have_to) {
+        fprintf(stderr, "--op convert and --to go together\n");
+        return 1;
+    }
+    if (op == OP_CONVERT && strcmp(out_base, "/dev/null") == 0) {
+        fprintf(stderr, "--op convert writes OUT_<name> files; --out cannot be /dev/null\n");
+        return 1;
+    }
+    if (serving != (sock != NULL)) {
+        fprintf(stderr, "--op serve and send need --socket, which is only for them\n");
+        return 1;
+    }
+    if (serving && (batch || ooc_budget || sparse || packed || dist || autotune || ncounts)) {
+        fprintf(stderr, "--op serve/send cannot be combined with --batch, --ooc, --sparse, --packed, "
+                        "--dist, --autotune or --threads-sweep\n");
+        return 1;
+    }
+    if (op == OP_SEND) return serve_send(sock, fmt, stdin) == 0 ? 0 : 1;
+    if (!dist && (dist_nb || ranks_sweep)) {
+        fprintf(stderr, "--dist-block and --ranks-sweep need --dist\n");
+        return 1;
+    }
+    if (dist) {
+        if ((op != OP_MM && op != OP_MV) || fmt == FMT_TEXT) {
+            fprintf(stderr, "--dist runs --op mm or mv with --format bin or chunk\n");
+            return 1;
+        }
+        if (op == OP_MV && layout == DIST_SUMMA) {
+            fprintf(stderr, "--dist summa is for mm; mv runs on --dist 1d\n");
+            return 1;
+        }
+        if (batch || ooc_budget || sparse || ta == TR_T || tb == TR_T || ncounts || autotune) {
+            fprintf(stderr, "--dist cannot be combined with --batch, --ooc, --sparse, --trans-a/-b, "
+                            "--threads-sweep or --autotune\n");
+            return 1;
+        }
+#ifdef USE_MPI
+        if (dist_init(&argc, &argv) != 0) {
+            fprintf(stderr, "[dist] MPI does not provide funneled threading\n");
+            dist_finalize();
+            return 1;
+        }
+        atexit(dist_finalize);
+#else
+        fprintf(stderr, "--dist: this build has no MPI support; rebuild with make MPI=1\n");
+        return 1;
+#endif
     }
 
-    if (op == OP_MM)   return do_mm(out_base, fmt, Apath, Bpath, nt, rep, tile) < 0 ? 1 : (g_stop ? 2 : 0);
-    if (op == OP_MV)   return do_mv(out_base, fmt, Apath, xpath, nt, rep) < 0 ? 1 : (g_stop ? 2 : 0);
-    if (op == OP_DOT)  return do_dot(out_base, fmt, xpath, ypath, nt, rep) < 0 ? 1 : (g_stop ? 2 : 0);
-    if (op == OP_AXPY) return do_axpy(out_base, fmt, alpha, xpath, ypath, nt, rep) < 0 ? 1 : (g_stop ? 2 : 0);
-
-    fprintf(stderr, "Unknown op: %s\n", op_name(op));
-    return 1;
+    /* Without --threads, a search tries up to every CPU and a profile may ask for more than 1. */
+    const int run_nt = nt;
+    if (prof_arg && strcmp(prof_arg, "none") == 0 && autotune) {
+        fprintf(stderr, "--autotune needs a profile to write\n");
+        return 1;
+    }
+    CtxOpts co;
+    ctx_opts_init(&co);
+    co.nt = autotune && !(fixed & TUNE_FIX_THREADS) ? 0 : nt;
+    co.numa = lo.numa;
+    co.dt = lo.dt;
+    co.cfg = (KCfg){ .tile = tile, .mm_algo = mm_algo, .mc = blk[0], .kc = blk[1], .nc = blk[2],
+                     .strassen = strassen, .acc = acc, .sched = sched, .chunk = chunk, .red = red, .pf = pf };
+    co.fixed = fixed;
+    co.profile = prof_arg;
+    co.arena_keep = arena_keep;
+    co.huge = huge;
+    ExecCtx ctx;
+    if (ctx_init(&ctx, &co) != 0) {
+        fprintf(stderr, "Failed to start %d worker threads\n", co.nt);
+        return 1;
+    }
+    if (ctx.prof_err) fprintf(stderr, "[tune] Cannot read profile %s; running untuned\n", ctx.prof_path);
+    if (autotune && !ctx.tuned) {
+        if (!ctx.prof_path[0])
+            fprintf(stderr, "[tune] No HOME or XDG_CACHE_HOME for the profile; pass --profile FILE\n");
+        ctx_free(&ctx);
+        return 1;
+    }
+    Pool *pool = ctx.pool;
+    nt = ctx.nt;
+    if (ctx.nodes < 0) fprintf(stderr, "[numa] Could not pin threads; placement is first-touch only\n");
+    else if (ctx.nodes > 0) printf("[numa] %d threads pinned across %d node(s)\n", nt, ctx.nodes);
+    if (op == OP_SERVE) {
+        /* Without SA_RESTART, so a wait on a socket returns and the loop sees g_stop. */
+        struct sigaction sa = { .sa_handler = on_sigint };
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        ctx.lo.mmap = lo.mmap;
+        ServeOpts so = { .socket = sock, .fmt = fmt };
+        Server *srv = serve_open(&ctx, &so);
+        int r = srv ? 0 : -1;
+        const char *names[4] = { "A", "B", "x", "y" }, *paths[4] = { Apath, Bpath, xpath, ypath };
+        for (int i = 0; i < 4 && r == 0; i++)
+            if (paths[i]) r = serve_load(srv, names[i], paths[i], fmt, i >= 2);
+        if (r == 0) {
+            printf("[serve] Listening on %s: %d thread(s), %s, %s (Ctrl+C or a shutdown request stops it)\n",
+                   sock, nt, simd_ops()->name, dtype_name(lo.dt, acc));
+            fflush(stdout);
+            r = serve_loop(srv);
+            printf("[serve] %s\n", r == 2 ? "Interrupted" : r == 0 ? "Shut down" : "Socket failed");
+        }
+        serve_close(srv);
+        ctx_free(&ctx);
+        return r < 0 ? 1 : 0;
+    }
+    if (use_perf) {
+        bo.perf = perf_open(pool);
+        if (!bo.perf) fprintf(stderr, "[perf] Hardware counters unavailable; reporting without them\n");
+    }
+    lo.nt = nt;
+    lo.pool = pool;
+    KCfg cfg = ctx.cfg;
+    RunCtx rc = { .out_base = out_base, .fmt = fmt, .lo = &lo, .cfg = cfg, .bo = bo,
+                  .counts = { 1, run_nt }, .ncounts = run_nt > 1 ? 2 : 1, .sparse = sparse,
+                  .ooc_budget = ooc_budget, .batch = (size_t)batch,
+                  .prof = ctx.tuned, .autotune = autotune, .fixed = fixed,
+                  .max_nt = nt, .huge = huge, .ta = ta, .tb = tb,
+                  .uplo = uplo, .packed = packed, .to = to, .codec = codec };
+    if (ncounts > 0) {
+        memcpy(rc.counts, counts, (size_t)ncounts * sizeof(int));
+        rc.ncounts = ncounts;
+        rc.roofline = 1;
+    }
+    int status;
+#ifdef USE_MPI
+    if (dist) {
+        DistOpts dopt = { .layout = layout, .nb = (size_t)dist_nb, .sweep = ranks_sweep, .bo = bo,
+                          .out_base = out_base, .dt = lo.dt, .dtype = dtype_name(lo.dt, acc),
+                          .fmt = fmt_name(fmt) };
+        int r = op == OP_MM ? dist_mm(Apath, Bpath, &dopt, cfg) : dist_mv(Apath, xpath, &dopt, cfg);
+        status = r == 2 ? 2 : (r < 0 ? 1 : 0);
+    } else
+#endif
+    status = run_ops(&rc, op, Apath, Bpath, xpath, ypath, alpha);
+    if (autotune && ctx.prof.dirty) {
+        if (profile_save(&ctx.prof, ctx.prof_path) == 0)
+            printf("[tune] Saved %zu entries to %s\n", ctx.prof.n, ctx.prof_path);
+        else fprintf(stderr, "[tune] Failed to write %s\n", ctx.prof_path);
+    }
+    perf_close(bo.perf);
+    ctx_free(&ctx);
+    return status;
 }
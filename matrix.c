@@ -1,8 +1,17 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
 #include "matrix.h"
+#include "arena.h"
+#include "chunk.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <float.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 static int read_u64(FILE *f, uint64_t *x) {
     return fread(x, sizeof(uint64_t), 1, f) == 1 ? 0 : -1;
@@ -11,64 +20,706 @@ static int write_u64(FILE *f, uint64_t x) {
     return fwrite(&x, sizeof(uint64_t), 1, f) == 1 ? 0 : -1;
 }
 
+/* Above this size, zeroed buffers come straight from mmap and are zero-filled lazily. */
+#define MAP_THRESHOLD (1u << 20)
+
+size_t m_ld_for(size_t c, size_t esz) {
+    size_t line = MAT_ALIGN / esz;
+    size_t ld = (c + line - 1) / line * line;
+    /* Rows exactly 4 KiB apart map to the same cache sets; skew them by one line. */
+    if ((ld * esz) % 4096 == 0) ld += line;
+    return ld;
+}
+
+/* Zeroed, MAT_ALIGN-aligned buffer; records how it must be released. */
+static void *alloc_zeroed(size_t bytes, MemKind *mem, void **base, size_t *len) {
+    if (bytes >= MAP_THRESHOLD) {
+        void *p = arena_map(bytes, len);
+        if (!p) return NULL;
+        *mem = MEM_ANON; *base = p;
+        return p;
+    }
+    size_t sz = (bytes + MAT_ALIGN - 1) / MAT_ALIGN * MAT_ALIGN;
+    void *p = aligned_alloc(MAT_ALIGN, sz);
+    if (!p) return NULL;
+    memset(p, 0, sz);
+    *mem = MEM_HEAP;
+    return p;
+}
+
 Mat m_alloc(size_t r, size_t c) {
+    return m_alloc_dt(r, c, DT_F64);
+}
+
+Mat m_alloc_dt(size_t r, size_t c, DType dt) {
     Mat m = {0};
-    m.rows = r; m.cols = c;
+    m.rows = r; m.cols = c; m.dt = dt;
     if (r == 0 || c == 0) return m;
-    m.data = (double*)calloc(r * c, sizeof(double));
-    if (!m.data) { m.rows = m.cols = 0; }
+    size_t esz = dt_size(dt);
+    m.ld = m_ld_for(c, esz);
+    if (m.ld > SIZE_MAX / esz / r) { m.rows = m.cols = m.ld = 0; return m; }
+    m.data = (double*)alloc_zeroed(r * m.ld * esz, &m.mem, &m.base, &m.base_len);
+    if (!m.data) { m.rows = m.cols = m.ld = 0; }
     return m;
 }
 
+Mat m_view(const Mat *A, size_t i, size_t j, size_t r, size_t c) {
+    Mat v = {0};
+    if (!A || !A->data || i + r > A->rows || j + c > A->cols) return v;
+    v.rows = r; v.cols = c; v.ld = A->ld; v.dt = A->dt;
+    v.data = (double*)((char*)A->data + (i * A->ld + j) * dt_size(A->dt));
+    v.mem = MEM_VIEW;
+    return v;
+}
+
+static void release(MemKind mem, void *data, void *base, size_t base_len) {
+    if (mem == MEM_MAP || mem == MEM_ANON) munmap(base, base_len);
+    else if (mem == MEM_HEAP) free(data);
+    else if (mem == MEM_ARENA) arena_put(data);
+}
+
+typedef struct {
+    char *p;
+    size_t rows, row_bytes, unit;
+} TouchJob;
+
+static void touch_worker(void *p, int tid, int nt) {
+    TouchJob *j = (TouchJob*)p;
+    size_t i0, i1;
+    row_range_al(j->rows, j->unit, tid, nt, &i0, &i1);
+    if (i1 > i0) memset(j->p + i0 * j->row_bytes, 0, (i1 - i0) * j->row_bytes);
+}
+
+/*
+ * Anonymous mapping whose pages are first written by the owning threads:
+ * rows split on multiples of unit, as the kernels that read them split.
+ */
+static void *alloc_local(size_t rows, size_t row_bytes, size_t unit, Pool *p, int nt, size_t *len) {
+    if (rows == 0 || row_bytes == 0 || rows > SIZE_MAX / row_bytes) return NULL;
+    size_t sz;
+    void *base = arena_map(rows * row_bytes, &sz);
+    if (!base) return NULL;
+    TouchJob j = { .p = (char*)base, .rows = rows, .row_bytes = row_bytes, .unit = unit };
+    if (pool_run(p, nt, touch_worker, &j) < 0) { munmap(base, sz); return NULL; }
+    *len = sz;
+    return base;
+}
+
+Mat m_alloc_local(size_t r, size_t c, DType dt, Pool *p, int nt) {
+    Mat m = {0};
+    m.rows = r; m.cols = c; m.dt = dt;
+    if (r == 0 || c == 0) return m;
+    size_t esz = dt_size(dt);
+    m.ld = m_ld_for(c, esz);
+    if (m.ld > SIZE_MAX / esz) { m.rows = m.cols = m.ld = 0; return m; }
+    m.base = alloc_local(r, m.ld * esz, pool_line_unit(esz), p, nt, &m.base_len);
+    if (!m.base) { m.rows = m.cols = m.ld = 0; return m; }
+    m.data = (double*)m.base;
+    m.mem = MEM_ANON;
+    return m;
+}
+
+Vec v_alloc_local(size_t n, DType dt, Pool *p, int nt) {
+    Vec v = {0};
+    v.len = n; v.dt = dt;
+    if (n == 0) return v;
+    v.base = alloc_local(n, dt_size(dt), pool_line_unit(dt_size(dt)), p, nt, &v.base_len);
+    if (!v.base) { v.len = 0; return v; }
+    v.data = (double*)v.base;
+    v.mem = MEM_ANON;
+    return v;
+}
+
+Mat m_alloc_arena(size_t r, size_t c, DType dt) {
+    Mat m = {0};
+    m.rows = r; m.cols = c; m.dt = dt;
+    if (r == 0 || c == 0) return m;
+    size_t esz = dt_size(dt);
+    m.ld = m_ld_for(c, esz);
+    if (m.ld > SIZE_MAX / esz / r) { m.rows = m.cols = m.ld = 0; return m; }
+    m.data = (double*)arena_get(r * m.ld * esz, 1);
+    if (!m.data) { m.rows = m.cols = m.ld = 0; return m; }
+    m.mem = MEM_ARENA;
+    return m;
+}
+
+Vec v_alloc_arena(size_t n, DType dt) {
+    Vec v = {0};
+    v.len = n; v.dt = dt;
+    if (n == 0) return v;
+    size_t esz = dt_size(dt);
+    if (n > SIZE_MAX / esz) { v.len = 0; return v; }
+    v.data = (double*)arena_get(n * esz, 1);
+    if (!v.data) { v.len = 0; return v; }
+    v.mem = MEM_ARENA;
+    return v;
+}
+
+static Mat alloc_mat(size_t r, size_t c, const LoadOpts *o) {
+    DType dt = o ? o->dt : DT_F64;
+    return (o && o->numa) ? m_alloc_local(r, c, dt, o->pool, o->nt) : m_alloc_dt(r, c, dt);
+}
+
+static Vec alloc_vec(size_t n, const LoadOpts *o) {
+    DType dt = o ? o->dt : DT_F64;
+    return (o && o->numa) ? v_alloc_local(n, dt, o->pool, o->nt) : v_alloc_dt(n, dt);
+}
+
 void m_free(Mat *m) {
     if (!m) return;
-    free(m->data);
-    m->data = NULL;
-    m->rows = m->cols = 0;
+    release(m->mem, m->data, m->base, m->base_len);
+    *m = (Mat){0};
 }
 
 Vec v_alloc(size_t n) {
+    return v_alloc_dt(n, DT_F64);
+}
+
+Vec v_alloc_dt(size_t n, DType dt) {
     Vec v = {0};
-    v.len = n;
+    v.len = n; v.dt = dt;
     if (n == 0) return v;
-    v.data = (double*)calloc(n, sizeof(double));
+    size_t esz = dt_size(dt);
+    if (n > SIZE_MAX / esz) { v.len = 0; return v; }
+    v.data = (double*)alloc_zeroed(n * esz, &v.mem, &v.base, &v.base_len);
     if (!v.data) v.len = 0;
     return v;
 }
 
 void v_free(Vec *v) {
     if (!v) return;
-    free(v->data);
-    v->data = NULL;
-    v->len = 0;
+    release(v->mem, v->data, v->base, v->base_len);
+    *v = (Vec){0};
+}
+
+static int to_posix_advice(MapAdvice adv) {
+    switch (adv) {
+        case ADV_SEQUENTIAL: return POSIX_MADV_SEQUENTIAL;
+        case ADV_RANDOM:     return POSIX_MADV_RANDOM;
+        case ADV_WILLNEED:   return POSIX_MADV_WILLNEED;
+        default:             return POSIX_MADV_NORMAL;
+    }
+}
+
+/*
+ * Element type of a FMT_BIN payload of the given size holding n values:
+ * exactly 4 bytes each is DT_F32, at least 8 bytes each is DT_F64.
+ */
+static int payload_dt(uint64_t n, uint64_t payload, DType *dt) {
+    if (n <= payload / sizeof(double)) { *dt = DT_F64; return 0; }
+    if (n <= UINT64_MAX / sizeof(float) && payload == n * sizeof(float)) { *dt = DT_F32; return 0; }
+    return -1;
+}
+
+/*
+ * Maps a FMT_BIN file whose header is nhdr uint64 dimensions; checks the
+ * file holds their product in doubles or, exactly, in floats.
+ */
+static int map_bin(const char *path, int nhdr, MapAdvice adv,
+                   uint64_t *dims, DType *dt, void **base, size_t *len) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { perror("open"); return -1; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)(nhdr * sizeof(uint64_t))) {
+        close(fd); return -1;
+    }
+    size_t sz = (size_t)st.st_size;
+    void *p = mmap(NULL, sz, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) { perror("mmap"); return -1; }
+
+    memcpy(dims, p, (size_t)nhdr * sizeof(uint64_t));
+    uint64_t n = 1;
+    for (int i = 0; i < nhdr; i++) {
+        if (dims[i] == 0 || n > UINT64_MAX / dims[i]) { munmap(p, sz); return -1; }
+        n *= dims[i];
+    }
+    size_t payload = sz - (size_t)nhdr * sizeof(uint64_t);
+    if (payload_dt(n, payload, dt) != 0) { munmap(p, sz); return -1; }
+
+    posix_madvise(p, sz, to_posix_advice(adv));
+    *base = p; *len = sz;
+    return 0;
+}
+
+/* Shape of a FMT_CHUNK file, which must hold a vector iff vec. */
+static int ck_info(const char *path, int vec, size_t *rows, size_t *cols, DType *dt) {
+    CkFile f;
+    if (ck_open(path, &f) != 0) return -1;
+    int rc = f.vec == vec ? 0 : -1;
+    *rows = f.rows; *cols = f.cols; *dt = f.dt;
+    ck_close(&f);
+    return rc;
+}
+
+int m_bin_info(const char *path, size_t *rows, size_t *cols, DType *dt) {
+    if (!path) return -1;
+    if (ck_is_chunk(path)) return ck_info(path, 0, rows, cols, dt);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { perror("open"); return -1; }
+    struct stat st;
+    uint64_t dims[2];
+    int rc = -1;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= (off_t)sizeof(dims) &&
+        pread(fd, dims, sizeof(dims), 0) == (ssize_t)sizeof(dims) &&
+        dims[0] > 0 && dims[1] > 0 && dims[0] <= UINT64_MAX / dims[1] &&
+        payload_dt(dims[0] * dims[1], (uint64_t)st.st_size - sizeof(dims), dt) == 0) {
+        *rows = (size_t)dims[0];
+        *cols = (size_t)dims[1];
+        rc = 0;
+    }
+    close(fd);
+    return rc;
+}
+
+int v_bin_info(const char *path, size_t *len, DType *dt) {
+    if (!path) return -1;
+    if (ck_is_chunk(path)) { size_t one; return ck_info(path, 1, len, &one, dt); }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { perror("open"); return -1; }
+    struct stat st;
+    uint64_t n;
+    int rc = -1;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= (off_t)sizeof(n) &&
+        pread(fd, &n, sizeof(n), 0) == (ssize_t)sizeof(n) && n > 0 &&
+        payload_dt(n, (uint64_t)st.st_size - sizeof(n), dt) == 0) {
+        *len = (size_t)n;
+        rc = 0;
+    }
+    close(fd);
+    return rc;
+}
+
+/* n elements stored as from at byte off of fd into dst of type to. */
+static int pread_elems(int fd, off_t off, DType from, void *dst, DType to, size_t n) {
+    const size_t fsz = dt_size(from);
+    if (from == to) {
+        size_t want = n * fsz, got = 0;
+        while (got < want) {
+            ssize_t r = pread(fd, (char*)dst + got, want - got, off + (off_t)got);
+            if (r <= 0) return -1;
+            got += (size_t)r;
+        }
+        return 0;
+    }
+    double buf[512];
+    const size_t per = sizeof(buf) / fsz;
+    for (size_t i = 0; i < n; ) {
+        size_t m = n - i < per ? n - i : per;
+        if (pread_elems(fd, off + (off_t)(i * fsz), from, buf, from, m) != 0) return -1;
+        if (to == DT_F32) {
+            for (size_t k = 0; k < m; k++) ((float*)dst)[i + k] = (float)buf[k];
+        } else {
+            const float *fb = (const float*)buf;
+            for (size_t k = 0; k < m; k++) ((double*)dst)[i + k] = (double)fb[k];
+        }
+        i += m;
+    }
+    return 0;
+}
+
+/* Block of a FMT_CHUNK file through its tiles, on the calling thread. */
+static int read_chunk(const char *path, int vec, size_t r0, size_t c0, Mat *dst) {
+    CkFile f;
+    if (ck_open(path, &f) != 0) return -1;
+    int rc = f.vec == vec ? ck_read(&f, r0, c0, dst, NULL, 1) : -1;
+    ck_close(&f);
+    return rc;
+}
+
+int m_read_block(const char *path, size_t r0, size_t c0, Mat *dst) {
+    size_t rows, cols;
+    DType fdt;
+    if (!dst || !dst->data) return -1;
+    if (ck_is_chunk(path)) return read_chunk(path, 0, r0, c0, dst);
+    if (m_bin_info(path, &rows, &cols, &fdt) != 0) return -1;
+    if (r0 + dst->rows > rows || c0 + dst->cols > cols) return -1;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { perror("open"); return -1; }
+    const size_t esz = dt_size(dst->dt);
+    int rc = 0;
+    for (size_t i = 0; i < dst->rows && rc == 0; i++) {
+        off_t off = (off_t)(M_BIN_DATA + ((r0 + i) * cols + c0) * dt_size(fdt));
+        rc = pread_elems(fd, off, fdt, (char*)dst->data + i * dst->ld * esz, dst->dt, dst->cols);
+    }
+    close(fd);
+    return rc;
+}
+
+int v_read_block(const char *path, size_t i0, Vec *dst) {
+    size_t len;
+    DType fdt;
+    if (!dst || !dst->data) return -1;
+    if (ck_is_chunk(path)) {
+        Mat col = { .rows = dst->len, .cols = 1, .ld = 1, .data = dst->data, .dt = dst->dt, .mem = MEM_VIEW };
+        return read_chunk(path, 1, i0, 0, &col);
+    }
+    if (v_bin_info(path, &len, &fdt) != 0) return -1;
+    if (i0 + dst->len > len) return -1;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { perror("open"); return -1; }
+    int rc = pread_elems(fd, (off_t)(sizeof(uint64_t) + i0 * dt_size(fdt)), fdt, dst->data, dst->dt, dst->len);
+    close(fd);
+    return rc;
+}
+
+int m_map(const char *path, MapAdvice adv, Mat *out) {
+    if (!path || !out) return -1;
+    uint64_t dims[2];
+    DType dt;
+    void *base; size_t len;
+    if (map_bin(path, 2, adv, dims, &dt, &base, &len) != 0) return -1;
+    *out = (Mat){ .rows = (size_t)dims[0], .cols = (size_t)dims[1],
+                  .data = (double*)((char*)base + 2 * sizeof(uint64_t)), .ld = (size_t)dims[1], .dt = dt,
+                  .mem = MEM_MAP, .base = base, .base_len = len };
+    return 0;
+}
+
+int v_map(const char *path, MapAdvice adv, Vec *out) {
+    if (!path || !out) return -1;
+    uint64_t dims[1];
+    DType dt;
+    void *base; size_t len;
+    if (map_bin(path, 1, adv, dims, &dt, &base, &len) != 0) return -1;
+    *out = (Vec){ .len = (size_t)dims[0], .dt = dt,
+                  .data = (double*)((char*)base + sizeof(uint64_t)),
+                  .mem = MEM_MAP, .base = base, .base_len = len };
+    return 0;
+}
+
+/* ---- FMT_TEXT reader --------------------------------------------------
+ * The file is mapped and tokens are parsed in place. The body is split at
+ * whitespace into per-thread chunks: one pass counts tokens per chunk so
+ * each chunk knows its first output index, a second pass parses. Accepts
+ * what "%zu" / "%lf" accept for whitespace-separated tokens and rounds
+ * exactly like strtod, so "%.17g" output round-trips.
+ */
+
+#define TEXT_MIN_CHUNK (1u << 20)
+#define TOKEN_BUF 64
+
+typedef struct {
+    const char *p, *end;   /* unread part of the mapping */
+    void *base;
+    size_t len;
+} TextBuf;
+
+static inline int is_ws(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+static inline int is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static int text_open(const char *path, TextBuf *tb) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) { close(fd); return -1; }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return -1;
+    posix_madvise(p, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+    *tb = (TextBuf){ .p = (const char*)p, .end = (const char*)p + st.st_size,
+                     .base = p, .len = (size_t)st.st_size };
+    return 0;
+}
+
+static void text_close(TextBuf *tb) {
+    munmap(tb->base, tb->len);
+}
+
+static int text_header(TextBuf *tb, int n, size_t *dims) {
+    const char *p = tb->p, *e = tb->end;
+    for (int i = 0; i < n; i++) {
+        while (p < e && is_ws(*p)) p++;
+        if (p < e && *p == '+') p++;
+        if (p == e || !is_digit(*p)) return -1;
+        size_t v = 0;
+        for (; p < e && is_digit(*p); p++) {
+            size_t d = (size_t)(*p - '0');
+            if (v > (SIZE_MAX - d) / 10) return -1;
+            v = v * 10 + d;
+        }
+        dims[i] = v;
+    }
+    tb->p = p;
+    return 0;
+}
+
+/* Token that the fast path cannot prove exact: hand it to strtod. */
+static int parse_slow(const char *s, const char *e, double *out) {
+    char local[TOKEN_BUF];
+    size_t n = (size_t)(e - s);
+    char *buf = n < sizeof(local) ? local : (char*)malloc(n + 1);
+    if (!buf) return -1;
+    memcpy(buf, s, n);
+    buf[n] = '\0';
+    char *stop;
+    *out = strtod(buf, &stop);
+    int ok = stop == buf + n && n > 0;
+    if (buf != local) free(buf);
+    return ok ? 0 : -1;
+}
+
+/*
+ * Parses one token starting at s (not whitespace) into *out; returns the
+ * end of the token or NULL if it is not a number. Up to 19 significant
+ * digits with a small decimal exponent are converted with a single
+ * correctly rounded x87 multiply/divide; results that land exactly on a
+ * double rounding boundary, and everything else, fall back to strtod.
+ */
+static const char *parse_double(const char *s, const char *e, double *out) {
+    const char *p = s;
+    int neg = 0, slow = 0, any = 0, nd = 0;
+    long e10 = 0;
+    uint64_t w = 0;
+
+    if (p < e && (*p == '-' || *p == '+')) { neg = *p == '-'; p++; }
+    while (p < e && *p == '0') { p++; any = 1; }
+    for (; p < e && is_digit(*p); p++, any = 1) {
+        if (nd < 19) { w = w * 10 + (uint64_t)(*p - '0'); nd++; }
+        else { slow = 1; e10++; }
+    }
+    if (p < e && *p == '.') {
+        p++;
+        if (nd == 0) for (; p < e && *p == '0'; p++, any = 1) e10--;
+        for (; p < e && is_digit(*p); p++, any = 1) {
+            if (nd < 19) { w = w * 10 + (uint64_t)(*p - '0'); nd++; e10--; }
+            else slow = 1;
+        }
+    }
+    if (!any) slow = 1;
+    if (!slow && p < e && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int eneg = 0;
+        long x = 0;
+        if (q < e && (*q == '-' || *q == '+')) { eneg = *q == '-'; q++; }
+        if (q == e || !is_digit(*q)) slow = 1;
+        for (; q < e && is_digit(*q); q++) if (x < 100000) x = x * 10 + (*q - '0');
+        e10 += eneg ? -x : x;
+        p = q;
+    }
+    if (p < e && !is_ws(*p)) slow = 1;
+
+    if (!slow) {
+        if (w == 0) { *out = neg ? -0.0 : 0.0; return p; }
+#if LDBL_MANT_DIG == 64 && (defined(__x86_64__) || defined(__i386__))
+        static const long double p10[] = {
+            1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L,
+            1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+            1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+        };
+        /* w and 10^|e10| are exact in the 64-bit significand, so v is one rounding away. */
+        if (e10 >= -27 && e10 <= 27) {
+            long double v = e10 >= 0 ? (long double)w * p10[e10] : (long double)w / p10[-e10];
+            uint64_t sig;
+            memcpy(&sig, &v, sizeof(sig));
+            if ((sig & 0x7FF) != 0x400) {
+                double d = (double)v;
+                *out = neg ? -d : d;
+                return p;
+            }
+        }
+#else
+        static const double p10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        if (w <= (1ull << 53) && e10 >= -22 && e10 <= 22) {
+            double d = e10 >= 0 ? (double)w * p10[e10] : (double)w / p10[-e10];
+            *out = neg ? -d : d;
+            return p;
+        }
+#endif
+    }
+
+    while (p < e && !is_ws(*p)) p++;
+    return parse_slow(s, p, out) == 0 ? p : NULL;
+}
+
+typedef struct {
+    const char *b, *e;
+    char *dst;
+    DType dt;
+    size_t n, cols, ld;      /* element k lands at dst[(k / cols) * ld + k % cols] */
+    int nch, phase;
+    const char *cut[POOL_MAX_THREADS + 1];
+    size_t first[POOL_MAX_THREADS + 1];
+    int err[POOL_MAX_THREADS];
+} ParseJob;
+
+static void parse_worker(void *p, int tid, int nt) {
+    ParseJob *j = (ParseJob*)p;
+    for (int c = tid; c < j->nch; c += nt) {
+        const char *q = j->cut[c], *e = j->cut[c + 1];
+        if (j->phase == 0) {
+            size_t cnt = 0;
+            for (;;) {
+                while (q < e && is_ws(*q)) q++;
+                if (q == e) break;
+                cnt++;
+                while (q < e && !is_ws(*q)) q++;
+            }
+            j->first[c + 1] = cnt;
+        } else {
+            const size_t esz = dt_size(j->dt);
+            size_t k = j->first[c];
+            size_t col = k % j->cols;
+            char *row = j->dst + k / j->cols * j->ld * esz;
+            while (k < j->n) {
+                while (q < e && is_ws(*q)) q++;
+                if (q == e) break;
+                double d;
+                q = parse_double(q, e, &d);
+                if (!q) { j->err[c] = 1; break; }
+                if (j->dt == DT_F32) ((float*)row)[col] = (float)d;
+                else ((double*)row)[col] = d;
+                k++;
+                if (++col == j->cols) { col = 0; row += j->ld * esz; }
+            }
+        }
+    }
+}
+
+/* Parses the first n numbers of the rest of tb into dst, rows of cols values ld apart. */
+static int text_parse(const TextBuf *tb, void *dst, DType dt, size_t n, size_t cols, size_t ld,
+                      const LoadOpts *o) {
+    ParseJob *j = (ParseJob*)calloc(1, sizeof(ParseJob));
+    if (!j) return -1;
+    size_t len = (size_t)(tb->end - tb->p);
+    int nt = (o && o->nt > 1) ? o->nt : 1;
+    if (nt > POOL_MAX_THREADS) nt = POOL_MAX_THREADS;
+    size_t maxch = len / TEXT_MIN_CHUNK + 1;
+    j->b = tb->p; j->e = tb->end; j->dst = (char*)dst; j->dt = dt; j->n = n;
+    j->cols = cols ? cols : 1; j->ld = ld;
+    j->nch = (size_t)nt < maxch ? nt : (int)maxch;
+
+    /* Chunk boundaries are moved forward onto whitespace so no token is split. */
+    j->cut[0] = j->b;
+    for (int c = 1; c < j->nch; c++) {
+        const char *q = j->b + len / (size_t)j->nch * (size_t)c;
+        if (q < j->cut[c - 1]) q = j->cut[c - 1];
+        while (q < j->e && !is_ws(*q)) q++;
+        j->cut[c] = q;
+    }
+    j->cut[j->nch] = j->e;
+
+    Pool *pool = o ? o->pool : NULL;
+    int rc = 0;
+    j->phase = 0;
+    if (pool_run(pool, j->nch, parse_worker, j) < 0) rc = -1;
+    if (rc == 0) {
+        j->first[0] = 0;
+        for (int c = 0; c < j->nch; c++) j->first[c + 1] += j->first[c];
+        if (j->first[j->nch] < n) rc = -1;
+    }
+    if (rc == 0) {
+        j->phase = 1;
+        if (pool_run(pool, j->nch, parse_worker, j) < 0) rc = -1;
+        for (int c = 0; c < j->nch && rc == 0; c++) if (j->err[c]) rc = -1;
+    }
+    free(j);
+    return rc;
+}
+
+/* Element type of the FMT_BIN stream f, read up to its nhdr-word header, holding n values. */
+static int stream_dt(FILE *f, uint64_t n, int nhdr, DType *dt) {
+    struct stat st;
+    if (fstat(fileno(f), &st) != 0) return -1;
+    if (!S_ISREG(st.st_mode)) { *dt = DT_F64; return 0; }   /* size unknown: pipes carry doubles */
+    uint64_t hdr = (uint64_t)nhdr * sizeof(uint64_t);
+    if ((uint64_t)st.st_size < hdr) return -1;
+    return payload_dt(n, (uint64_t)st.st_size - hdr, dt);
+}
+
+/* Reads n elements stored as from into dst of type to. */
+static int read_elems(FILE *f, DType from, void *dst, DType to, size_t n) {
+    if (from == to) return fread(dst, dt_size(to), n, f) == n ? 0 : -1;
+    double buf[512];
+    size_t per = sizeof(buf) / dt_size(from);
+    for (size_t i = 0; i < n; ) {
+        size_t m = n - i < per ? n - i : per;
+        if (fread(buf, dt_size(from), m, f) != m) return -1;
+        if (to == DT_F32) {
+            for (size_t k = 0; k < m; k++) ((float*)dst)[i + k] = (float)buf[k];
+        } else {
+            const float *fb = (const float*)buf;
+            for (size_t k = 0; k < m; k++) ((double*)dst)[i + k] = (double)fb[k];
+        }
+        i += m;
+    }
+    return 0;
 }
 
 int m_load(const char *path, FileFmt fmt, Mat *out) {
+    return m_load_ex(path, fmt, NULL, out);
+}
+
+int m_load_ex(const char *path, FileFmt fmt, const LoadOpts *o, Mat *out) {
     if (!path || !out) return -1;
-    FILE *f = fopen(path, fmt == FMT_BIN ? "rb" : "r");
-    if (!f) { perror("fopen"); return -1; }
+    if (fmt == FMT_BIN && o && o->mmap) {
+        if (m_map(path, o->advice, out) != 0) return -1;
+        if (out->dt == o->dt) return 0;
+        m_free(out);   /* wrong element type: convert through a copy */
+    }
 
     Mat m = {0};
+    if (fmt == FMT_CHUNK) {
+        CkFile f;
+        if (ck_open(path, &f) != 0) return -1;
+        int rc = -1;
+        if (!f.vec) {
+            m = alloc_mat(f.rows, f.cols, o);
+            rc = m.data ? ck_read(&f, 0, 0, &m, o ? o->pool : NULL, o ? o->nt : 1) : -1;
+        }
+        ck_close(&f);
+        if (rc != 0) { m_free(&m); return -1; }
+        *out = m;
+        return 0;
+    }
+
+    TextBuf tb;
+    if (fmt == FMT_TEXT && text_open(path, &tb) == 0) {
+        size_t dims[2];
+        int rc = text_header(&tb, 2, dims);
+        if (rc == 0) {
+            m = alloc_mat(dims[0], dims[1], o);
+            rc = m.data ? text_parse(&tb, m.data, m.dt, dims[0] * dims[1], dims[1], m.ld, o) : -1;
+        }
+        text_close(&tb);
+        if (rc != 0) { m_free(&m); return -1; }
+        *out = m;
+        return 0;
+    }
+
+    /* FMT_BIN, and text streams that cannot be mapped, go through stdio. */
+    FILE *f = fopen(path, fmt == FMT_BIN ? "rb" : "r");
+    if (!f) { perror("fopen"); return -1; }
 
     if (fmt == FMT_TEXT) {
         size_t r, c;
         if (fscanf(f, "%zu %zu", &r, &c) != 2) { fclose(f); return -1; }
-        m = m_alloc(r, c);
+        m = alloc_mat(r, c, o);
         if (!m.data) { fclose(f); return -1; }
-        for (size_t i = 0; i < r * c; i++) {
-            if (fscanf(f, "%lf", &m.data[i]) != 1) {
-                m_free(&m); fclose(f); return -1;
+        for (size_t i = 0; i < r; i++) {
+            for (size_t j = 0; j < c; j++) {
+                double d;
+                if (fscanf(f, "%lf", &d) != 1) {
+                    m_free(&m); fclose(f); return -1;
+                }
+                m_set(&m, i, j, d);
             }
         }
     } else {
         uint64_t r64, c64;
         if (read_u64(f, &r64) || read_u64(f, &c64)) { fclose(f); return -1; }
         if (r64 == 0 || c64 == 0) { fclose(f); return -1; }
-        m = m_alloc((size_t)r64, (size_t)c64);
+        DType fdt;
+        if (r64 > UINT64_MAX / c64 || stream_dt(f, r64 * c64, 2, &fdt) != 0) { fclose(f); return -1; }
+        m = alloc_mat((size_t)r64, (size_t)c64, o);
         if (!m.data) { fclose(f); return -1; }
-        size_t n = m.rows * m.cols;
-        if (fread(m.data, sizeof(double), n, f) != n) {
-            m_free(&m); fclose(f); return -1;
+        const size_t rb = m.ld * dt_size(m.dt);
+        for (size_t i = 0; i < m.rows; i++) {
+            if (read_elems(f, fdt, (char*)m.data + i * rb, m.dt, m.cols) != 0) {
+                m_free(&m); fclose(f); return -1;
+            }
         }
     }
 
@@ -79,14 +730,16 @@ int m_load(const char *path, FileFmt fmt, Mat *out) {
 
 int m_save(const char *path, FileFmt fmt, const Mat *m) {
     if (!path || !m || !m->data) return -1;
+    if (fmt == FMT_CHUNK) return ck_save_mat(path, m, NULL);
     FILE *f = fopen(path, fmt == FMT_BIN ? "wb" : "w");
     if (!f) { perror("fopen"); return -1; }
 
     if (fmt == FMT_TEXT) {
         fprintf(f, "%zu %zu\n", m->rows, m->cols);
+        const int prec = m->dt == DT_F32 ? 9 : 17;
         for (size_t i = 0; i < m->rows; i++) {
             for (size_t j = 0; j < m->cols; j++) {
-                fprintf(f, "%.17g%s", m_get(m, i, j), (j + 1 == m->cols) ? "" : " ");
+                fprintf(f, "%.*g%s", prec, m_get(m, i, j), (j + 1 == m->cols) ? "" : " ");
             }
             fprintf(f, "\n");
         }
@@ -94,8 +747,12 @@ int m_save(const char *path, FileFmt fmt, const Mat *m) {
         if (write_u64(f, (uint64_t)m->rows) || write_u64(f, (uint64_t)m->cols)) {
             fclose(f); return -1;
         }
-        size_t n = m->rows * m->cols;
-        if (fwrite(m->data, sizeof(double), n, f) != n) { fclose(f); return -1; }
+        const size_t esz = dt_size(m->dt);
+        for (size_t i = 0; i < m->rows; i++) {
+            if (fwrite((const char*)m->data + i * m->ld * esz, esz, m->cols, f) != m->cols) {
+                fclose(f); return -1;
+            }
+        }
     }
 
     fclose(f);
@@ -103,28 +760,69 @@ int m_save(const char *path, FileFmt fmt, const Mat *m) {
 }
 
 int v_load(const char *path, FileFmt fmt, Vec *out) {
+    return v_load_ex(path, fmt, NULL, out);
+}
+
+int v_load_ex(const char *path, FileFmt fmt, const LoadOpts *o, Vec *out) {
     if (!path || !out) return -1;
-    FILE *f = fopen(path, fmt == FMT_BIN ? "rb" : "r");
-    if (!f) { perror("fopen"); return -1; }
+    if (fmt == FMT_BIN && o && o->mmap) {
+        if (v_map(path, o->advice, out) != 0) return -1;
+        if (out->dt == o->dt) return 0;
+        v_free(out);
+    }
 
     Vec v = {0};
+    if (fmt == FMT_CHUNK) {
+        CkFile f;
+        if (ck_open(path, &f) != 0) return -1;
+        int rc = -1;
+        if (f.vec) {
+            v = alloc_vec(f.rows, o);
+            Mat col = { .rows = v.len, .cols = 1, .ld = 1, .data = v.data, .dt = v.dt, .mem = MEM_VIEW };
+            rc = v.data ? ck_read(&f, 0, 0, &col, o ? o->pool : NULL, o ? o->nt : 1) : -1;
+        }
+        ck_close(&f);
+        if (rc != 0) { v_free(&v); return -1; }
+        *out = v;
+        return 0;
+    }
+
+    TextBuf tb;
+    if (fmt == FMT_TEXT && text_open(path, &tb) == 0) {
+        size_t n;
+        int rc = text_header(&tb, 1, &n);
+        if (rc == 0) {
+            v = alloc_vec(n, o);
+            rc = v.data ? text_parse(&tb, v.data, v.dt, n, n, n, o) : -1;
+        }
+        text_close(&tb);
+        if (rc != 0) { v_free(&v); return -1; }
+        *out = v;
+        return 0;
+    }
+
+    FILE *f = fopen(path, fmt == FMT_BIN ? "rb" : "r");
+    if (!f) { perror("fopen"); return -1; }
 
     if (fmt == FMT_TEXT) {
         size_t n;
         if (fscanf(f, "%zu", &n) != 1) { fclose(f); return -1; }
-        v = v_alloc(n);
+        v = alloc_vec(n, o);
         if (!v.data) { fclose(f); return -1; }
         for (size_t i = 0; i < n; i++) {
-            if (fscanf(f, "%lf", &v.data[i]) != 1) {
+            double d;
+            if (fscanf(f, "%lf", &d) != 1) {
                 v_free(&v); fclose(f); return -1;
             }
+            v_set(&v, i, d);
         }
     } else {
         uint64_t n64;
-        if (read_u64(f, &n64)) { fclose(f); return -1; }
-        v = v_alloc((size_t)n64);
+        DType fdt;
+        if (read_u64(f, &n64) || stream_dt(f, n64, 1, &fdt) != 0) { fclose(f); return -1; }
+        v = alloc_vec((size_t)n64, o);
         if (!v.data) { fclose(f); return -1; }
-        if (fread(v.data, sizeof(double), v.len, f) != v.len) {
+        if (read_elems(f, fdt, v.data, v.dt, v.len) != 0) {
             v_free(&v); fclose(f); return -1;
         }
     }
@@ -136,17 +834,19 @@ int v_load(const char *path, FileFmt fmt, Vec *out) {
 
 int v_save(const char *path, FileFmt fmt, const Vec *v) {
     if (!path || !v || !v->data) return -1;
+    if (fmt == FMT_CHUNK) return ck_save_vec(path, v, NULL);
     FILE *f = fopen(path, fmt == FMT_BIN ? "wb" : "w");
     if (!f) { perror("fopen"); return -1; }
 
     if (fmt == FMT_TEXT) {
         fprintf(f, "%zu\n", v->len);
+        const int prec = v->dt == DT_F32 ? 9 : 17;
         for (size_t i = 0; i < v->len; i++) {
-            fprintf(f, "%.17g\n", v->data[i]);
+            fprintf(f, "%.*g\n", prec, v_get(v, i));
         }
     } else {
         if (write_u64(f, (uint64_t)v->len)) { fclose(f); return -1; }
-        if (fwrite(v->data, sizeof(double), v->len, f) != v->len) { fclose(f); return -1; }
+        if (fwrite(v->data, dt_size(v->dt), v->len, f) != v->len) { fclose(f); return -1; }
     }
 
     fclose(f);
@@ -1,38 +1,142 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include "pool.h"
 #include <stddef.h>
 #include <stdint.h>
 
+/* Where a Mat/Vec buffer came from, so m_free/v_free can release it. */
+typedef enum { MEM_HEAP = 0, MEM_MAP, MEM_ANON, MEM_VIEW, MEM_ARENA } MemKind;
+
+/* Row alignment of allocated matrices, in bytes. */
+#define MAT_ALIGN 64
+
+/* Element type. data is valid for DT_F64, f32 for DT_F32 (same pointer). */
+typedef enum { DT_F64 = 0, DT_F32 } DType;
+
+static inline size_t dt_size(DType t) { return t == DT_F32 ? sizeof(float) : sizeof(double); }
+
+/*
+ * Row-major with leading dimension ld >= cols: element (i, j) lives at
+ * data[i * ld + j]. m_alloc rounds ld up to a multiple of MAT_ALIGN
+ * bytes (64-byte aligned rows) and bumps it off multiples of 4 KiB to
+ * avoid set aliasing; mapped files and views keep their source's ld.
+ * ld counts elements of type dt.
+ */
 typedef struct {
     size_t rows;
     size_t cols;
-    double *data;
+    union { double *data; float *f32; };
+    size_t ld;
+    DType dt;
+    MemKind mem;
+    void *base;       /* MEM_MAP/MEM_ANON: start and length of the mapping */
+    size_t base_len;
 } Mat;
 
 typedef struct {
     size_t len;
-    double *data;
+    union { double *data; float *f32; };
+    DType dt;
+    MemKind mem;
+    void *base;
+    size_t base_len;
 } Vec;
 
-typedef enum { FMT_TEXT, FMT_BIN } FileFmt;
+/* FMT_CHUNK: tiled, compressed, checksummed container (chunk.h). */
+typedef enum { FMT_TEXT, FMT_BIN, FMT_CHUNK } FileFmt;
+
+typedef enum { ADV_NORMAL, ADV_SEQUENTIAL, ADV_RANDOM, ADV_WILLNEED } MapAdvice;
+
+typedef struct {
+    int mmap;           /* FMT_BIN: map the file read-only instead of copying it */
+    MapAdvice advice;   /* access hint for mapped data */
+    int nt;             /* FMT_TEXT: parser threads (<= 1: serial) */
+    Pool *pool;
+    int numa;           /* allocate with m_alloc_local/v_alloc_local over pool/nt */
+    DType dt;           /* element type to load into; files of the other type are converted */
+} LoadOpts;
 
 Mat  m_alloc(size_t r, size_t c);
+Mat  m_alloc_dt(size_t r, size_t c, DType dt);
 void m_free(Mat *m);
 Vec  v_alloc(size_t n);
+Vec  v_alloc_dt(size_t n, DType dt);
 void v_free(Vec *v);
 
+/*
+ * NUMA-aware variants: pages are left untouched by the allocator and
+ * first zeroed by thread t of nt for its row_range() share, so each
+ * block lands on the node of the (pinned) thread that will compute on it.
+ */
+Mat  m_alloc_local(size_t r, size_t c, DType dt, Pool *p, int nt);
+Vec  v_alloc_local(size_t n, DType dt, Pool *p, int nt);
+
+/*
+ * Zeroed buffers drawn from the process arena (arena.h) and handed back
+ * to it by m_free/v_free, so an equal-sized allocation later reuses the
+ * pages. For results and temporaries that are allocated over and over.
+ */
+Mat  m_alloc_arena(size_t r, size_t c, DType dt);
+Vec  v_alloc_arena(size_t n, DType dt);
+
+/* Padded leading dimension m_alloc uses for a row of c elements of esz bytes. */
+size_t m_ld_for(size_t c, size_t esz);
+
+/* r x c sub-block of A at (i, j), sharing A's storage; m_free only clears it. */
+Mat m_view(const Mat *A, size_t i, size_t j, size_t r, size_t c);
+
 static inline double m_get(const Mat *A, size_t i, size_t j) {
-    return A->data[i * A->cols + j];
+    size_t k = i * A->ld + j;
+    return A->dt == DT_F32 ? (double)A->f32[k] : A->data[k];
 }
 static inline void m_set(Mat *A, size_t i, size_t j, double x) {
-    A->data[i * A->cols + j] = x;
+    size_t k = i * A->ld + j;
+    if (A->dt == DT_F32) A->f32[k] = (float)x;
+    else A->data[k] = x;
+}
+static inline double v_get(const Vec *v, size_t i) {
+    return v->dt == DT_F32 ? (double)v->f32[i] : v->data[i];
+}
+static inline void v_set(Vec *v, size_t i, double x) {
+    if (v->dt == DT_F32) v->f32[i] = (float)x;
+    else v->data[i] = x;
 }
 
 int m_load(const char *path, FileFmt fmt, Mat *out);
+int m_load_ex(const char *path, FileFmt fmt, const LoadOpts *o, Mat *out);
+/* FMT_BIN payloads are written in the element type of m; readers accept either. */
 int m_save(const char *path, FileFmt fmt, const Mat *m);
 
 int v_load(const char *path, FileFmt fmt, Vec *out);
+int v_load_ex(const char *path, FileFmt fmt, const LoadOpts *o, Vec *out);
 int v_save(const char *path, FileFmt fmt, const Vec *v);
 
+/*
+ * Zero-copy FMT_BIN load: data points into a shared read-only mapping
+ * just past the header. Writing through it faults; m_free/v_free unmap.
+ * dt is taken from the file: a payload of exactly 4 bytes per element
+ * is DT_F32, otherwise it must hold 8 bytes per element.
+ */
+int m_map(const char *path, MapAdvice adv, Mat *out);
+
+/*
+ * Dimensions and element type of a FMT_BIN matrix file, whose payload
+ * starts at M_BIN_DATA; FMT_CHUNK files are recognised by their magic.
+ */
+#define M_BIN_DATA (2 * sizeof(uint64_t))
+int m_bin_info(const char *path, size_t *rows, size_t *cols, DType *dt);
+int v_bin_info(const char *path, size_t *len, DType *dt);
+int v_map(const char *path, MapAdvice adv, Vec *out);
+
+/*
+ * Block of a FMT_BIN file read in place with pread and converted to the
+ * destination's dt: dst->rows x dst->cols elements at (r0, c0) into dst
+ * (any ld, e.g. a view), or dst->len elements from i0. Lets a process
+ * read only the blocks it owns. FMT_CHUNK files decode only the tiles
+ * the block overlaps.
+ */
+int m_read_block(const char *path, size_t r0, size_t c0, Mat *dst);
+int v_read_block(const char *path, size_t i0, Vec *dst);
+
 #endif
@@ -0,0 +1,330 @@
+#define _POSIX_C_SOURCE 200809L
+#include "ooc.h"
+#include "bench.h"
+#include "chunk.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+
+extern volatile sig_atomic_t g_stop;
+
+#define OOC_ALIGN 64
+
+/*
+ * Tiles [t*mb, +mb) x [k0, k0+kb) of an r x c file matrix, read in order
+ * into two alternating slots. The reader fills a slot once the consumer
+ * has released it. FMT_CHUNK files are decoded by the reader.
+ */
+typedef struct {
+    int fd;
+    int chunked;
+    CkFile ck;
+    size_t rows, cols, esz;
+    size_t mb, k0, kb, ntiles;
+    char *buf[2];
+    int full[2];
+    int err, stop;
+    double read_s;
+    size_t bytes;
+    Pool *pool;             /* the reader keeps off the CPU of a pinned tid 0 */
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    pthread_t th;
+} Stream;
+
+static int read_full(int fd, void *dst, size_t n, off_t off) {
+    char *p = (char*)dst;
+    while (n > 0) {
+        ssize_t r = pread(fd, p, n, off);
+        if (r <= 0) return -1;
+        p += r; n -= (size_t)r; off += r;
+    }
+    return 0;
+}
+
+static size_t tile_rows(const Stream *s, size_t t) {
+    size_t i0 = t * s->mb;
+    return s->rows - i0 < s->mb ? s->rows - i0 : s->mb;
+}
+
+/* Tile t into dst, rows packed at stride kb. */
+static int read_tile(Stream *s, size_t t, char *dst) {
+    const size_t i0 = t * s->mb, m = tile_rows(s, t);
+    const size_t row = s->cols * s->esz, span = s->kb * s->esz;
+    if (s->chunked) {
+        Mat v = { .rows = m, .cols = s->kb, .ld = s->kb, .dt = s->esz == 4 ? DT_F32 : DT_F64,
+                  .data = (double*)dst, .mem = MEM_VIEW };
+        s->bytes += m * span;
+        return ck_read(&s->ck, i0, s->k0, &v, NULL, 1);
+    }
+    off_t off = (off_t)(M_BIN_DATA + i0 * row + s->k0 * s->esz);
+    if (s->kb == s->cols) {
+        if (read_full(s->fd, dst, m * row, off) != 0) return -1;
+    } else {
+        for (size_t i = 0; i < m; i++, off += (off_t)row)
+            if (read_full(s->fd, dst + i * span, span, off) != 0) return -1;
+    }
+    s->bytes += m * span;
+    /* Panels are read once per pass: keep them from crowding the page cache. */
+    posix_fadvise(s->fd, (off_t)(M_BIN_DATA + i0 * row), (off_t)(m * row), POSIX_FADV_DONTNEED);
+    return 0;
+}
+
+static void *reader(void *p) {
+    Stream *s = (Stream*)p;
+    for (size_t t = 0; t < s->ntiles; t++) {
+        int slot = (int)(t & 1);
+        pthread_mutex_lock(&s->mu);
+        while (s->full[slot] && !s->stop) pthread_cond_wait(&s->cv, &s->mu);
+        int stop = s->stop;
+        pthread_mutex_unlock(&s->mu);
+        if (stop) break;
+
+        double t0 = now_s();
+        int rc = read_tile(s, t, s->buf[slot]);
+        s->read_s += now_s() - t0;
+
+        pthread_mutex_lock(&s->mu);
+        if (rc != 0) s->err = 1;
+        else s->full[slot] = 1;
+        pthread_cond_broadcast(&s->cv);
+        pthread_mutex_unlock(&s->mu);
+        if (rc != 0) break;
+    }
+    return NULL;
+}
+
+static int stream_start(Stream *s) {
+    s->ntiles = (s->rows + s->mb - 1) / s->mb;
+    s->full[0] = s->full[1] = 0;
+    s->err = s->stop = 0;
+    if (pthread_mutex_init(&s->mu, NULL) != 0) return -1;
+    if (pthread_cond_init(&s->cv, NULL) != 0) { pthread_mutex_destroy(&s->mu); return -1; }
+    pthread_attr_t attr;
+    int rc = pool_thread_attr(s->pool, &attr);
+    if (rc == 0) {
+        rc = pthread_create(&s->th, &attr, reader, s) == 0 ? 0 : -1;
+        pthread_attr_destroy(&attr);
+    }
+    if (rc != 0) {
+        pthread_cond_destroy(&s->cv);
+        pthread_mutex_destroy(&s->mu);
+    }
+    return rc;
+}
+
+/* Waits for tile t; NULL if it failed to read. */
+static char *stream_get(Stream *s, size_t t, double *wait_s) {
+    int slot = (int)(t & 1);
+    double t0 = now_s();
+    pthread_mutex_lock(&s->mu);
+    while (!s->full[slot] && !s->err) pthread_cond_wait(&s->cv, &s->mu);
+    char *p = s->full[slot] ? s->buf[slot] : NULL;
+    pthread_mutex_unlock(&s->mu);
+    *wait_s += now_s() - t0;
+    return p;
+}
+
+static void stream_put(Stream *s, size_t t) {
+    pthread_mutex_lock(&s->mu);
+    s->full[t & 1] = 0;
+    pthread_cond_broadcast(&s->cv);
+    pthread_mutex_unlock(&s->mu);
+}
+
+static void stream_stop(Stream *s) {
+    pthread_mutex_lock(&s->mu);
+    s->stop = 1;
+    pthread_cond_broadcast(&s->cv);
+    pthread_mutex_unlock(&s->mu);
+    pthread_join(s->th, NULL);
+    pthread_cond_destroy(&s->cv);
+    pthread_mutex_destroy(&s->mu);
+}
+
+static void *obuf(size_t bytes) {
+    bytes = (bytes + OOC_ALIGN - 1) / OOC_ALIGN * OOC_ALIGN;
+    return aligned_alloc(OOC_ALIGN, bytes ? bytes : OOC_ALIGN);
+}
+
+/* Opens a FMT_BIN matrix for streaming; its element type must be dt. FMT_CHUNK tiles convert. */
+static int stream_open(const char *path, DType dt, Stream *s) {
+    memset(s, 0, sizeof(*s));
+    s->esz = dt_size(dt);
+    if (ck_is_chunk(path)) {
+        s->fd = -1;
+        if (ck_open(path, &s->ck) != 0) return -1;
+        if (s->ck.vec) { ck_close(&s->ck); return -1; }
+        s->chunked = 1;
+        s->rows = s->ck.rows;
+        s->cols = s->ck.cols;
+        return 0;
+    }
+    DType fdt;
+    if (m_bin_info(path, &s->rows, &s->cols, &fdt) != 0) return -1;
+    if (fdt != dt) {
+        fprintf(stderr, "[ooc] %s holds %s; streaming needs the same type as --dtype\n",
+                path, fdt == DT_F32 ? "f32" : "f64");
+        return -1;
+    }
+    s->fd = open(path, O_RDONLY);
+    if (s->fd < 0) { perror("open"); return -1; }
+    posix_fadvise(s->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return 0;
+}
+
+static void stream_close(Stream *s) {
+    if (s->chunked) ck_close(&s->ck);
+    else close(s->fd);
+}
+
+/* A tile edge that is not a multiple of the file's tiles decodes those twice: round it down. */
+static size_t tile_fit(size_t n, size_t tile) {
+    return n > tile ? n - n % tile : n;
+}
+
+/* Tile with rows x kb elements of s, sharing the slot buffer. */
+static Mat tile_view(const Stream *s, size_t t, char *buf) {
+    return (Mat){ .rows = tile_rows(s, t), .cols = s->kb, .ld = s->kb, .dt = s->esz == 4 ? DT_F32 : DT_F64,
+                  .data = (double*)buf, .mem = MEM_VIEW };
+}
+
+/* One sweep over A's tiles: fn(tile, row offset) for each, overlapped with the next read. */
+typedef int (*TileFn)(const Mat *tile, size_t i0, void *arg);
+
+static int sweep(Stream *s, TileFn fn, void *arg, OocStats *st) {
+    if (stream_start(s) != 0) return -1;
+    int rc = 0;
+    for (size_t t = 0; t < s->ntiles && rc == 0 && !g_stop; t++) {
+        char *buf = stream_get(s, t, &st->wait_s);
+        if (!buf) { fprintf(stderr, "[ooc] Read failed\n"); rc = -1; break; }
+        Mat tile = tile_view(s, t, buf);
+        rc = fn(&tile, t * s->mb, arg);
+        stream_put(s, t);
+    }
+    stream_stop(s);
+    st->read_s += s->read_s;
+    st->bytes += s->bytes;
+    s->read_s = 0.0;
+    s->bytes = 0;
+    return rc;
+}
+
+typedef struct { const Vec *x; Vec *y; KCfg cfg; } MVTile;
+
+static int mv_tile(const Mat *tile, size_t i0, void *arg) {
+    MVTile *a = (MVTile*)arg;
+    Vec y = { .len = tile->rows, .dt = a->y->dt, .mem = MEM_VIEW,
+              .data = (double*)((char*)a->y->data + i0 * dt_size(a->y->dt)) };
+    return mv_mt(tile, TR_N, a->x, &y, a->cfg);
+}
+
+int ooc_mv(const char *Apath, const Vec *x, Vec *y, const OocOpts *o, KCfg cfg, OocStats *st) {
+    memset(st, 0, sizeof(*st));
+    Stream s;
+    if (!x || !y || !x->data || !y->data || stream_open(Apath, y->dt, &s) != 0) return -1;
+    s.pool = cfg.pool;
+    int rc = -1;
+    const size_t row = s.cols * s.esz;
+    if (s.cols != x->len || s.rows != y->len) {
+        fprintf(stderr, "[ooc] Dimension mismatch: A=%zux%zu, x=%zu, y=%zu\n", s.rows, s.cols, x->len, y->len);
+        goto out;
+    }
+    if (o->budget / 2 < row) {
+        fprintf(stderr, "[ooc] Budget %zu B holds fewer than two rows of A (%zu B each)\n", o->budget, row);
+        goto out;
+    }
+    s.k0 = 0; s.kb = s.cols;
+    s.mb = o->budget / 2 / row;
+    if (s.mb > s.rows) s.mb = s.rows;
+    if (s.chunked) s.mb = tile_fit(s.mb, s.ck.tile_r);
+    s.buf[0] = obuf(s.mb * row);
+    s.buf[1] = obuf(s.mb * row);
+    if (!s.buf[0] || !s.buf[1]) goto out;
+    st->peak = 2 * s.mb * row;
+    st->mb = s.mb; st->kb = s.kb; st->passes = 1;
+
+    MVTile a = { x, y, cfg };
+    rc = sweep(&s, mv_tile, &a, st);
+out:
+    free(s.buf[0]); free(s.buf[1]);
+    stream_close(&s);
+    return rc;
+}
+
+typedef struct { const Mat *B; Mat *C; KCfg cfg; } MMTile;
+
+static int mm_tile(const Mat *tile, size_t i0, void *arg) {
+    MMTile *a = (MMTile*)arg;
+    Mat C = m_view(a->C, i0, 0, tile->rows, a->C->cols);
+    return mm_acc_mt(tile, a->B, &C, a->cfg);
+}
+
+int ooc_mm(const char *Apath, const char *Bpath, Mat *C, const OocOpts *o, KCfg cfg, OocStats *st) {
+    memset(st, 0, sizeof(*st));
+    Stream sa, sb;
+    if (!C || !C->data) return -1;
+    if (stream_open(Apath, C->dt, &sa) != 0) return -1;
+    if (stream_open(Bpath, C->dt, &sb) != 0) { stream_close(&sa); return -1; }
+
+    sa.pool = sb.pool = cfg.pool;
+    int rc = -1;
+    const size_t esz = sa.esz, K = sa.cols, N = sb.cols, brow = N * esz;
+    if (sb.rows != K || C->rows != sa.rows || C->cols != N) {
+        fprintf(stderr, "[ooc] Dimension mismatch: A=%zux%zu, B=%zux%zu\n", sa.rows, K, sb.rows, N);
+        goto out;
+    }
+    /*
+     * Half the budget for B, half for the two A tiles. B is one panel if
+     * it fits; else two panels of a quarter each, streamed like A, so the
+     * next loads during the sweep over A against the current one.
+     */
+    size_t kb = K, nb = 1;
+    if (K * brow > o->budget / 2) { kb = o->budget / 4 / brow; nb = 2; }
+    if (sa.chunked && kb < K) kb = tile_fit(kb, sa.ck.tile_c);
+    size_t mb = kb ? (o->budget - nb * kb * brow) / 2 / (kb * esz) : 0;
+    if (kb == 0 || mb == 0) {
+        fprintf(stderr, "[ooc] Budget %zu B is too small for %zu row(s) of B (%zu B each)\n", o->budget,
+                nb, brow);
+        goto out;
+    }
+    if (mb > sa.rows) mb = sa.rows;
+    if (sa.chunked) mb = tile_fit(mb, sa.ck.tile_r);
+    sa.mb = mb; sa.kb = kb;
+    sb.mb = kb; sb.k0 = 0; sb.kb = N;
+    sa.buf[0] = obuf(mb * kb * esz);
+    sa.buf[1] = obuf(mb * kb * esz);
+    sb.buf[0] = obuf(kb * brow);
+    sb.buf[1] = nb > 1 ? obuf(kb * brow) : NULL;
+    if (!sa.buf[0] || !sa.buf[1] || !sb.buf[0] || (nb > 1 && !sb.buf[1])) goto out;
+    st->peak = 2 * mb * kb * esz + nb * kb * brow;
+    st->mb = mb; st->kb = kb;
+
+    /* Passes after the first accumulate, so C is cleared once up front. */
+    memset(C->data, 0, C->rows * C->ld * esz);
+    if (stream_start(&sb) != 0) goto out;
+    rc = 0;
+    for (size_t k0 = 0, p = 0; k0 < K && rc == 0 && !g_stop; k0 += kb, p++) {
+        size_t kk = K - k0 < kb ? K - k0 : kb;
+        char *bp = stream_get(&sb, p, &st->wait_s);
+        if (!bp) { fprintf(stderr, "[ooc] Read failed\n"); rc = -1; break; }
+        Mat Bp = { .rows = kk, .cols = N, .ld = N, .dt = C->dt, .data = (double*)bp, .mem = MEM_VIEW };
+
+        sa.k0 = k0; sa.kb = kk;
+        MMTile a = { &Bp, C, cfg };
+        rc = sweep(&sa, mm_tile, &a, st);
+        stream_put(&sb, p);
+        st->passes++;
+    }
+    stream_stop(&sb);
+    st->read_s += sb.read_s;
+    st->bytes += sb.bytes;
+out:
+    free(sa.buf[0]); free(sa.buf[1]); free(sb.buf[0]); free(sb.buf[1]);
+    stream_close(&sa); stream_close(&sb);
+    return rc;
+}
@@ -0,0 +1,37 @@
+#ifndef OOC_H
+#define OOC_H
+
+#include "kernels.h"
+
+/*
+ * Out-of-core mm/mv: A (and B) stay in their FMT_BIN or FMT_CHUNK files
+ * and are read in panels by a dedicated I/O thread into two buffers, so
+ * the next panel loads while the pool computes on the current one. Only
+ * the streamed panels count against budget; x, y and C stay resident. A
+ * FMT_BIN file's element type must match the output's; chunked tiles are
+ * converted as they are decoded.
+ */
+typedef struct {
+    size_t budget;      /* bytes for all streaming buffers */
+} OocOpts;
+
+typedef struct {
+    size_t peak;        /* bytes of streaming buffers allocated */
+    size_t bytes;       /* bytes read from the files */
+    size_t mb, kb;      /* A tile: rows x cols */
+    int passes;         /* B panels (mm), each a full sweep over A */
+    double read_s;      /* time the I/O thread spent in pread */
+    double wait_s;      /* time compute stalled waiting for a panel */
+} OocStats;
+
+/* y = A * x with A read from Apath. */
+int ooc_mv(const char *Apath, const Vec *x, Vec *y, const OocOpts *o, KCfg cfg, OocStats *st);
+
+/*
+ * C = A * B with both read from their files. B is read in row panels
+ * (all of B at once if it fits half the budget); for each, A is swept
+ * in tiles of the matching columns.
+ */
+int ooc_mm(const char *Apath, const char *Bpath, Mat *C, const OocOpts *o, KCfg cfg, OocStats *st);
+
+#endif
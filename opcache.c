@@ -0,0 +1,292 @@
+#define _POSIX_C_SOURCE 200809L
+#include "opcache.h"
+#include "bench.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+enum { K_VEC, K_MAT, K_CSR };
+
+typedef struct Entry {
+    struct Entry *next;     /* heap nodes, so returned pointers survive later inserts */
+    char *path;
+    FileFmt fmt;
+    DType dt;
+    int kind;               /* K_VEC, K_MAT or K_CSR */
+    int busy;               /* being loaded outside the lock: wait, do not touch */
+    int ahead;              /* loaded by the loader and not looked up yet */
+    /* identity of the file when it was loaded */
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    Mat m;
+    Vec v;
+    Csr s;
+} Entry;
+
+/* A queued prefetch: e is busy until the loader fills it. */
+typedef struct Job {
+    struct Job *next;
+    Entry *e;
+    LoadOpts lo;
+} Job;
+
+struct OpCache {
+    Entry *head;
+    int loads, ahead, hits, released;
+    double wait_s;
+    /* mu guards everything above and below; busy entries' payloads belong to their loader */
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    Job *qhead, *qtail;
+    pthread_t th;
+    int started, quit;
+};
+
+OpCache *oc_create(void) {
+    OpCache *c = (OpCache*)calloc(1, sizeof(OpCache));
+    if (!c) return NULL;
+    if (pthread_mutex_init(&c->mu, NULL) != 0) { free(c); return NULL; }
+    if (pthread_cond_init(&c->cv, NULL) != 0) {
+        pthread_mutex_destroy(&c->mu);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+static void drop(Entry *e) {
+    if (e->kind == K_MAT) m_free(&e->m);
+    else if (e->kind == K_CSR) csr_free(&e->s);
+    else v_free(&e->v);
+    e->m = (Mat){0}; e->v = (Vec){0}; e->s = (Csr){0};
+}
+
+void oc_destroy(OpCache *c) {
+    if (!c) return;
+    if (c->started) {
+        pthread_mutex_lock(&c->mu);
+        c->quit = 1;
+        pthread_cond_broadcast(&c->cv);
+        pthread_mutex_unlock(&c->mu);
+        pthread_join(c->th, NULL);
+    }
+    for (Entry *e = c->head, *next; e; e = next) {
+        next = e->next;
+        drop(e);
+        free(e->path);
+        free(e);
+    }
+    pthread_cond_destroy(&c->cv);
+    pthread_mutex_destroy(&c->mu);
+    free(c);
+}
+
+static int same_file(const Entry *e, const struct stat *st) {
+    return e->dev == st->st_dev && e->ino == st->st_ino && e->size == st->st_size &&
+           e->mtime.tv_sec == st->st_mtim.tv_sec && e->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+static void stamp(Entry *e, const struct stat *st) {
+    e->dev = st->st_dev;
+    e->ino = st->st_ino;
+    e->size = st->st_size;
+    e->mtime = st->st_mtim;
+}
+
+static Entry *find(OpCache *c, const char *path, FileFmt fmt, DType dt, int kind) {
+    for (Entry *e = c->head; e; e = e->next)
+        if (e->fmt == fmt && e->dt == dt && e->kind == kind && strcmp(e->path, path) == 0) return e;
+    return NULL;
+}
+
+/* New empty entry at the head of the list; mu held. */
+static Entry *insert(OpCache *c, const char *path, FileFmt fmt, DType dt, int kind) {
+    Entry *e = (Entry*)calloc(1, sizeof(Entry));
+    if (!e) return NULL;
+    e->path = strdup(path);
+    if (!e->path) { free(e); return NULL; }
+    e->fmt = fmt; e->dt = dt; e->kind = kind;
+    e->size = -1;   /* never matches until loaded */
+    e->next = c->head;
+    c->head = e;
+    return e;
+}
+
+/* (Re)loads a busy entry from its file, without mu. 0 on success. */
+static int fill(Entry *e, const LoadOpts *lo) {
+    struct stat st;
+    drop(e);
+    e->size = -1;   /* never matches, so the next lookup retries */
+    if (stat(e->path, &st) != 0) return -1;
+    int rc = e->kind == K_MAT ? m_load_ex(e->path, e->fmt, lo, &e->m)
+           : e->kind == K_CSR ? csr_load(e->path, e->fmt, lo, &e->s)
+           : v_load_ex(e->path, e->fmt, lo, &e->v);
+    if (rc != 0) {
+        e->m = (Mat){0}; e->v = (Vec){0}; e->s = (Csr){0};
+        return -1;
+    }
+    stamp(e, &st);
+    return 0;
+}
+
+/* Returns the up-to-date entry for the key, loading it if needed; NULL on failure. */
+static Entry *lookup(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo, int kind) {
+    if (!c || !path) return NULL;
+    struct stat st;
+    if (stat(path, &st) != 0) return NULL;
+    DType dt = lo ? lo->dt : DT_F64;
+
+    pthread_mutex_lock(&c->mu);
+    Entry *e = find(c, path, fmt, dt, kind);
+    if (e && e->busy) {
+        double t0 = now_s();
+        while (e->busy) pthread_cond_wait(&c->cv, &c->mu);
+        c->wait_s += now_s() - t0;
+    }
+    if (e && same_file(e, &st)) {
+        if (e->ahead) e->ahead = 0;   /* its first use: the load was counted already */
+        else c->hits++;
+        pthread_mutex_unlock(&c->mu);
+        return e;
+    }
+    if (!e) e = insert(c, path, fmt, dt, kind);
+    if (!e) { pthread_mutex_unlock(&c->mu); return NULL; }
+    e->busy = 1;   /* new, or changed on disk since it was loaded */
+    pthread_mutex_unlock(&c->mu);
+
+    int rc = fill(e, lo);
+
+    pthread_mutex_lock(&c->mu);
+    e->busy = 0;
+    e->ahead = 0;
+    if (rc == 0) c->loads++;
+    pthread_cond_broadcast(&c->cv);
+    pthread_mutex_unlock(&c->mu);
+    return rc == 0 ? e : NULL;
+}
+
+const Mat *oc_mat(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo) {
+    Entry *e = lookup(c, path, fmt, lo, K_MAT);
+    return e ? &e->m : NULL;
+}
+
+const Vec *oc_vec(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo) {
+    Entry *e = lookup(c, path, fmt, lo, K_VEC);
+    return e ? &e->v : NULL;
+}
+
+const Csr *oc_csr(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo) {
+    Entry *e = lookup(c, path, fmt, lo, K_CSR);
+    return e ? &e->s : NULL;
+}
+
+/* Fills queued entries one at a time until oc_destroy. */
+static void *loader(void *arg) {
+    OpCache *c = (OpCache*)arg;
+    pthread_mutex_lock(&c->mu);
+    for (;;) {
+        while (!c->qhead && !c->quit) pthread_cond_wait(&c->cv, &c->mu);
+        if (c->quit) break;
+        Job *j = c->qhead;
+        c->qhead = j->next;
+        if (!c->qhead) c->qtail = NULL;
+        pthread_mutex_unlock(&c->mu);
+
+        int rc = fill(j->e, &j->lo);
+
+        pthread_mutex_lock(&c->mu);
+        j->e->busy = 0;
+        if (rc == 0) { j->e->ahead = 1; c->loads++; c->ahead++; }
+        pthread_cond_broadcast(&c->cv);
+        free(j);
+    }
+    /* Nobody waits on unstarted jobs during destroy; just release them. */
+    for (Job *j = c->qhead, *next; j; j = next) {
+        next = j->next;
+        j->e->busy = 0;
+        free(j);
+    }
+    c->qhead = c->qtail = NULL;
+    pthread_mutex_unlock(&c->mu);
+    return NULL;
+}
+
+static void prefetch(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo, int kind) {
+    if (!c || !path || (lo && lo->numa)) return;
+    struct stat st;
+    if (stat(path, &st) != 0) return;
+    DType dt = lo ? lo->dt : DT_F64;
+
+    Job *j = (Job*)calloc(1, sizeof(Job));
+    if (!j) return;
+    if (lo) j->lo = *lo;
+    else j->lo.dt = DT_F64;
+    j->lo.pool = NULL;   /* the pool may be computing; parse on this thread alone */
+    j->lo.nt = 1;
+
+    pthread_mutex_lock(&c->mu);
+    Entry *e = find(c, path, fmt, dt, kind);
+    if ((e && (e->busy || same_file(e, &st))) ||
+        (!e && !(e = insert(c, path, fmt, dt, kind)))) {
+        pthread_mutex_unlock(&c->mu);
+        free(j);
+        return;
+    }
+    if (!c->started) {
+        if (pthread_create(&c->th, NULL, loader, c) != 0) {
+            pthread_mutex_unlock(&c->mu);
+            free(j);
+            return;   /* the lookup loads it instead */
+        }
+        c->started = 1;
+    }
+    e->busy = 1;
+    j->e = e;
+    if (c->qtail) c->qtail->next = j;
+    else c->qhead = j;
+    c->qtail = j;
+    pthread_cond_broadcast(&c->cv);
+    pthread_mutex_unlock(&c->mu);
+}
+
+void oc_prefetch_mat(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo) {
+    prefetch(c, path, fmt, lo, K_MAT);
+}
+
+void oc_prefetch_vec(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo) {
+    prefetch(c, path, fmt, lo, K_VEC);
+}
+
+void oc_prefetch_csr(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo) {
+    prefetch(c, path, fmt, lo, K_CSR);
+}
+
+void oc_release(OpCache *c, const char *path) {
+    if (!c || !path) return;
+    pthread_mutex_lock(&c->mu);
+    for (Entry **pe = &c->head; *pe; ) {
+        Entry *e = *pe;
+        if (e->busy || strcmp(e->path, path) != 0) { pe = &e->next; continue; }
+        *pe = e->next;
+        drop(e);
+        free(e->path);
+        free(e);
+        c->released++;
+    }
+    pthread_mutex_unlock(&c->mu);
+}
+
+void oc_stats(OpCache *c, OcStats *st) {
+    *st = (OcStats){0};
+    if (!c) return;
+    pthread_mutex_lock(&c->mu);
+    st->loads = c->loads;
+    st->ahead = c->ahead;
+    st->hits = c->hits;
+    st->released = c->released;
+    st->wait_s = c->wait_s;
+    pthread_mutex_unlock(&c->mu);
+}
@@ -0,0 +1,54 @@
+#ifndef OPCACHE_H
+#define OPCACHE_H
+
+#include "matrix.h"
+#include "sparse.h"
+
+/*
+ * Load-once operand cache for a batch of ops. Entries are keyed by path,
+ * format, element type and kind (dense matrix, CSR matrix or vector). Each lookup
+ * re-stats the file and reloads it if its mtime, size or inode changed.
+ * Returned operands belong to the cache and are shared read-only: do
+ * not modify or free them. A pointer stays valid until the next lookup
+ * of the same key, oc_release of its path, or oc_destroy.
+ */
+typedef struct OpCache OpCache;
+
+OpCache *oc_create(void);
+/* Waits for a load in progress; queued prefetches that have not started are dropped. */
+void oc_destroy(OpCache *c);
+
+/* NULL if the file cannot be loaded with lo. A key being prefetched is waited for, not loaded twice. */
+const Mat *oc_mat(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo);
+const Vec *oc_vec(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo);
+const Csr *oc_csr(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo);
+
+/*
+ * Queue a load of the key on the cache's loader thread (started on first
+ * use) and return at once, so the file is read while the caller computes.
+ * The loader parses text serially and never uses lo->pool, which may be
+ * busy. Keys already cached or queued are skipped, and so is every key
+ * with lo->numa: first-touch placement needs the pinned pool, so those
+ * load at lookup. A failed prefetch is retried, and reported, by the lookup.
+ */
+void oc_prefetch_mat(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo);
+void oc_prefetch_vec(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo);
+void oc_prefetch_csr(OpCache *c, const char *path, FileFmt fmt, const LoadOpts *lo);
+
+/*
+ * Frees every idle entry loaded from path, for operands no later op
+ * reads. Pointers to them become invalid; entries being loaded are kept.
+ */
+void oc_release(OpCache *c, const char *path);
+
+typedef struct {
+    int loads;        /* loads done so far */
+    int ahead;        /* ... of which by the loader thread */
+    int hits;         /* later lookups answered from memory */
+    int released;     /* entries freed by oc_release */
+    double wait_s;    /* lookups blocked on a load still in progress */
+} OcStats;
+
+void oc_stats(OpCache *c, OcStats *st);
+
+#endif
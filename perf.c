@@ -0,0 +1,122 @@
+#define _GNU_SOURCE
+#include "perf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+struct Perf {
+    int nt;
+    int (*fd)[PE_NEV];      /* per thread; -1 if not open */
+};
+
+static const char *NAMES[PE_NEV] = { "cycles", "instructions", "l1d_miss", "llc_miss", "dtlb_miss" };
+
+const char *perf_event_name(PerfEvent e) {
+    return e < PE_NEV ? NAMES[e] : "?";
+}
+
+static void event_attr(PerfEvent e, struct perf_event_attr *a) {
+    memset(a, 0, sizeof(*a));
+    a->size = sizeof(*a);
+    a->disabled = 1;
+    a->exclude_kernel = 1;
+    a->exclude_hv = 1;
+    a->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (e) {
+        case PE_CYCLES:
+            a->type = PERF_TYPE_HARDWARE; a->config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case PE_INSTR:
+            a->type = PERF_TYPE_HARDWARE; a->config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case PE_L1D_MISS:
+            a->type = PERF_TYPE_HW_CACHE;
+            a->config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PE_DTLB_MISS:
+            /* Load walks: the misses huge pages and --prefetch are meant to cut. */
+            a->type = PERF_TYPE_HW_CACHE;
+            a->config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        default:
+            a->type = PERF_TYPE_HW_CACHE;
+            a->config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+    }
+}
+
+/* pid 0, cpu -1: count the calling thread wherever it runs. */
+static void open_worker(void *p, int tid, int nt) {
+    (void)nt;
+    Perf *f = (Perf*)p;
+    for (int e = 0; e < PE_NEV; e++) {
+        struct perf_event_attr a;
+        event_attr((PerfEvent)e, &a);
+        f->fd[tid][e] = (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+    }
+}
+
+Perf *perf_open(Pool *p) {
+    Perf *f = (Perf*)calloc(1, sizeof(Perf));
+    if (!f) return NULL;
+    f->nt = pool_size(p);
+    f->fd = calloc((size_t)f->nt, sizeof(*f->fd));
+    if (!f->fd || pool_run(p, f->nt, open_worker, f) != f->nt) {
+        perf_close(f);
+        return NULL;
+    }
+    int any = 0;
+    for (int t = 0; t < f->nt; t++)
+        for (int e = 0; e < PE_NEV; e++) any |= f->fd[t][e] >= 0;
+    if (!any) { perf_close(f); return NULL; }
+    return f;
+}
+
+void perf_close(Perf *f) {
+    if (!f) return;
+    if (f->fd) {
+        for (int t = 0; t < f->nt; t++)
+            for (int e = 0; e < PE_NEV; e++)
+                if (f->fd[t][e] >= 0) close(f->fd[t][e]);
+    }
+    free(f->fd);
+    free(f);
+}
+
+static void ctl_all(Perf *f, unsigned long req) {
+    for (int t = 0; t < f->nt; t++)
+        for (int e = 0; e < PE_NEV; e++)
+            if (f->fd[t][e] >= 0) ioctl(f->fd[t][e], req, 0);
+}
+
+void perf_start(Perf *f) { if (f) ctl_all(f, PERF_EVENT_IOC_ENABLE); }
+void perf_stop(Perf *f)  { if (f) ctl_all(f, PERF_EVENT_IOC_DISABLE); }
+void perf_reset(Perf *f) { if (f) ctl_all(f, PERF_EVENT_IOC_RESET); }
+
+int perf_read(Perf *f, int nt, PerfCount *per, PerfCount *sum) {
+    memset(sum, 0, sizeof(*sum));
+    if (!f) return 0;
+    if (nt > f->nt) nt = f->nt;
+    int have = 0;
+    for (int t = 0; t < nt; t++) {
+        PerfCount c = {0};
+        for (int e = 0; e < PE_NEV; e++) {
+            uint64_t buf[3];   /* value, time enabled, time running */
+            if (f->fd[t][e] < 0 || read(f->fd[t][e], buf, sizeof(buf)) != (ssize_t)sizeof(buf))
+                continue;
+            c.ok |= 1u << e;
+            /* Scale up if the event shared its counter with others. */
+            c.v[e] = buf[2] > 0 ? (double)buf[0] * ((double)buf[1] / (double)buf[2]) : 0.0;
+            sum->v[e] += c.v[e];
+        }
+        if (c.ok) have++;
+        sum->ok |= c.ok;
+        if (per) per[t] = c;
+    }
+    return have;
+}
@@ -0,0 +1,41 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include "pool.h"
+
+/* Hardware events counted per pool thread, user space only. */
+typedef enum { PE_CYCLES, PE_INSTR, PE_L1D_MISS, PE_LLC_MISS, PE_DTLB_MISS, PE_NEV } PerfEvent;
+
+/* Bytes per LLC miss: each one fetches a cache line from DRAM (or a remote cache). */
+#define PERF_LINE 64
+
+typedef struct {
+    unsigned ok;            /* bit e set if event e was counted */
+    double v[PE_NEV];       /* scaled for multiplexing */
+} PerfCount;
+
+typedef struct Perf Perf;
+
+/*
+ * Opens the counters on every thread of p. Events the CPU or kernel
+ * does not offer are skipped; NULL if none can be opened (no PMU, or
+ * perf_event_paranoid too strict). Counters start disabled.
+ */
+Perf *perf_open(Pool *p);
+void  perf_close(Perf *f);
+
+/* Enable/disable all counters; counts accumulate across start/stop pairs. */
+void perf_start(Perf *f);
+void perf_stop(Perf *f);
+void perf_reset(Perf *f);
+
+/*
+ * Totals since the last reset: per thread into per[0..nt) (may be NULL)
+ * and summed over the first nt threads into *sum. Returns the number of
+ * threads that have counters.
+ */
+int perf_read(Perf *f, int nt, PerfCount *per, PerfCount *sum);
+
+const char *perf_event_name(PerfEvent e);
+
+#endif
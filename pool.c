@@ -0,0 +1,342 @@
+#define _GNU_SOURCE
+#include "pool.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Busy-wait this many rounds before sleeping; yield every so often in case we are oversubscribed. */
+#define POOL_SPIN  20000
+#define POOL_YIELD 64
+
+typedef struct {
+    Pool *p;
+    int tid;
+    atomic_uint seq;   /* bumped once per job this worker takes part in */
+} Worker;
+
+struct Pool {
+    int nt;
+    pthread_t *ths;
+    Worker *ws;
+    int *node;                 /* NUMA node per tid once pinned, else -1 */
+    int pinned;
+    cpu_set_t allowed;         /* the caller's CPUs before pool_pin */
+
+    pthread_mutex_t run_mtx;   /* serialises pool_run callers */
+    pthread_mutex_t mtx;
+    pthread_cond_t  wake, done;
+
+    PoolFn fn;
+    void *arg;
+    int job_nt;
+    atomic_int pending;
+    atomic_int quit;
+};
+
+static inline void spin_wait(int round) {
+    if (round % POOL_YIELD == POOL_YIELD - 1) { sched_yield(); return; }
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static void* pool_main(void *p) {
+    Worker *w = (Worker*)p;
+    Pool *pl = w->p;
+    unsigned seen = 0;
+
+    for (;;) {
+        unsigned s;
+        int spins = 0;
+        while ((s = atomic_load_explicit(&w->seq, memory_order_acquire)) == seen &&
+               !atomic_load_explicit(&pl->quit, memory_order_acquire) &&
+               spins < POOL_SPIN) {
+            spin_wait(spins++);
+        }
+        if (s == seen && !atomic_load(&pl->quit)) {
+            pthread_mutex_lock(&pl->mtx);
+            while ((s = atomic_load(&w->seq)) == seen && !atomic_load(&pl->quit))
+                pthread_cond_wait(&pl->wake, &pl->mtx);
+            pthread_mutex_unlock(&pl->mtx);
+        }
+        if (s == seen) break;   /* woken by quit */
+        seen = s;
+
+        pl->fn(pl->arg, w->tid, pl->job_nt);
+        if (atomic_fetch_sub_explicit(&pl->pending, 1, memory_order_acq_rel) == 1) {
+            pthread_mutex_lock(&pl->mtx);
+            pthread_cond_signal(&pl->done);
+            pthread_mutex_unlock(&pl->mtx);
+        }
+    }
+    return NULL;
+}
+
+Pool *pool_create(int nt) {
+    if (nt <= 0) nt = 1;
+    if (nt > POOL_MAX_THREADS) nt = POOL_MAX_THREADS;
+
+    Pool *p = (Pool*)calloc(1, sizeof(Pool));
+    if (!p) return NULL;
+    p->nt = 1;
+    p->ths = (pthread_t*)calloc((size_t)nt, sizeof(pthread_t));
+    p->ws  = (Worker*)calloc((size_t)nt, sizeof(Worker));
+    p->node = (int*)calloc((size_t)nt, sizeof(int));
+    if (!p->ths || !p->ws || !p->node) {
+        free(p->ths); free(p->ws); free(p->node); free(p); return NULL;
+    }
+    for (int t = 0; t < nt; t++) p->node[t] = -1;
+
+    pthread_mutex_init(&p->run_mtx, NULL);
+    pthread_mutex_init(&p->mtx, NULL);
+    pthread_cond_init(&p->wake, NULL);
+    pthread_cond_init(&p->done, NULL);
+    atomic_init(&p->pending, 0);
+    atomic_init(&p->quit, 0);
+
+    /* Workers inherit a mask with SIGINT blocked so the handler runs on the caller. */
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    for (int t = 1; t < nt; t++) {
+        p->ws[t].p = p;
+        p->ws[t].tid = t;
+        atomic_init(&p->ws[t].seq, 0u);
+        if (pthread_create(&p->ths[t], NULL, pool_main, &p->ws[t]) != 0) break;
+        p->nt = t + 1;
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    return p;
+}
+
+void pool_destroy(Pool *p) {
+    if (!p) return;
+    pthread_mutex_lock(&p->mtx);
+    atomic_store(&p->quit, 1);
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->mtx);
+    for (int t = 1; t < p->nt; t++) pthread_join(p->ths[t], NULL);
+
+    pthread_cond_destroy(&p->wake);
+    pthread_cond_destroy(&p->done);
+    pthread_mutex_destroy(&p->mtx);
+    pthread_mutex_destroy(&p->run_mtx);
+    free(p->ths); free(p->ws); free(p->node); free(p);
+}
+
+int pool_size(const Pool *p) {
+    return p ? p->nt : 1;
+}
+
+typedef struct {
+    PoolFn fn;
+    void *arg;
+    int tid, nt;
+} Oneshot;
+
+static void* oneshot_main(void *p) {
+    Oneshot *o = (Oneshot*)p;
+    o->fn(o->arg, o->tid, o->nt);
+    return NULL;
+}
+
+static int run_oneshot(int nt, PoolFn fn, void *arg) {
+    if (nt > POOL_MAX_THREADS) nt = POOL_MAX_THREADS;
+    if (nt == 1) { fn(arg, 0, 1); return 1; }
+
+    pthread_t *ths = (pthread_t*)calloc((size_t)nt, sizeof(pthread_t));
+    Oneshot *os = (Oneshot*)calloc((size_t)nt, sizeof(Oneshot));
+    char *ok = (char*)calloc((size_t)nt, 1);
+    if (!ths || !os || !ok) { free(ths); free(os); free(ok); return -1; }
+
+    for (int t = 1; t < nt; t++) {
+        os[t] = (Oneshot){ .fn = fn, .arg = arg, .tid = t, .nt = nt };
+        ok[t] = pthread_create(&ths[t], NULL, oneshot_main, &os[t]) == 0;
+    }
+    fn(arg, 0, nt);
+    /* Any slice whose thread failed to start is run inline. */
+    for (int t = 1; t < nt; t++) {
+        if (ok[t]) pthread_join(ths[t], NULL);
+        else fn(arg, t, nt);
+    }
+    free(ths); free(os); free(ok);
+    return nt;
+}
+
+int pool_run(Pool *p, int nt, PoolFn fn, void *arg) {
+    if (!fn) return -1;
+    if (nt <= 0) nt = 1;
+    if (!p) return run_oneshot(nt, fn, arg);
+    if (nt > p->nt) nt = p->nt;
+    if (nt == 1) { fn(arg, 0, 1); return 1; }
+
+    pthread_mutex_lock(&p->run_mtx);
+    p->fn = fn;
+    p->arg = arg;
+    p->job_nt = nt;
+    atomic_store_explicit(&p->pending, nt - 1, memory_order_relaxed);
+
+    pthread_mutex_lock(&p->mtx);
+    for (int t = 1; t < nt; t++)
+        atomic_fetch_add_explicit(&p->ws[t].seq, 1u, memory_order_release);
+    pthread_cond_broadcast(&p->wake);
+    pthread_mutex_unlock(&p->mtx);
+
+    fn(arg, 0, nt);
+
+    int spins = 0;
+    while (atomic_load_explicit(&p->pending, memory_order_acquire) != 0 && spins < POOL_SPIN) {
+        spin_wait(spins++);
+    }
+    if (atomic_load_explicit(&p->pending, memory_order_acquire) != 0) {
+        pthread_mutex_lock(&p->mtx);
+        while (atomic_load(&p->pending) != 0) pthread_cond_wait(&p->done, &p->mtx);
+        pthread_mutex_unlock(&p->mtx);
+    }
+    pthread_mutex_unlock(&p->run_mtx);
+    return nt;
+}
+
+/* ---- NUMA placement -------------------------------------------------- */
+
+#define MAX_NODES 64
+
+typedef struct {
+    int nnodes;
+    int ncpu[MAX_NODES];
+    int *cpus[MAX_NODES];     /* allowed CPUs of each node, in sysfs order */
+    int *cpu_of;              /* chosen CPU per tid */
+    int failed;
+} PinJob;
+
+/* Parses a sysfs cpulist ("0-3,8,10-11"), keeping CPUs present in allowed. */
+static int read_cpulist(const char *path, const cpu_set_t *allowed, int **out) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int cap = 16, n = 0;
+    int *v = (int*)malloc((size_t)cap * sizeof(int));
+    int a, b;
+    char sep;
+    while (v && fscanf(f, "%d", &a) == 1) {
+        b = a;
+        if (fscanf(f, "%c", &sep) == 1 && sep == '-') {
+            if (fscanf(f, "%d", &b) != 1) break;
+            if (fscanf(f, "%c", &sep) != 1) sep = '\n';
+        }
+        for (int c = a; c <= b; c++) {
+            if (c >= CPU_SETSIZE || !CPU_ISSET(c, allowed)) continue;
+            if (n == cap) {
+                int *nv = (int*)realloc(v, (size_t)(cap *= 2) * sizeof(int));
+                if (!nv) { free(v); v = NULL; break; }
+                v = nv;
+            }
+            v[n++] = c;
+        }
+        if (sep != ',') break;
+    }
+    fclose(f);
+    if (!v) return -1;
+    *out = v;
+    return n;
+}
+
+static void topology(PinJob *j, const cpu_set_t *allowed) {
+    DIR *d = opendir("/sys/devices/system/node");
+    if (d) {
+        int ids[MAX_NODES], nid = 0;
+        struct dirent *e;
+        while ((e = readdir(d)) && nid < MAX_NODES) {
+            int id;
+            char tail;
+            if (sscanf(e->d_name, "node%d%c", &id, &tail) == 1) ids[nid++] = id;
+        }
+        closedir(d);
+        /* readdir order is arbitrary; keep node ids ascending. */
+        for (int i = 1; i < nid; i++)
+            for (int k = i; k > 0 && ids[k - 1] > ids[k]; k--) {
+                int t = ids[k]; ids[k] = ids[k - 1]; ids[k - 1] = t;
+            }
+        for (int i = 0; i < nid; i++) {
+            char path[96];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", ids[i]);
+            int *cpus = NULL;
+            int n = read_cpulist(path, allowed, &cpus);
+            if (n > 0) {
+                j->cpus[j->nnodes] = cpus;
+                j->ncpu[j->nnodes++] = n;
+            } else {
+                free(cpus);
+            }
+        }
+    }
+    if (j->nnodes == 0) {
+        /* No sysfs topology: treat every allowed CPU as one node. */
+        int n = CPU_COUNT(allowed), k = 0;
+        j->cpus[0] = (int*)malloc((size_t)(n ? n : 1) * sizeof(int));
+        for (int c = 0; c < CPU_SETSIZE && j->cpus[0] && k < n; c++)
+            if (CPU_ISSET(c, allowed)) j->cpus[0][k++] = c;
+        j->ncpu[0] = k;
+        j->nnodes = k > 0 ? 1 : 0;
+    }
+}
+
+static void pin_worker(void *p, int tid, int nt) {
+    (void)nt;
+    PinJob *j = (PinJob*)p;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(j->cpu_of[tid], &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) j->failed = 1;
+}
+
+int pool_pin(Pool *p) {
+    if (!p) return -1;
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return -1;
+
+    PinJob j;
+    memset(&j, 0, sizeof(j));
+    topology(&j, &allowed);
+    j.cpu_of = (int*)calloc((size_t)p->nt, sizeof(int));
+    int rc = (j.nnodes > 0 && j.cpu_of) ? 0 : -1;
+
+    int nodes = j.nnodes < p->nt ? j.nnodes : p->nt;
+    for (int t = 0; t < p->nt && rc == 0; t++) {
+        int k = (int)((long)t * nodes / p->nt);
+        int first = (int)(((long)k * p->nt + nodes - 1) / nodes);
+        j.cpu_of[t] = j.cpus[k][(t - first) % j.ncpu[k]];
+        p->node[t] = k;
+    }
+    if (rc == 0) {
+        p->allowed = allowed;
+        p->pinned = 1;
+        pool_run(p, p->nt, pin_worker, &j);
+        if (j.failed) rc = -1;
+    }
+    if (rc != 0)
+        for (int t = 0; t < p->nt; t++) p->node[t] = -1;
+
+    for (int k = 0; k < j.nnodes; k++) free(j.cpus[k]);
+    free(j.cpu_of);
+    return rc == 0 ? nodes : -1;
+}
+
+int pool_thread_attr(const Pool *p, pthread_attr_t *attr) {
+    if (pthread_attr_init(attr) != 0) return -1;
+    if (p && p->pinned && pthread_attr_setaffinity_np(attr, sizeof(p->allowed), &p->allowed) != 0) {
+        pthread_attr_destroy(attr);
+        return -1;
+    }
+    return 0;
+}
+
+int pool_node(const Pool *p, int tid) {
+    if (!p || tid < 0 || tid >= p->nt) return -1;
+    return p->node[tid];
+}
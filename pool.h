@@ -0,0 +1,132 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define POOL_MAX_THREADS 512
+
+/* Cache line size assumed for padding and partition edges. */
+#define POOL_LINE 64
+
+/* One thread's result, alone on its cache line so neighbours' writes do not bounce it. */
+typedef struct { _Alignas(POOL_LINE) double v; } PoolSlot;
+
+typedef struct Pool Pool;
+
+/* Body of a parallel region: called once per participating thread. */
+typedef void (*PoolFn)(void *arg, int tid, int nt);
+
+/* Starts nt-1 long-lived workers; the calling thread acts as tid 0. */
+Pool *pool_create(int nt);
+void  pool_destroy(Pool *p);
+int   pool_size(const Pool *p);
+
+/*
+ * Runs fn on nt threads and returns once all of them are done.
+ * nt is clamped to the pool size; the effective count is returned
+ * (or -1 on error). With p == NULL, threads are spawned for this
+ * call only. Not reentrant: fn must not call pool_run itself.
+ */
+int pool_run(Pool *p, int nt, PoolFn fn, void *arg);
+
+/*
+ * Pins thread t to a CPU of NUMA node t * nodes / size, so threads are
+ * spread evenly over nodes and consecutive tids share one. Returns the
+ * number of nodes used, or -1 if affinity cannot be set.
+ */
+int pool_pin(Pool *p);
+/* Index of the NUMA node thread tid was pinned to, or -1. */
+int pool_node(const Pool *p, int tid);
+/*
+ * Initialises attr for a helper thread started by the caller (tid 0):
+ * once the pool is pinned, with the CPUs the caller had before, so the
+ * helper does not share tid 0's one CPU. 0, or -1 on error.
+ */
+int pool_thread_attr(const Pool *p, pthread_attr_t *attr);
+
+/*
+ * Contiguous block [i0, i1) of nrows owned by thread tid of nt. Kernels
+ * and first-touch allocation share it (via row_range_al below), so pages
+ * are placed on the node of the thread that later computes on them.
+ */
+static inline void row_range(size_t nrows, int tid, int nt, size_t *i0, size_t *i1) {
+    size_t base = nrows / (size_t)nt;
+    size_t rem  = nrows % (size_t)nt;
+    size_t t = (size_t)tid;
+    size_t start = t * base + (t < rem ? t : rem);
+    size_t extra = t < rem ? 1u : 0u;
+    *i0 = start; *i1 = start + base + extra;
+}
+
+/* Items of stride bytes that fill whole lines: the smallest u with u * stride % POOL_LINE == 0. */
+static inline size_t pool_line_unit(size_t stride) {
+    size_t a = stride ? stride : 1, b = POOL_LINE;
+    while (b) { size_t t = a % b; a = b; b = t; }
+    return POOL_LINE / a;
+}
+
+/*
+ * row_range() over units of unit items: every edge but nrows is a
+ * multiple of unit, so threads writing line-aligned data never share a
+ * line at their boundary. Row splits of matrices use the unit of one
+ * element, pool_line_unit(esz) rows. It is a multiple of the unit of any
+ * row stride, so first-touch, mm and the mv family all cut rows at the
+ * same edges.
+ */
+static inline void row_range_al(size_t nrows, size_t unit, int tid, int nt, size_t *i0, size_t *i1) {
+    size_t u = unit ? unit : 1, a, b;
+    row_range((nrows + u - 1) / u, tid, nt, &a, &b);
+    *i0 = a * u < nrows ? a * u : nrows;
+    *i1 = b * u < nrows ? b * u : nrows;
+}
+
+/*
+ * How a kernel hands out [0, n) inside one pool_run. SCHED_STATIC gives
+ * each thread its row_range() block once; SCHED_DYNAMIC hands out
+ * chunk-sized ranges from a shared counter until n is used up, so a
+ * thread that runs slower (SMT sibling, E-core, preempted) simply takes
+ * fewer chunks.
+ */
+typedef enum { SCHED_STATIC, SCHED_DYNAMIC } Sched;
+
+typedef struct {
+    size_t n, chunk, unit;
+    Sched sched;
+    atomic_size_t next;
+} Split;
+
+static inline void split_init(Split *s, size_t n, Sched sched, size_t chunk) {
+    s->n = n;
+    s->chunk = chunk ? chunk : 1;
+    s->unit = 1;
+    s->sched = sched;
+    atomic_init(&s->next, 0);
+}
+
+/* Puts every range edge on a multiple of unit (see row_range_al); rounds the chunk up to match. */
+static inline void split_align(Split *s, size_t unit) {
+    s->unit = unit ? unit : 1;
+    s->chunk = (s->chunk + s->unit - 1) / s->unit * s->unit;
+}
+
+/*
+ * Next range [*i0, *i1) for thread tid of nt; 0 once there is no more.
+ * *taken is per-thread iteration state and must start at 0.
+ */
+static inline int split_next(Split *s, int tid, int nt, int *taken, size_t *i0, size_t *i1) {
+    if (s->sched == SCHED_STATIC) {
+        if (*taken) return 0;
+        *taken = 1;
+        row_range_al(s->n, s->unit, tid, nt, i0, i1);
+        return *i1 > *i0;
+    }
+    size_t b = atomic_fetch_add_explicit(&s->next, s->chunk, memory_order_relaxed);
+    if (b >= s->n) return 0;
+    *i0 = b;
+    *i1 = s->n - b < s->chunk ? s->n : b + s->chunk;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "roof.h"
+#include "matrix.h"
+#include "simd.h"
+#include "bench.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ROOF_RUNS 3
+#define ROOF_KC 256      /* micro-kernel depth: a and b panels stay in L1/L2 */
+#define ROOF_CALLS 2000
+
+typedef struct {
+    const double *buf;
+    size_t n;
+    PoolSlot sink[POOL_MAX_THREADS];
+} BwJob;
+
+static void bw_worker(void *p, int tid, int nt) {
+    BwJob *j = (BwJob*)p;
+    size_t i0, i1;
+    row_range(j->n, tid, nt, &i0, &i1);
+    /* dot(x, x) loads each line once: one read stream. */
+    j->sink[tid].v = simd_ops()->dot(j->buf + i0, j->buf + i0, i1 - i0);
+}
+
+static void peak_worker(void *p, int tid, int nt) {
+    (void)tid; (void)nt;
+    int *fail = (int*)p;
+    const SimdOps *ops = simd_ops();
+    const size_t MR = (size_t)ops->mr, NR = (size_t)ops->nr;
+    double *a = (double*)aligned_alloc(64, MR * ROOF_KC * sizeof(double));
+    double *b = (double*)aligned_alloc(64, NR * ROOF_KC * sizeof(double));
+    double c[SIMD_MAX_MR * SIMD_MAX_NR];
+    if (!a || !b) {
+        *fail = 1;
+        free(a); free(b);
+        return;
+    }
+    memset(a, 0, MR * ROOF_KC * sizeof(double));
+    memset(b, 0, NR * ROOF_KC * sizeof(double));
+    memset(c, 0, sizeof(c));
+    for (int r = 0; r < ROOF_CALLS; r++) ops->ukr(ROOF_KC, a, b, c, NR);
+    free(a); free(b);
+}
+
+int roof_probe(Pool *p, int nt, Roof *r) {
+    memset(r, 0, sizeof(*r));
+    Vec v = v_alloc_local(ROOF_BYTES / sizeof(double), DT_F64, p, nt);
+    if (!v.data) return -1;
+
+    BwJob bw = { .buf = v.data, .n = v.len };
+    double best = 0.0;
+    for (int k = 0; k < ROOF_RUNS; k++) {
+        double t0 = now_s();
+        if (pool_run(p, nt, bw_worker, &bw) < 0) { v_free(&v); return -1; }
+        double t = now_s() - t0;
+        if (t > 0 && (best == 0.0 || t < best)) best = t;
+    }
+    v_free(&v);
+    if (best > 0) r->gbs = (double)ROOF_BYTES / best / 1e9;
+
+    const SimdOps *ops = simd_ops();
+    double flops = 2.0 * ops->mr * ops->nr * ROOF_KC * (double)ROOF_CALLS;
+    int fail = 0;
+    int used = nt;
+    best = 0.0;
+    for (int k = 0; k < ROOF_RUNS; k++) {
+        double t0 = now_s();
+        used = pool_run(p, nt, peak_worker, &fail);
+        if (used < 0 || fail) return -1;
+        double t = now_s() - t0;
+        if (t > 0 && (best == 0.0 || t < best)) best = t;
+    }
+    if (best > 0) r->gflops = flops * used / best / 1e9;
+    return 0;
+}
+
+double roof_bound(const Roof *r, double flops, double bytes, int *mem_bound) {
+    double mem = bytes > 0 ? flops / bytes * r->gbs : r->gflops;
+    *mem_bound = mem < r->gflops;
+    return *mem_bound ? mem : r->gflops;
+}
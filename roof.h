@@ -0,0 +1,27 @@
+#ifndef ROOF_H
+#define ROOF_H
+
+#include "pool.h"
+
+/* Machine ceilings at one thread count, for roofline bounds. */
+typedef struct {
+    double gbs;      /* streaming read bandwidth, GB/s */
+    double gflops;   /* f64 micro-kernel throughput over in-cache panels */
+} Roof;
+
+/* Buffer streamed by the bandwidth probe; well past any LLC. */
+#define ROOF_BYTES ((size_t)256 << 20)
+
+/*
+ * Measures both ceilings on nt threads of p (best of a few runs).
+ * Returns 0, or -1 if a buffer cannot be allocated.
+ */
+int roof_probe(Pool *p, int nt, Roof *r);
+
+/*
+ * Attainable GFLOPS for flops over bytes of memory traffic:
+ * min(peak, intensity * bandwidth). *mem_bound says which ceiling won.
+ */
+double roof_bound(const Roof *r, double flops, double bytes, int *mem_bound);
+
+#endif
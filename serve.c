@@ -0,0 +1,625 @@
+#define _POSIX_C_SOURCE 200809L
+#include "serve.h"
+#include "bench.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/* Doubles converted per send of a payload by the client. */
+#define SERVE_BATCH 8192
+/* Reads of one client per poll round, so a long payload does not starve the others. */
+#define SERVE_READS 64
+
+typedef struct {
+    char name[SERVE_NAME];
+    int vec;
+    Mat m;
+    Vec v;
+} Item;
+
+/*
+ * Client sockets are non-blocking, and all of a client's progress is kept
+ * here, so a client that stalls mid-payload or stops reading holds up
+ * only itself.
+ */
+typedef struct {
+    int fd;                 /* -1: closed, dropped after this poll round */
+    int eof;                /* no more input: close once out has drained */
+    size_t len;             /* bytes waiting in buf */
+    char buf[SERVE_LINE];
+    Vec put;                /* a put whose payload is still arriving */
+    char put_name[SERVE_NAME];
+    size_t put_got;         /* payload bytes received */
+    unsigned char part[sizeof(double)];
+    char *out;              /* reply bytes the socket has not taken yet */
+    size_t out_len, out_off, out_cap;
+} Client;
+
+struct Server {
+    ExecCtx *c;
+    ServeOpts o;
+    struct sockaddr_un addr;
+    int lfd;
+    Item *items;
+    size_t n, cap;
+    Client cl[SERVE_MAX_CLIENTS];
+    int ncl;
+    long requests;
+    double busy_s;          /* time spent in kernels */
+};
+
+static int sock_addr(const char *path, struct sockaddr_un *a) {
+    memset(a, 0, sizeof(*a));
+    a->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(a->sun_path)) return -1;
+    memcpy(a->sun_path, path, strlen(path) + 1);
+    return 0;
+}
+
+static int send_all(int fd, const void *p, size_t n) {
+    const char *b = (const char*)p;
+    while (n > 0) {
+        ssize_t w = send(fd, b, n, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        b += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+/* Room for n more bytes in cl->out; NULL if out of memory. */
+static char *out_reserve(Client *cl, size_t n) {
+    if (cl->out_cap - cl->out_len < n) {
+        size_t cap = cl->out_cap ? cl->out_cap : SERVE_LINE;
+        while (cap - cl->out_len < n) cap *= 2;
+        char *p = (char*)realloc(cl->out, cap);
+        if (!p) return NULL;
+        cl->out = p;
+        cl->out_cap = cap;
+    }
+    return cl->out + cl->out_len;
+}
+
+/* Sends what the socket takes now; -1 if the client has gone. */
+static int flush_out(Client *cl) {
+    while (cl->out_off < cl->out_len) {
+        ssize_t w = send(cl->fd, cl->out + cl->out_off, cl->out_len - cl->out_off, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        cl->out_off += (size_t)w;
+    }
+    cl->out_off = cl->out_len = 0;
+    /* Give back the buffer of a large get. */
+    if (cl->out_cap > 16 * SERVE_LINE) { free(cl->out); cl->out = NULL; cl->out_cap = 0; }
+    return 0;
+}
+
+/* Queues one reply line for the client; -1 if out of memory. */
+static int reply(Client *cl, const char *fmt, ...) {
+    char line[SERVE_LINE];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(line, sizeof(line) - 1, fmt, ap);
+    va_end(ap);
+    if (n < 0) return -1;
+    if ((size_t)n > sizeof(line) - 2) n = (int)sizeof(line) - 2;
+    line[n++] = '\n';
+    char *p = out_reserve(cl, (size_t)n);
+    if (!p) return -1;
+    memcpy(p, line, (size_t)n);
+    cl->out_len += (size_t)n;
+    return 0;
+}
+
+static void client_close(Client *cl) {
+    close(cl->fd);
+    cl->fd = -1;
+    v_free(&cl->put);
+    free(cl->out);
+    cl->out = NULL;
+}
+
+static int parse_fmt_word(const char *s, FileFmt *f) {
+    if (strcmp(s, "text") == 0)  { *f = FMT_TEXT; return 0; }
+    if (strcmp(s, "bin") == 0)   { *f = FMT_BIN; return 0; }
+    if (strcmp(s, "chunk") == 0) { *f = FMT_CHUNK; return 0; }
+    return -1;
+}
+
+static Item *find(Server *s, const char *name) {
+    for (size_t i = 0; i < s->n; i++)
+        if (strcmp(s->items[i].name, name) == 0) return &s->items[i];
+    return NULL;
+}
+
+static void item_free(Item *it) {
+    if (it->vec) v_free(&it->v);
+    else m_free(&it->m);
+}
+
+/* Takes m (or v, with vec) as name, replacing an operand of that name. */
+static int keep(Server *s, const char *name, int vec, Mat *m, Vec *v) {
+    if (strlen(name) >= SERVE_NAME) return -1;
+    Item *it = find(s, name);
+    if (it) {
+        item_free(it);
+    } else {
+        if (s->n == s->cap) {
+            size_t cap = s->cap ? 2 * s->cap : 16;
+            Item *p = (Item*)realloc(s->items, cap * sizeof(Item));
+            if (!p) return -1;
+            s->items = p;
+            s->cap = cap;
+        }
+        it = &s->items[s->n++];
+        memcpy(it->name, name, strlen(name) + 1);
+    }
+    it->vec = vec;
+    it->m = vec ? (Mat){0} : *m;
+    it->v = vec ? *v : (Vec){0};
+    return 0;
+}
+
+static void shape(const Item *it, char *buf, size_t len) {
+    if (it->vec) snprintf(buf, len, "%zu", it->v.len);
+    else snprintf(buf, len, "%zux%zu", it->m.rows, it->m.cols);
+}
+
+static size_t item_bytes(const Item *it) {
+    return it->vec ? it->v.len * dt_size(it->v.dt) : it->m.rows * it->m.ld * dt_size(it->m.dt);
+}
+
+/* Loads path as name; msg gets "NAME SHAPE ms=T" or the error. */
+static int load_item(Server *s, const char *name, const char *path, FileFmt fmt, int vec,
+                     char *msg, size_t len) {
+    Mat m = {0};
+    Vec v = {0};
+    double t0 = now_s();
+    int rc = vec ? v_load_ex(path, fmt, &s->c->lo, &v) : m_load_ex(path, fmt, &s->c->lo, &m);
+    double ms = (now_s() - t0) * 1e3;
+    if (rc != 0) {
+        snprintf(msg, len, "cannot load %s from %s", vec ? "a vector" : "a matrix", path);
+        return -1;
+    }
+    if (keep(s, name, vec, &m, &v) != 0) {
+        if (vec) v_free(&v); else m_free(&m);
+        snprintf(msg, len, "cannot keep %s", name);
+        return -1;
+    }
+    char sh[64];
+    shape(find(s, name), sh, sizeof(sh));
+    snprintf(msg, len, "%s %s ms=%.3f", name, sh, ms);
+    return 0;
+}
+
+Server *serve_open(ExecCtx *c, const ServeOpts *o) {
+    Server *s = (Server*)calloc(1, sizeof(Server));
+    if (!s) return NULL;
+    s->c = c;
+    s->o = *o;
+    if (sock_addr(o->socket, &s->addr) != 0) {
+        fprintf(stderr, "[serve] Socket path too long: %s\n", o->socket);
+        free(s);
+        return NULL;
+    }
+    /* Replace a socket nobody listens on; never remove anything else. */
+    struct stat st;
+    if (lstat(o->socket, &st) == 0) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        int live = probe >= 0 && S_ISSOCK(st.st_mode) &&
+                   connect(probe, (struct sockaddr*)&s->addr, sizeof(s->addr)) == 0;
+        if (probe >= 0) close(probe);
+        if (!S_ISSOCK(st.st_mode) || live) {
+            fprintf(stderr, "[serve] %s %s\n", o->socket,
+                    live ? "already has a server" : "exists and is not a socket");
+            free(s);
+            return NULL;
+        }
+        unlink(o->socket);
+    }
+    s->lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s->lfd < 0 || bind(s->lfd, (struct sockaddr*)&s->addr, sizeof(s->addr)) != 0 ||
+        listen(s->lfd, SERVE_MAX_CLIENTS) != 0) {
+        perror("[serve] socket");
+        if (s->lfd >= 0) close(s->lfd);
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+int serve_load(Server *s, const char *name, const char *path, FileFmt fmt, int vec) {
+    char msg[SERVE_LINE];
+    int rc = load_item(s, name, path, fmt, vec, msg, sizeof(msg));
+    if (rc == 0) printf("[serve] loaded %s\n", msg);
+    else fprintf(stderr, "[serve] %s\n", msg);
+    return rc;
+}
+
+void serve_close(Server *s) {
+    if (!s) return;
+    for (int i = 0; i < s->ncl; i++) if (s->cl[i].fd >= 0) client_close(&s->cl[i]);
+    close(s->lfd);
+    unlink(s->addr.sun_path);
+    for (size_t i = 0; i < s->n; i++) item_free(&s->items[i]);
+    free(s->items);
+    free(s);
+}
+
+/* put NAME N: N doubles follow and are taken as they arrive. -1 drops the client. */
+static int do_put(Server *s, Client *cl, const char *name, const char *count) {
+    char *end;
+    unsigned long long n = strtoull(count, &end, 10);
+    if (*end || n == 0 || n > SIZE_MAX / sizeof(double) || strlen(name) >= SERVE_NAME) {
+        reply(cl, "err put NAME N: bad name or count");
+        return -1;
+    }
+    cl->put = v_alloc_dt((size_t)n, s->c->lo.dt);
+    if (!cl->put.data) {
+        reply(cl, "err put %s: out of memory", name);
+        return -1;
+    }
+    memcpy(cl->put_name, name, strlen(name) + 1);
+    cl->put_got = 0;
+    return 0;
+}
+
+/* Takes payload bytes from the front of buf; keeps the vector once all have come. */
+static void put_feed(Server *s, Client *cl) {
+    size_t total = cl->put.len * sizeof(double), used = 0;
+    while (used < cl->len && cl->put_got < total) {
+        size_t at = cl->put_got % sizeof(double), k = sizeof(double) - at;
+        if (k > cl->len - used) k = cl->len - used;
+        memcpy(cl->part + at, cl->buf + used, k);
+        used += k;
+        cl->put_got += k;
+        if (at + k == sizeof(double)) {
+            double d;
+            memcpy(&d, cl->part, sizeof(d));
+            v_set(&cl->put, cl->put_got / sizeof(double) - 1, d);
+        }
+    }
+    cl->len -= used;
+    memmove(cl->buf, cl->buf + used, cl->len);
+    if (cl->put_got < total) return;
+    size_t len = cl->put.len;
+    if (keep(s, cl->put_name, 1, NULL, &cl->put) == 0) {
+        reply(cl, "ok %s %zu", cl->put_name, len);
+    } else {
+        v_free(&cl->put);
+        reply(cl, "err put %s: cannot keep it", cl->put_name);
+    }
+    cl->put = (Vec){0};
+}
+
+/* The reply and its payload are copied into the outbox, so the operand may change while it drains. */
+static int do_get(Client *cl, const Item *it) {
+    size_t rows = it->vec ? 1 : it->m.rows, cols = it->vec ? it->v.len : it->m.cols;
+    size_t bytes = rows * cols * sizeof(double);
+    if (!out_reserve(cl, bytes + SERVE_LINE)) return reply(cl, "err get %s: out of memory", it->name);
+    if (reply(cl, "ok %s %zu %zu %zu", it->name, it->vec ? it->v.len : rows,
+              it->vec ? (size_t)1 : cols, bytes) != 0) return -1;
+    char *d = out_reserve(cl, bytes);
+    for (size_t i = 0; i < rows; i++)
+        for (size_t j = 0; j < cols; j++, d += sizeof(double)) {
+            double v = it->vec ? v_get(&it->v, j) : m_get(&it->m, i, j);
+            memcpy(d, &v, sizeof(v));
+        }
+    cl->out_len += bytes;
+    return 0;
+}
+
+static double sum_mat(const Mat *m) {
+    double s = 0.0;
+    for (size_t i = 0; i < m->rows; i++)
+        for (size_t j = 0; j < m->cols; j++) s += m_get(m, i, j);
+    return s;
+}
+
+static double sum_vec(const Vec *v) {
+    double s = 0.0;
+    for (size_t i = 0; i < v->len; i++) s += v_get(v, i);
+    return s;
+}
+
+static int do_mm(Server *s, Client *cl, const char *out, const char *a, const char *b) {
+    const Item *A = find(s, a), *B = find(s, b);
+    if (!A || A->vec || !B || B->vec) return reply(cl, "err mm: %s and %s must be loaded matrices", a, b);
+    Mat C;
+    double t0 = now_s();
+    int rc = ctx_mm(s->c, &A->m, &B->m, &C);
+    double sec = now_s() - t0;
+    s->busy_s += sec;
+    if (rc == 2) { m_free(&C); return reply(cl, "err mm: interrupted"); }
+    if (rc != 0)
+        return reply(cl, "err mm: %zux%zu times %zux%zu failed", A->m.rows, A->m.cols, B->m.rows, B->m.cols);
+    double sum = sum_mat(&C);
+    if (keep(s, out, 0, &C, NULL) != 0) { m_free(&C); return reply(cl, "err mm: cannot keep %s", out); }
+    return reply(cl, "ok %s %zux%zu ms=%.3f sum=%.17g", out, C.rows, C.cols, sec * 1e3, sum);
+}
+
+static int do_mv(Server *s, Client *cl, const char *out, const char *a, const char *x) {
+    const Item *A = find(s, a), *X = find(s, x);
+    if (!A || A->vec || !X || !X->vec) return reply(cl, "err mv: %s must be a loaded matrix and %s a vector", a, x);
+    Vec y;
+    double t0 = now_s();
+    int rc = ctx_mv(s->c, &A->m, &X->v, &y);
+    double sec = now_s() - t0;
+    s->busy_s += sec;
+    if (rc == 2) { v_free(&y); return reply(cl, "err mv: interrupted"); }
+    if (rc != 0) return reply(cl, "err mv: %zux%zu times %zu failed", A->m.rows, A->m.cols, X->v.len);
+    double sum = sum_vec(&y);
+    if (keep(s, out, 1, NULL, &y) != 0) { v_free(&y); return reply(cl, "err mv: cannot keep %s", out); }
+    return reply(cl, "ok %s %zu ms=%.3f sum=%.17g", out, y.len, sec * 1e3, sum);
+}
+
+static int do_list(Server *s, Client *cl) {
+    char line[SERVE_LINE];
+    int n = snprintf(line, sizeof(line), "ok %zu", s->n);
+    for (size_t i = 0; i < s->n && n < (int)sizeof(line); i++) {
+        char sh[64];
+        shape(&s->items[i], sh, sizeof(sh));
+        n += snprintf(line + n, sizeof(line) - (size_t)n, " %s:%s", s->items[i].name, sh);
+    }
+    return reply(cl, "%s", line);
+}
+
+static int do_stats(Server *s, Client *cl) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < s->n; i++) bytes += item_bytes(&s->items[i]);
+    ArenaStats as;
+    arena_stats(&as);
+    return reply(cl, "ok operands=%zu resident_mib=%.1f requests=%ld busy_ms=%.3f threads=%d "
+                 "arena_gets=%zu arena_reuses=%zu", s->n, (double)bytes / (1024.0 * 1024.0),
+                 s->requests, s->busy_s * 1e3, s->c->nt, as.gets, as.reuses);
+}
+
+/* 0 to go on, 1 after shutdown, -1 to drop the client. */
+static int handle(Server *s, Client *cl, char *line) {
+    char *w[7], *save = NULL;
+    int n = 0;
+    for (char *t = strtok_r(line, " \t\r", &save); t && n < 7; t = strtok_r(NULL, " \t\r", &save)) w[n++] = t;
+    if (n == 0) return 0;
+    s->requests++;
+    const char *op = w[0];
+    int rc;
+    if (strcmp(op, "load") == 0 && n >= 3 && n <= 5) {
+        FileFmt fmt = s->o.fmt;
+        int vec = 0, bad = 0;
+        for (int i = 3; i < n; i++) {
+            if (strcmp(w[i], "vec") == 0) vec = 1;
+            else if (parse_fmt_word(w[i], &fmt) != 0) bad = 1;
+        }
+        char msg[SERVE_LINE];
+        if (bad) rc = reply(cl, "err load NAME PATH [text|bin|chunk] [vec]");
+        else if (load_item(s, w[1], w[2], fmt, vec, msg, sizeof(msg)) == 0) rc = reply(cl, "ok %s", msg);
+        else rc = reply(cl, "err %s", msg);
+    } else if (strcmp(op, "put") == 0 && n == 3) {
+        rc = do_put(s, cl, w[1], w[2]);
+    } else if (strcmp(op, "get") == 0 && n == 2) {
+        const Item *it = find(s, w[1]);
+        rc = it ? do_get(cl, it) : reply(cl, "err no operand %s", w[1]);
+    } else if (strcmp(op, "mm") == 0 && n == 4) {
+        rc = do_mm(s, cl, w[1], w[2], w[3]);
+    } else if (strcmp(op, "mv") == 0 && n == 4) {
+        rc = do_mv(s, cl, w[1], w[2], w[3]);
+    } else if (strcmp(op, "save") == 0 && (n == 3 || n == 4)) {
+        const Item *it = find(s, w[1]);
+        FileFmt fmt = s->o.fmt;
+        if (!it) rc = reply(cl, "err no operand %s", w[1]);
+        else if (n == 4 && parse_fmt_word(w[3], &fmt) != 0) rc = reply(cl, "err save NAME PATH [text|bin|chunk]");
+        else {
+            double t0 = now_s();
+            int r = it->vec ? v_save(w[2], fmt, &it->v) : m_save(w[2], fmt, &it->m);
+            rc = r == 0 ? reply(cl, "ok %s ms=%.3f", it->name, (now_s() - t0) * 1e3)
+                        : reply(cl, "err cannot write %s", w[2]);
+        }
+    } else if (strcmp(op, "drop") == 0 && n == 2) {
+        Item *it = find(s, w[1]);
+        if (!it) {
+            rc = reply(cl, "err no operand %s", w[1]);
+        } else {
+            item_free(it);
+            *it = s->items[--s->n];
+            rc = reply(cl, "ok %s", w[1]);
+        }
+    } else if (strcmp(op, "list") == 0 && n == 1) {
+        rc = do_list(s, cl);
+    } else if (strcmp(op, "stats") == 0 && n == 1) {
+        rc = do_stats(s, cl);
+    } else if (strcmp(op, "shutdown") == 0 && n == 1) {
+        reply(cl, "ok");
+        return 1;
+    } else {
+        rc = reply(cl, "err unknown or malformed request '%s'", op);
+    }
+    return rc == 0 ? 0 : -1;
+}
+
+/*
+ * Runs what the client has sent: payload bytes of a put, then request
+ * lines, stopping while a reply waits to be sent. handle's codes.
+ */
+static int client_run(Server *s, Client *cl) {
+    while (cl->out_len == 0 && !g_stop) {
+        if (cl->put.data) {
+            put_feed(s, cl);
+            if (cl->put.data) return 0;
+        } else {
+            char *nl = (char*)memchr(cl->buf, '\n', cl->len);
+            if (!nl) {
+                if (cl->len == sizeof(cl->buf)) {
+                    reply(cl, "err request longer than %d bytes", SERVE_LINE);
+                    return -1;
+                }
+                return 0;
+            }
+            char line[SERVE_LINE];
+            size_t n = (size_t)(nl - cl->buf);
+            memcpy(line, cl->buf, n);
+            line[n] = '\0';
+            cl->len -= n + 1;
+            memmove(cl->buf, nl + 1, cl->len);
+            int rc = handle(s, cl, line);
+            if (rc != 0) return rc;
+        }
+        if (flush_out(cl) != 0) return -1;
+    }
+    return 0;
+}
+
+/* Reads what the socket has without blocking and runs it; handle's codes. */
+static int client_read(Server *s, Client *cl) {
+    for (int i = 0; i < SERVE_READS && cl->out_len == 0 && cl->len < sizeof(cl->buf); i++) {
+        ssize_t r = recv(cl->fd, cl->buf + cl->len, sizeof(cl->buf) - cl->len, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+        if (r <= 0) {
+            /* Replies to what was sent before the end still go out. */
+            cl->eof = 1;
+            return r == 0 ? client_run(s, cl) : -1;
+        }
+        cl->len += (size_t)r;
+        int rc = client_run(s, cl);
+        if (rc != 0 || g_stop) return rc;
+    }
+    return 0;
+}
+
+int serve_loop(Server *s) {
+    struct pollfd pf[SERVE_MAX_CLIENTS + 1];
+    while (!g_stop) {
+        int n = s->ncl;
+        pf[0] = (struct pollfd){ .fd = s->lfd, .events = POLLIN };
+        for (int i = 0; i < n; i++)
+            pf[i + 1] = (struct pollfd){ .fd = s->cl[i].fd, .events = s->cl[i].out_len ? POLLOUT : POLLIN };
+        if (poll(pf, (nfds_t)n + 1, 500) < 0) {
+            if (errno == EINTR) continue;
+            perror("[serve] poll");
+            return -1;
+        }
+        int quit = 0;
+        for (int i = 0; i < n && !quit && !g_stop; i++) {
+            Client *cl = &s->cl[i];
+            short re = pf[i + 1].revents;
+            int rc = 0;
+            if (re & POLLOUT) {
+                rc = flush_out(cl);
+                if (rc == 0 && cl->out_len == 0) rc = client_run(s, cl);
+            } else if (re & (POLLIN | POLLHUP | POLLERR)) {
+                rc = client_read(s, cl);
+            }
+            if (rc == 1) {
+                flush_out(cl);
+                quit = 1;
+            } else if (rc < 0) {
+                flush_out(cl);
+                client_close(cl);
+            } else if (cl->eof && cl->out_len == 0) {
+                client_close(cl);
+            }
+        }
+        int k = 0;
+        for (int i = 0; i < s->ncl; i++) if (s->cl[i].fd >= 0) s->cl[k++] = s->cl[i];
+        s->ncl = k;
+        if (quit) return 0;
+        if (pf[0].revents & POLLIN) {
+            int fd = accept(s->lfd, NULL, NULL);
+            if (fd >= 0 && (s->ncl == SERVE_MAX_CLIENTS || fcntl(fd, F_SETFL, O_NONBLOCK) != 0)) {
+                char msg[64];
+                int len = snprintf(msg, sizeof(msg), "err server has %d clients\n", SERVE_MAX_CLIENTS);
+                if (send(fd, msg, (size_t)len, MSG_NOSIGNAL | MSG_DONTWAIT) < 0) { /* closing anyway */ }
+                close(fd);
+            } else if (fd >= 0) {
+                s->cl[s->ncl++] = (Client){ .fd = fd };
+            }
+        }
+    }
+    return 2;
+}
+
+/* Reads a get payload of bytes, keeping its first values for the preview. */
+static int read_get(FILE *rd, size_t bytes, double *first, size_t *nf) {
+    double buf[SERVE_BATCH];
+    size_t total = bytes / sizeof(double), seen = 0;
+    *nf = 0;
+    while (seen < total) {
+        size_t k = total - seen < SERVE_BATCH ? total - seen : SERVE_BATCH;
+        if (fread(buf, sizeof(double), k, rd) != k) return -1;
+        for (size_t i = 0; i < k && *nf < 10; i++) first[(*nf)++] = buf[i];
+        seen += k;
+    }
+    return 0;
+}
+
+int serve_send(const char *path, FileFmt fmt, FILE *in) {
+    struct sockaddr_un a;
+    if (sock_addr(path, &a) != 0) { fprintf(stderr, "[send] Socket path too long: %s\n", path); return -1; }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&a, sizeof(a)) != 0) {
+        fprintf(stderr, "[send] Cannot connect to %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    int rfd = dup(fd);
+    FILE *rd = rfd >= 0 ? fdopen(rfd, "r") : NULL;
+    if (!rd) { if (rfd >= 0) close(rfd); close(fd); return -1; }
+
+    char line[SERVE_LINE], req[SERVE_LINE], ans[SERVE_LINE];
+    int errs = 0, rc = 0;
+    while (rc == 0 && fgets(line, sizeof(line), in)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *p = line + strspn(line, " \t");
+        if (!*p || *p == '#') continue;
+        char name[SERVE_NAME], file[SERVE_LINE], cmd[16] = "";
+        sscanf(p, "%15s", cmd);
+        double t0 = now_s();
+        if (strcmp(cmd, "put") == 0 && sscanf(p, "put %63s %4095s", name, file) == 2) {
+            /* The client sends the vector from its own file as doubles. */
+            LoadOpts lo = { .dt = DT_F64 };
+            Vec v;
+            if (v_load_ex(file, fmt, &lo, &v) != 0) {
+                fprintf(stderr, "[send] Cannot load vector %s\n", file);
+                errs++;
+                continue;
+            }
+            snprintf(req, sizeof(req), "put %s %zu\n", name, v.len);
+            rc = send_all(fd, req, strlen(req)) != 0 || send_all(fd, v.data, v.len * sizeof(double)) != 0 ? -1 : 0;
+            v_free(&v);
+        } else {
+            snprintf(req, sizeof(req), "%s\n", p);
+            rc = send_all(fd, req, strlen(req));
+        }
+        if (rc != 0 || !fgets(ans, sizeof(ans), rd)) { rc = -1; break; }
+        ans[strcspn(ans, "\n")] = '\0';
+        size_t rows, cols, bytes, nf = 0;
+        double first[10];
+        int got = strcmp(cmd, "get") == 0 &&
+                  sscanf(ans, "ok %*s %zu %zu %zu", &rows, &cols, &bytes) == 3;
+        if (got && read_get(rd, bytes, first, &nf) != 0) { rc = -1; break; }
+        printf("%s -> %s (%.3f ms round trip)\n", p, ans, (now_s() - t0) * 1e3);
+        if (got) {
+            printf("  [");
+            for (size_t i = 0; i < nf; i++) printf("%s%g", i ? ", " : "", first[i]);
+            printf("%s]\n", rows * cols > nf ? ", ..." : "");
+        }
+        if (strncmp(ans, "ok", 2) != 0) errs++;
+        if (strcmp(cmd, "shutdown") == 0) break;
+    }
+    if (rc != 0) fprintf(stderr, "[send] Connection to %s lost\n", path);
+    fclose(rd);
+    close(fd);
+    return rc != 0 ? -1 : errs ? 1 : 0;
+}
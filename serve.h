@@ -0,0 +1,53 @@
+#ifndef SERVE_H
+#define SERVE_H
+
+#include "ctx.h"
+#include <stdio.h>
+
+/*
+ * Long-lived server on a unix socket: operands stay resident under names
+ * and requests run on one ExecCtx, so a request costs the kernel and not
+ * a process launch, a load and a new pool. Requests are lines of words,
+ * answered by one line that starts with "ok" or "err":
+ *
+ *   load NAME PATH [text|bin|chunk] [vec]   load a matrix (or vector)
+ *   put NAME N       followed by N little-endian doubles: a vector
+ *   get NAME         "ok NAME ROWS COLS BYTES", then the doubles, row-major
+ *   mm C A B         C = A * B, kept as C
+ *   mv y A x         y = A * x, kept as y
+ *   save NAME PATH [text|bin|chunk]
+ *   drop NAME | list | stats | shutdown
+ *
+ * Clients are served in turn, one request at a time, since they share
+ * the pool. Their sockets are non-blocking, so a stalled client delays
+ * no one else.
+ */
+#define SERVE_NAME 64
+#define SERVE_LINE 4096
+#define SERVE_MAX_CLIENTS 64
+
+typedef struct {
+    const char *socket;     /* path of the socket; a stale one is replaced */
+    FileFmt fmt;            /* load and save format when a request names none */
+} ServeOpts;
+
+typedef struct Server Server;
+
+/* Binds and listens on o->socket; NULL on error. */
+Server *serve_open(ExecCtx *c, const ServeOpts *o);
+/* A load request made before serving (e.g. from the command line); -1 on error. */
+int  serve_load(Server *s, const char *name, const char *path, FileFmt fmt, int vec);
+/* Serves until a shutdown request (0) or g_stop (2); -1 if the socket fails. */
+int  serve_loop(Server *s);
+/* Frees every operand and removes the socket. */
+void serve_close(Server *s);
+
+/*
+ * Client: sends each line of in to the server at path and prints the
+ * reply with its round-trip time. "put NAME FILE" loads the vector file
+ * in fmt and sends it; a "get" reply prints its first values. 0 if every
+ * reply was ok, 1 if any was an error, -1 if the connection failed.
+ */
+int serve_send(const char *path, FileFmt fmt, FILE *in);
+
+#endif
@@ -0,0 +1,686 @@
+#include "simd.h"
+#include <pthread.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Fixed-size C = A * B, instantiated per variant below. With N constant
+ * the compiler unrolls the j loop into whole vector registers for that
+ * variant's target and keeps the row of C out of memory until the end.
+ */
+#define MM_FIXED(N, SFX, TGT) \
+TGT static void mm##N##_##SFX(const double *restrict A, size_t lda, const double *restrict B, \
+                              size_t ldb, double *restrict C, size_t ldc) { \
+    for (size_t i = 0; i < N; i++) { \
+        double c[N] = {0}; \
+        for (size_t k = 0; k < N; k++) { \
+            const double a = A[i * lda + k]; \
+            for (size_t j = 0; j < N; j++) c[j] += a * B[k * ldb + j]; \
+        } \
+        for (size_t j = 0; j < N; j++) C[i * ldc + j] = c[j]; \
+    } \
+}
+
+#define MM_FIXED_ALL(SFX, TGT) \
+    MM_FIXED(4, SFX, TGT) MM_FIXED(8, SFX, TGT) MM_FIXED(16, SFX, TGT) MM_FIXED(32, SFX, TGT)
+
+#define MM_FIXED_TABLE(SFX) { mm4_##SFX, mm8_##SFX, mm16_##SFX, mm32_##SFX }
+
+/* ---- scalar ---------------------------------------------------------- */
+
+static double dot_scalar(const double *x, const double *y, size_t n) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        s0 += x[k]   * y[k];
+        s1 += x[k+1] * y[k+1];
+        s2 += x[k+2] * y[k+2];
+        s3 += x[k+3] * y[k+3];
+    }
+    for (; k < n; k++) s0 += x[k] * y[k];
+    return (s0 + s1) + (s2 + s3);
+}
+
+static void axpy_scalar(double a, const double *x, double *y, size_t n) {
+    for (size_t k = 0; k < n; k++) y[k] += a * x[k];
+}
+
+static double axdot_scalar(double a, const double *x, double *y, size_t n) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        double y0 = y[k]   + a * x[k],   y1 = y[k+1] + a * x[k+1];
+        double y2 = y[k+2] + a * x[k+2], y3 = y[k+3] + a * x[k+3];
+        y[k] = y0; y[k+1] = y1; y[k+2] = y2; y[k+3] = y3;
+        s0 += y0 * y0; s1 += y1 * y1; s2 += y2 * y2; s3 += y3 * y3;
+    }
+    for (; k < n; k++) { y[k] += a * x[k]; s0 += y[k] * y[k]; }
+    return (s0 + s1) + (s2 + s3);
+}
+
+static void mv_scalar(const double *A, size_t lda, const double *x, double *y, size_t m, size_t n) {
+    for (size_t i = 0; i < m; i++) y[i] = dot_scalar(&A[i * lda], x, n);
+}
+
+static void ukr_scalar(size_t kc, const double *restrict a, const double *restrict b,
+                       double *restrict c, size_t ldc) {
+    enum { R = 4, S = 8 };
+    double acc[R][S] = {{0}};
+    for (size_t k = 0; k < kc; k++) {
+        const double *ak = &a[k * R];
+        const double *bk = &b[k * S];
+        for (int i = 0; i < R; i++) {
+            for (int j = 0; j < S; j++) acc[i][j] += ak[i] * bk[j];
+        }
+    }
+    for (int i = 0; i < R; i++) {
+        for (int j = 0; j < S; j++) c[i * ldc + j] += acc[i][j];
+    }
+}
+
+static float sdot_scalar(const float *x, const float *y, size_t n) {
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        s0 += x[k]   * y[k];
+        s1 += x[k+1] * y[k+1];
+        s2 += x[k+2] * y[k+2];
+        s3 += x[k+3] * y[k+3];
+    }
+    for (; k < n; k++) s0 += x[k] * y[k];
+    return (s0 + s1) + (s2 + s3);
+}
+
+static double dsdot_scalar(const float *x, const float *y, size_t n) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        s0 += (double)x[k]   * y[k];
+        s1 += (double)x[k+1] * y[k+1];
+        s2 += (double)x[k+2] * y[k+2];
+        s3 += (double)x[k+3] * y[k+3];
+    }
+    for (; k < n; k++) s0 += (double)x[k] * y[k];
+    return (s0 + s1) + (s2 + s3);
+}
+
+static void saxpy_scalar(float a, const float *x, float *y, size_t n) {
+    for (size_t k = 0; k < n; k++) y[k] += a * x[k];
+}
+
+static void smv_scalar(const float *A, size_t lda, const float *x, float *y, size_t m, size_t n) {
+    for (size_t i = 0; i < m; i++) y[i] = sdot_scalar(&A[i * lda], x, n);
+}
+
+static void dsmv_scalar(const float *A, size_t lda, const float *x, float *y, size_t m, size_t n) {
+    for (size_t i = 0; i < m; i++) y[i] = (float)dsdot_scalar(&A[i * lda], x, n);
+}
+
+MM_FIXED_ALL(scalar, )
+
+static void stream_scalar(void *dst, const void *src, size_t bytes) {
+    memcpy(dst, src, bytes);
+}
+
+static const SimdOps ops_scalar = {
+    .name = "scalar", .dot = dot_scalar, .axpy = axpy_scalar, .axdot = axdot_scalar, .mv = mv_scalar,
+    .sdot = sdot_scalar, .dsdot = dsdot_scalar, .saxpy = saxpy_scalar,
+    .smv = smv_scalar, .dsmv = dsmv_scalar,
+    .ukr = ukr_scalar, .mr = 4, .nr = 8, .stream = stream_scalar,
+    .mmfix = MM_FIXED_TABLE(scalar)
+};
+
+#ifdef SIMD_X86
+
+/* ---- AVX2 + FMA ------------------------------------------------------ */
+
+__attribute__((target("avx2,fma")))
+static inline double hsum256(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+__attribute__((target("avx2,fma")))
+static double dot_avx2(const double *x, const double *y, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(&x[k]),    _mm256_loadu_pd(&y[k]),    s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(&x[k+4]),  _mm256_loadu_pd(&y[k+4]),  s1);
+        s2 = _mm256_fmadd_pd(_mm256_loadu_pd(&x[k+8]),  _mm256_loadu_pd(&y[k+8]),  s2);
+        s3 = _mm256_fmadd_pd(_mm256_loadu_pd(&x[k+12]), _mm256_loadu_pd(&y[k+12]), s3);
+    }
+    for (; k + 4 <= n; k += 4)
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(&x[k]), _mm256_loadu_pd(&y[k]), s0);
+    double s = hsum256(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+    for (; k < n; k++) s += x[k] * y[k];
+    return s;
+}
+
+__attribute__((target("avx2,fma")))
+static void axpy_avx2(double a, const double *x, double *y, size_t n) {
+    __m256d va = _mm256_set1_pd(a);
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256d y0 = _mm256_fmadd_pd(va, _mm256_loadu_pd(&x[k]),   _mm256_loadu_pd(&y[k]));
+        __m256d y1 = _mm256_fmadd_pd(va, _mm256_loadu_pd(&x[k+4]), _mm256_loadu_pd(&y[k+4]));
+        _mm256_storeu_pd(&y[k], y0);
+        _mm256_storeu_pd(&y[k+4], y1);
+    }
+    for (; k < n; k++) y[k] += a * x[k];
+}
+
+__attribute__((target("avx2,fma")))
+static double axdot_avx2(double a, const double *x, double *y, size_t n) {
+    __m256d va = _mm256_set1_pd(a);
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256d y0 = _mm256_fmadd_pd(va, _mm256_loadu_pd(&x[k]),   _mm256_loadu_pd(&y[k]));
+        __m256d y1 = _mm256_fmadd_pd(va, _mm256_loadu_pd(&x[k+4]), _mm256_loadu_pd(&y[k+4]));
+        _mm256_storeu_pd(&y[k], y0);
+        _mm256_storeu_pd(&y[k+4], y1);
+        s0 = _mm256_fmadd_pd(y0, y0, s0);
+        s1 = _mm256_fmadd_pd(y1, y1, s1);
+    }
+    double s = hsum256(_mm256_add_pd(s0, s1));
+    for (; k < n; k++) { y[k] += a * x[k]; s += y[k] * y[k]; }
+    return s;
+}
+
+/* Four rows at a time so each load of x feeds four FMAs. */
+__attribute__((target("avx2,fma")))
+static void mv_avx2(const double *A, size_t lda, const double *x, double *y, size_t m, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4) {
+        const double *r0 = &A[i * lda], *r1 = r0 + lda, *r2 = r1 + lda, *r3 = r2 + lda;
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+        size_t k = 0;
+        for (; k + 4 <= n; k += 4) {
+            __m256d xv = _mm256_loadu_pd(&x[k]);
+            s0 = _mm256_fmadd_pd(_mm256_loadu_pd(&r0[k]), xv, s0);
+            s1 = _mm256_fmadd_pd(_mm256_loadu_pd(&r1[k]), xv, s1);
+            s2 = _mm256_fmadd_pd(_mm256_loadu_pd(&r2[k]), xv, s2);
+            s3 = _mm256_fmadd_pd(_mm256_loadu_pd(&r3[k]), xv, s3);
+        }
+        double t0 = hsum256(s0), t1 = hsum256(s1), t2 = hsum256(s2), t3 = hsum256(s3);
+        for (; k < n; k++) {
+            t0 += r0[k] * x[k]; t1 += r1[k] * x[k];
+            t2 += r2[k] * x[k]; t3 += r3[k] * x[k];
+        }
+        y[i] = t0; y[i+1] = t1; y[i+2] = t2; y[i+3] = t3;
+    }
+    for (; i < m; i++) y[i] = dot_avx2(&A[i * lda], x, n);
+}
+
+/* 6x8 tile: 12 accumulators, 2 B vectors and 1 broadcast fit the 16 ymm registers. */
+__attribute__((target("avx2,fma")))
+static void ukr_avx2(size_t kc, const double *restrict a, const double *restrict b,
+                     double *restrict c, size_t ldc) {
+    enum { R = 6 };
+    __m256d acc[R][2];
+    for (int i = 0; i < R; i++) acc[i][0] = acc[i][1] = _mm256_setzero_pd();
+    for (size_t k = 0; k < kc; k++) {
+        __m256d b0 = _mm256_loadu_pd(&b[k * 8]);
+        __m256d b1 = _mm256_loadu_pd(&b[k * 8 + 4]);
+        for (int i = 0; i < R; i++) {
+            __m256d ai = _mm256_broadcast_sd(&a[k * R + i]);
+            acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+        }
+    }
+    for (int i = 0; i < R; i++) {
+        double *ci = &c[i * ldc];
+        _mm256_storeu_pd(ci,     _mm256_add_pd(_mm256_loadu_pd(ci),     acc[i][0]));
+        _mm256_storeu_pd(ci + 4, _mm256_add_pd(_mm256_loadu_pd(ci + 4), acc[i][1]));
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline float hsum256_ps(__m256 v) {
+    __m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    return _mm_cvtss_f32(_mm_add_ss(lo, _mm_movehdup_ps(lo)));
+}
+
+__attribute__((target("avx2,fma")))
+static float sdot_avx2(const float *x, const float *y, size_t n) {
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+    __m256 s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k]),    _mm256_loadu_ps(&y[k]),    s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k+8]),  _mm256_loadu_ps(&y[k+8]),  s1);
+        s2 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k+16]), _mm256_loadu_ps(&y[k+16]), s2);
+        s3 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k+24]), _mm256_loadu_ps(&y[k+24]), s3);
+    }
+    for (; k + 8 <= n; k += 8)
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(&x[k]), _mm256_loadu_ps(&y[k]), s0);
+    float s = hsum256_ps(_mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3)));
+    for (; k < n; k++) s += x[k] * y[k];
+    return s;
+}
+
+/* Widens 4 floats at a time; the FMA itself runs on doubles. */
+__attribute__((target("avx2,fma")))
+static double dsdot_avx2(const float *x, const float *y, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        s0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(&x[k])),    _mm256_cvtps_pd(_mm_loadu_ps(&y[k])),    s0);
+        s1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(&x[k+4])),  _mm256_cvtps_pd(_mm_loadu_ps(&y[k+4])),  s1);
+        s2 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(&x[k+8])),  _mm256_cvtps_pd(_mm_loadu_ps(&y[k+8])),  s2);
+        s3 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(&x[k+12])), _mm256_cvtps_pd(_mm_loadu_ps(&y[k+12])), s3);
+    }
+    for (; k + 4 <= n; k += 4)
+        s0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(&x[k])), _mm256_cvtps_pd(_mm_loadu_ps(&y[k])), s0);
+    double s = hsum256(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+    for (; k < n; k++) s += (double)x[k] * y[k];
+    return s;
+}
+
+__attribute__((target("avx2,fma")))
+static void saxpy_avx2(float a, const float *x, float *y, size_t n) {
+    __m256 va = _mm256_set1_ps(a);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m256 y0 = _mm256_fmadd_ps(va, _mm256_loadu_ps(&x[k]),   _mm256_loadu_ps(&y[k]));
+        __m256 y1 = _mm256_fmadd_ps(va, _mm256_loadu_ps(&x[k+8]), _mm256_loadu_ps(&y[k+8]));
+        _mm256_storeu_ps(&y[k], y0);
+        _mm256_storeu_ps(&y[k+8], y1);
+    }
+    for (; k < n; k++) y[k] += a * x[k];
+}
+
+__attribute__((target("avx2,fma")))
+static void smv_avx2(const float *A, size_t lda, const float *x, float *y, size_t m, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4) {
+        const float *r0 = &A[i * lda], *r1 = r0 + lda, *r2 = r1 + lda, *r3 = r2 + lda;
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+        __m256 s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+        size_t k = 0;
+        for (; k + 8 <= n; k += 8) {
+            __m256 xv = _mm256_loadu_ps(&x[k]);
+            s0 = _mm256_fmadd_ps(_mm256_loadu_ps(&r0[k]), xv, s0);
+            s1 = _mm256_fmadd_ps(_mm256_loadu_ps(&r1[k]), xv, s1);
+            s2 = _mm256_fmadd_ps(_mm256_loadu_ps(&r2[k]), xv, s2);
+            s3 = _mm256_fmadd_ps(_mm256_loadu_ps(&r3[k]), xv, s3);
+        }
+        float t0 = hsum256_ps(s0), t1 = hsum256_ps(s1), t2 = hsum256_ps(s2), t3 = hsum256_ps(s3);
+        for (; k < n; k++) {
+            t0 += r0[k] * x[k]; t1 += r1[k] * x[k];
+            t2 += r2[k] * x[k]; t3 += r3[k] * x[k];
+        }
+        y[i] = t0; y[i+1] = t1; y[i+2] = t2; y[i+3] = t3;
+    }
+    for (; i < m; i++) y[i] = sdot_avx2(&A[i * lda], x, n);
+}
+
+__attribute__((target("avx2,fma")))
+static void dsmv_avx2(const float *A, size_t lda, const float *x, float *y, size_t m, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4) {
+        const float *r0 = &A[i * lda], *r1 = r0 + lda, *r2 = r1 + lda, *r3 = r2 + lda;
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+        size_t k = 0;
+        for (; k + 4 <= n; k += 4) {
+            __m256d xv = _mm256_cvtps_pd(_mm_loadu_ps(&x[k]));
+            s0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(&r0[k])), xv, s0);
+            s1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(&r1[k])), xv, s1);
+            s2 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(&r2[k])), xv, s2);
+            s3 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(&r3[k])), xv, s3);
+        }
+        double t0 = hsum256(s0), t1 = hsum256(s1), t2 = hsum256(s2), t3 = hsum256(s3);
+        for (; k < n; k++) {
+            double xk = x[k];
+            t0 += r0[k] * xk; t1 += r1[k] * xk;
+            t2 += r2[k] * xk; t3 += r3[k] * xk;
+        }
+        y[i] = (float)t0; y[i+1] = (float)t1; y[i+2] = (float)t2; y[i+3] = (float)t3;
+    }
+    for (; i < m; i++) y[i] = (float)dsdot_avx2(&A[i * lda], x, n);
+}
+
+MM_FIXED_ALL(avx2, __attribute__((target("avx2,fma"))))
+
+__attribute__((target("avx2,fma")))
+static void stream_avx2(void *dst, const void *src, size_t bytes) {
+    char *d = (char*)dst;
+    const char *s = (const char*)src;
+    size_t head = (32 - ((uintptr_t)d & 31)) & 31;
+    if (head > bytes) head = bytes;
+    memcpy(d, s, head);
+    d += head; s += head; bytes -= head;
+    for (; bytes >= 32; d += 32, s += 32, bytes -= 32)
+        _mm256_stream_si256((__m256i*)d, _mm256_loadu_si256((const __m256i*)s));
+    memcpy(d, s, bytes);
+    _mm_sfence();
+}
+
+static const SimdOps ops_avx2 = {
+    .name = "avx2", .dot = dot_avx2, .axpy = axpy_avx2, .axdot = axdot_avx2, .mv = mv_avx2,
+    .sdot = sdot_avx2, .dsdot = dsdot_avx2, .saxpy = saxpy_avx2,
+    .smv = smv_avx2, .dsmv = dsmv_avx2,
+    .ukr = ukr_avx2, .mr = 6, .nr = 8, .stream = stream_avx2,
+    .mmfix = MM_FIXED_TABLE(avx2)
+};
+
+/* ---- AVX-512F -------------------------------------------------------- */
+
+__attribute__((target("avx512f")))
+static double dot_avx512(const double *x, const double *y, size_t n) {
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    __m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(&x[k]),    _mm512_loadu_pd(&y[k]),    s0);
+        s1 = _mm512_fmadd_pd(_mm512_loadu_pd(&x[k+8]),  _mm512_loadu_pd(&y[k+8]),  s1);
+        s2 = _mm512_fmadd_pd(_mm512_loadu_pd(&x[k+16]), _mm512_loadu_pd(&y[k+16]), s2);
+        s3 = _mm512_fmadd_pd(_mm512_loadu_pd(&x[k+24]), _mm512_loadu_pd(&y[k+24]), s3);
+    }
+    for (; k + 8 <= n; k += 8)
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(&x[k]), _mm512_loadu_pd(&y[k]), s0);
+    if (k < n) {
+        __mmask8 mk = (__mmask8)((1u << (n - k)) - 1u);
+        s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mk, &x[k]), _mm512_maskz_loadu_pd(mk, &y[k]), s1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3)));
+}
+
+__attribute__((target("avx512f")))
+static void axpy_avx512(double a, const double *x, double *y, size_t n) {
+    __m512d va = _mm512_set1_pd(a);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m512d y0 = _mm512_fmadd_pd(va, _mm512_loadu_pd(&x[k]),   _mm512_loadu_pd(&y[k]));
+        __m512d y1 = _mm512_fmadd_pd(va, _mm512_loadu_pd(&x[k+8]), _mm512_loadu_pd(&y[k+8]));
+        _mm512_storeu_pd(&y[k], y0);
+        _mm512_storeu_pd(&y[k+8], y1);
+    }
+    for (; k + 8 <= n; k += 8)
+        _mm512_storeu_pd(&y[k], _mm512_fmadd_pd(va, _mm512_loadu_pd(&x[k]), _mm512_loadu_pd(&y[k])));
+    if (k < n) {
+        __mmask8 mk = (__mmask8)((1u << (n - k)) - 1u);
+        __m512d yv = _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(mk, &x[k]), _mm512_maskz_loadu_pd(mk, &y[k]));
+        _mm512_mask_storeu_pd(&y[k], mk, yv);
+    }
+}
+
+__attribute__((target("avx512f")))
+static double axdot_avx512(double a, const double *x, double *y, size_t n) {
+    __m512d va = _mm512_set1_pd(a);
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        __m512d y0 = _mm512_fmadd_pd(va, _mm512_loadu_pd(&x[k]),   _mm512_loadu_pd(&y[k]));
+        __m512d y1 = _mm512_fmadd_pd(va, _mm512_loadu_pd(&x[k+8]), _mm512_loadu_pd(&y[k+8]));
+        _mm512_storeu_pd(&y[k], y0);
+        _mm512_storeu_pd(&y[k+8], y1);
+        s0 = _mm512_fmadd_pd(y0, y0, s0);
+        s1 = _mm512_fmadd_pd(y1, y1, s1);
+    }
+    for (; k < n; k += 8) {
+        size_t r = n - k < 8 ? n - k : 8;
+        __mmask8 mk = (__mmask8)((1u << r) - 1u);
+        __m512d yv = _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(mk, &x[k]), _mm512_maskz_loadu_pd(mk, &y[k]));
+        _mm512_mask_storeu_pd(&y[k], mk, yv);
+        s0 = _mm512_fmadd_pd(yv, yv, s0);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+}
+
+__attribute__((target("avx512f")))
+static void mv_avx512(const double *A, size_t lda, const double *x, double *y, size_t m, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4) {
+        const double *r0 = &A[i * lda], *r1 = r0 + lda, *r2 = r1 + lda, *r3 = r2 + lda;
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        __m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+        size_t k = 0;
+        for (; k + 8 <= n; k += 8) {
+            __m512d xv = _mm512_loadu_pd(&x[k]);
+            s0 = _mm512_fmadd_pd(_mm512_loadu_pd(&r0[k]), xv, s0);
+            s1 = _mm512_fmadd_pd(_mm512_loadu_pd(&r1[k]), xv, s1);
+            s2 = _mm512_fmadd_pd(_mm512_loadu_pd(&r2[k]), xv, s2);
+            s3 = _mm512_fmadd_pd(_mm512_loadu_pd(&r3[k]), xv, s3);
+        }
+        if (k < n) {
+            __mmask8 mk = (__mmask8)((1u << (n - k)) - 1u);
+            __m512d xv = _mm512_maskz_loadu_pd(mk, &x[k]);
+            s0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mk, &r0[k]), xv, s0);
+            s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mk, &r1[k]), xv, s1);
+            s2 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mk, &r2[k]), xv, s2);
+            s3 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mk, &r3[k]), xv, s3);
+        }
+        y[i]   = _mm512_reduce_add_pd(s0);
+        y[i+1] = _mm512_reduce_add_pd(s1);
+        y[i+2] = _mm512_reduce_add_pd(s2);
+        y[i+3] = _mm512_reduce_add_pd(s3);
+    }
+    for (; i < m; i++) y[i] = dot_avx512(&A[i * lda], x, n);
+}
+
+/* 8x16 tile: 16 accumulators out of 32 zmm registers. */
+__attribute__((target("avx512f")))
+static void ukr_avx512(size_t kc, const double *restrict a, const double *restrict b,
+                       double *restrict c, size_t ldc) {
+    enum { R = 8 };
+    __m512d acc[R][2];
+    for (int i = 0; i < R; i++) acc[i][0] = acc[i][1] = _mm512_setzero_pd();
+    for (size_t k = 0; k < kc; k++) {
+        __m512d b0 = _mm512_loadu_pd(&b[k * 16]);
+        __m512d b1 = _mm512_loadu_pd(&b[k * 16 + 8]);
+        for (int i = 0; i < R; i++) {
+            __m512d ai = _mm512_set1_pd(a[k * R + i]);
+            acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+        }
+    }
+    for (int i = 0; i < R; i++) {
+        double *ci = &c[i * ldc];
+        _mm512_storeu_pd(ci,     _mm512_add_pd(_mm512_loadu_pd(ci),     acc[i][0]));
+        _mm512_storeu_pd(ci + 8, _mm512_add_pd(_mm512_loadu_pd(ci + 8), acc[i][1]));
+    }
+}
+
+__attribute__((target("avx512f")))
+static float sdot_avx512(const float *x, const float *y, size_t n) {
+    __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+    __m512 s2 = _mm512_setzero_ps(), s3 = _mm512_setzero_ps();
+    size_t k = 0;
+    for (; k + 64 <= n; k += 64) {
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(&x[k]),    _mm512_loadu_ps(&y[k]),    s0);
+        s1 = _mm512_fmadd_ps(_mm512_loadu_ps(&x[k+16]), _mm512_loadu_ps(&y[k+16]), s1);
+        s2 = _mm512_fmadd_ps(_mm512_loadu_ps(&x[k+32]), _mm512_loadu_ps(&y[k+32]), s2);
+        s3 = _mm512_fmadd_ps(_mm512_loadu_ps(&x[k+48]), _mm512_loadu_ps(&y[k+48]), s3);
+    }
+    for (; k + 16 <= n; k += 16)
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(&x[k]), _mm512_loadu_ps(&y[k]), s0);
+    if (k < n) {
+        __mmask16 mk = (__mmask16)((1u << (n - k)) - 1u);
+        s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mk, &x[k]), _mm512_maskz_loadu_ps(mk, &y[k]), s1);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(s0, s1), _mm512_add_ps(s2, s3)));
+}
+
+/* Low and high 8 floats of v, widened to doubles. */
+__attribute__((target("avx512f")))
+static inline __m512d cvt_lo(__m512 v) { return _mm512_cvtps_pd(_mm512_castps512_ps256(v)); }
+__attribute__((target("avx512f")))
+static inline __m512d cvt_hi(__m512 v) {
+    return _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)));
+}
+
+__attribute__((target("avx512f")))
+static double dsdot_avx512(const float *x, const float *y, size_t n) {
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    __m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+        __m512 x0 = _mm512_loadu_ps(&x[k]),    y0 = _mm512_loadu_ps(&y[k]);
+        __m512 x1 = _mm512_loadu_ps(&x[k+16]), y1 = _mm512_loadu_ps(&y[k+16]);
+        s0 = _mm512_fmadd_pd(cvt_lo(x0), cvt_lo(y0), s0);
+        s1 = _mm512_fmadd_pd(cvt_hi(x0), cvt_hi(y0), s1);
+        s2 = _mm512_fmadd_pd(cvt_lo(x1), cvt_lo(y1), s2);
+        s3 = _mm512_fmadd_pd(cvt_hi(x1), cvt_hi(y1), s3);
+    }
+    /* Up to 31 left: at most two masked 16-wide steps. */
+    for (; k < n; k += 16) {
+        size_t r = n - k < 16 ? n - k : 16;
+        __mmask16 mk = (__mmask16)((1u << r) - 1u);
+        __m512 xv = _mm512_maskz_loadu_ps(mk, &x[k]), yv = _mm512_maskz_loadu_ps(mk, &y[k]);
+        s0 = _mm512_fmadd_pd(cvt_lo(xv), cvt_lo(yv), s0);
+        s1 = _mm512_fmadd_pd(cvt_hi(xv), cvt_hi(yv), s1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3)));
+}
+
+__attribute__((target("avx512f")))
+static void saxpy_avx512(float a, const float *x, float *y, size_t n) {
+    __m512 va = _mm512_set1_ps(a);
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+        __m512 y0 = _mm512_fmadd_ps(va, _mm512_loadu_ps(&x[k]),    _mm512_loadu_ps(&y[k]));
+        __m512 y1 = _mm512_fmadd_ps(va, _mm512_loadu_ps(&x[k+16]), _mm512_loadu_ps(&y[k+16]));
+        _mm512_storeu_ps(&y[k], y0);
+        _mm512_storeu_ps(&y[k+16], y1);
+    }
+    for (; k + 16 <= n; k += 16)
+        _mm512_storeu_ps(&y[k], _mm512_fmadd_ps(va, _mm512_loadu_ps(&x[k]), _mm512_loadu_ps(&y[k])));
+    if (k < n) {
+        __mmask16 mk = (__mmask16)((1u << (n - k)) - 1u);
+        __m512 yv = _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(mk, &x[k]), _mm512_maskz_loadu_ps(mk, &y[k]));
+        _mm512_mask_storeu_ps(&y[k], mk, yv);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void smv_avx512(const float *A, size_t lda, const float *x, float *y, size_t m, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4) {
+        const float *r0 = &A[i * lda], *r1 = r0 + lda, *r2 = r1 + lda, *r3 = r2 + lda;
+        __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+        __m512 s2 = _mm512_setzero_ps(), s3 = _mm512_setzero_ps();
+        size_t k = 0;
+        for (; k + 16 <= n; k += 16) {
+            __m512 xv = _mm512_loadu_ps(&x[k]);
+            s0 = _mm512_fmadd_ps(_mm512_loadu_ps(&r0[k]), xv, s0);
+            s1 = _mm512_fmadd_ps(_mm512_loadu_ps(&r1[k]), xv, s1);
+            s2 = _mm512_fmadd_ps(_mm512_loadu_ps(&r2[k]), xv, s2);
+            s3 = _mm512_fmadd_ps(_mm512_loadu_ps(&r3[k]), xv, s3);
+        }
+        if (k < n) {
+            __mmask16 mk = (__mmask16)((1u << (n - k)) - 1u);
+            __m512 xv = _mm512_maskz_loadu_ps(mk, &x[k]);
+            s0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mk, &r0[k]), xv, s0);
+            s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mk, &r1[k]), xv, s1);
+            s2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mk, &r2[k]), xv, s2);
+            s3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mk, &r3[k]), xv, s3);
+        }
+        y[i]   = _mm512_reduce_add_ps(s0);
+        y[i+1] = _mm512_reduce_add_ps(s1);
+        y[i+2] = _mm512_reduce_add_ps(s2);
+        y[i+3] = _mm512_reduce_add_ps(s3);
+    }
+    for (; i < m; i++) y[i] = sdot_avx512(&A[i * lda], x, n);
+}
+
+__attribute__((target("avx512f")))
+static void dsmv_avx512(const float *A, size_t lda, const float *x, float *y, size_t m, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4) {
+        const float *r0 = &A[i * lda], *r1 = r0 + lda, *r2 = r1 + lda, *r3 = r2 + lda;
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        __m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+        for (size_t k = 0; k < n; k += 16) {
+            size_t r = n - k < 16 ? n - k : 16;
+            __mmask16 mk = (__mmask16)((1u << r) - 1u);
+            __m512 xv = _mm512_maskz_loadu_ps(mk, &x[k]);
+            __m512d xl = cvt_lo(xv), xh = cvt_hi(xv);
+            __m512 a0 = _mm512_maskz_loadu_ps(mk, &r0[k]), a1 = _mm512_maskz_loadu_ps(mk, &r1[k]);
+            __m512 a2 = _mm512_maskz_loadu_ps(mk, &r2[k]), a3 = _mm512_maskz_loadu_ps(mk, &r3[k]);
+            s0 = _mm512_fmadd_pd(cvt_hi(a0), xh, _mm512_fmadd_pd(cvt_lo(a0), xl, s0));
+            s1 = _mm512_fmadd_pd(cvt_hi(a1), xh, _mm512_fmadd_pd(cvt_lo(a1), xl, s1));
+            s2 = _mm512_fmadd_pd(cvt_hi(a2), xh, _mm512_fmadd_pd(cvt_lo(a2), xl, s2));
+            s3 = _mm512_fmadd_pd(cvt_hi(a3), xh, _mm512_fmadd_pd(cvt_lo(a3), xl, s3));
+        }
+        y[i]   = (float)_mm512_reduce_add_pd(s0);
+        y[i+1] = (float)_mm512_reduce_add_pd(s1);
+        y[i+2] = (float)_mm512_reduce_add_pd(s2);
+        y[i+3] = (float)_mm512_reduce_add_pd(s3);
+    }
+    for (; i < m; i++) y[i] = (float)dsdot_avx512(&A[i * lda], x, n);
+}
+
+MM_FIXED_ALL(avx512, __attribute__((target("avx512f"))))
+
+__attribute__((target("avx512f")))
+static void stream_avx512(void *dst, const void *src, size_t bytes) {
+    char *d = (char*)dst;
+    const char *s = (const char*)src;
+    size_t head = (64 - ((uintptr_t)d & 63)) & 63;
+    if (head > bytes) head = bytes;
+    memcpy(d, s, head);
+    d += head; s += head; bytes -= head;
+    for (; bytes >= 64; d += 64, s += 64, bytes -= 64)
+        _mm512_stream_si512((void*)d, _mm512_loadu_si512((const void*)s));
+    memcpy(d, s, bytes);
+    _mm_sfence();
+}
+
+static const SimdOps ops_avx512 = {
+    .name = "avx512", .dot = dot_avx512, .axpy = axpy_avx512, .axdot = axdot_avx512, .mv = mv_avx512,
+    .sdot = sdot_avx512, .dsdot = dsdot_avx512, .saxpy = saxpy_avx512,
+    .smv = smv_avx512, .dsmv = dsmv_avx512,
+    .ukr = ukr_avx512, .mr = 8, .nr = 16, .stream = stream_avx512,
+    .mmfix = MM_FIXED_TABLE(avx512)
+};
+
+#endif /* SIMD_X86 */
+
+/* ---- dispatch -------------------------------------------------------- */
+
+static const SimdOps *g_auto = &ops_scalar;
+static const SimdOps *g_forced = NULL;
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+
+static void detect(void) {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) { g_auto = &ops_avx512; return; }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { g_auto = &ops_avx2; return; }
+#endif
+    g_auto = &ops_scalar;
+}
+
+const SimdOps *simd_ops(void) {
+    pthread_once(&g_once, detect);
+    return g_forced ? g_forced : g_auto;
+}
+
+int simd_select(const char *name) {
+    pthread_once(&g_once, detect);
+    if (!name || strcmp(name, "auto") == 0) { g_forced = NULL; return 0; }
+    if (strcmp(name, "scalar") == 0) { g_forced = &ops_scalar; return 0; }
+#ifdef SIMD_X86
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        g_forced = &ops_avx2; return 0;
+    }
+    if (strcmp(name, "avx512") == 0 && __builtin_cpu_supports("avx512f")) {
+        g_forced = &ops_avx512; return 0;
+    }
+#endif
+    return -1;
+}
@@ -0,0 +1,59 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+
+/* Largest micro-kernel tile over all variants (sizes edge scratch buffers). */
+#define SIMD_MAX_MR 8
+#define SIMD_MAX_NR 16
+
+/* Square sizes with a fixed-size mm kernel (mmfix[i] is for 4 << i). */
+#define SIMD_NFIX 4
+
+/* mmfix slot for an n x n product, or -1 if n has no fixed kernel. */
+static inline int simd_fix_index(size_t n) {
+    for (int i = 0; i < SIMD_NFIX; i++)
+        if (n == (size_t)4 << i) return i;
+    return -1;
+}
+
+typedef struct {
+    const char *name;
+    /* sum_k x[k] * y[k] */
+    double (*dot)(const double *x, const double *y, size_t n);
+    /* y[k] += a * x[k] */
+    void (*axpy)(double a, const double *x, double *y, size_t n);
+    /* y[i] = A[i,:] . x for m rows of length n, row stride lda */
+    void (*mv)(const double *A, size_t lda, const double *x, double *y, size_t m, size_t n);
+    /* y[k] += a * x[k], returning sum_k y[k]^2 of the updated y */
+    double (*axdot)(double a, const double *x, double *y, size_t n);
+    /* float32 dot, axpy and mv; dsdot/dsmv read floats but accumulate in double */
+    float  (*sdot)(const float *x, const float *y, size_t n);
+    double (*dsdot)(const float *x, const float *y, size_t n);
+    void   (*saxpy)(float a, const float *x, float *y, size_t n);
+    void   (*smv)(const float *A, size_t lda, const float *x, float *y, size_t m, size_t n);
+    void   (*dsmv)(const float *A, size_t lda, const float *x, float *y, size_t m, size_t n);
+    /* c[mr x nr] (row stride ldc) += packed a-panel * packed b-panel over kc */
+    void (*ukr)(size_t kc, const double *a, const double *b, double *c, size_t ldc);
+    int mr, nr;
+    /*
+     * memcpy for write-only outputs: the aligned middle is stored
+     * non-temporally, so it goes to memory without first being read into
+     * the cache. Ends with a store fence; the scalar variant is memcpy.
+     */
+    void (*stream)(void *dst, const void *src, size_t bytes);
+    /*
+     * C = A * B for n x n blocks (row strides lda/ldb/ldc), n = 4 << slot.
+     * n is a compile-time constant in each, so a row of C stays in registers.
+     */
+    void (*mmfix[SIMD_NFIX])(const double *A, size_t lda, const double *B, size_t ldb,
+                             double *C, size_t ldc);
+} SimdOps;
+
+/* Best variant for this CPU, detected once on first use. */
+const SimdOps *simd_ops(void);
+
+/* Force a variant: "auto", "scalar", "avx2" or "avx512". -1 if the CPU lacks it. */
+int simd_select(const char *name);
+
+#endif
@@ -0,0 +1,192 @@
+#include "sparse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static int read_u64(FILE *f, uint64_t *x) {
+    return fread(x, sizeof(uint64_t), 1, f) == 1 ? 0 : -1;
+}
+static int write_u64(FILE *f, uint64_t x) {
+    return fwrite(&x, sizeof(uint64_t), 1, f) == 1 ? 0 : -1;
+}
+
+void csr_free(Csr *A) {
+    if (!A) return;
+    free(A->rowptr);
+    free(A->colidx);
+    free(A->val);
+    memset(A, 0, sizeof(*A));
+}
+
+static int csr_alloc(size_t rows, size_t cols, size_t nnz, DType dt, Csr *A) {
+    memset(A, 0, sizeof(*A));
+    if (cols > UINT32_MAX) return -1;
+    A->rows = rows; A->cols = cols; A->nnz = nnz; A->dt = dt;
+    A->rowptr = (size_t*)calloc(rows + 1, sizeof(size_t));
+    A->colidx = (uint32_t*)malloc((nnz ? nnz : 1) * sizeof(uint32_t));
+    A->val = (double*)malloc((nnz ? nnz : 1) * dt_size(dt));
+    if (!A->rowptr || !A->colidx || !A->val) { csr_free(A); return -1; }
+    return 0;
+}
+
+static inline double csr_get(const Csr *A, size_t k) {
+    return A->dt == DT_F32 ? (double)A->val32[k] : A->val[k];
+}
+static inline void csr_set(Csr *A, size_t k, double v) {
+    if (A->dt == DT_F32) A->val32[k] = (float)v;
+    else A->val[k] = v;
+}
+
+typedef struct { size_t i, j; double v; } Triplet;
+
+static int cmp_triplet(const void *a, const void *b) {
+    const Triplet *x = (const Triplet*)a, *y = (const Triplet*)b;
+    if (x->i != y->i) return x->i < y->i ? -1 : 1;
+    return (x->j > y->j) - (x->j < y->j);
+}
+
+/* Sorted triplets (duplicates summed) into A. */
+static int from_triplets(Triplet *t, size_t n, size_t rows, size_t cols, DType dt, Csr *A) {
+    qsort(t, n, sizeof(Triplet), cmp_triplet);
+    size_t u = 0;
+    for (size_t k = 0; k < n; k++) {
+        if (u > 0 && t[u - 1].i == t[k].i && t[u - 1].j == t[k].j) t[u - 1].v += t[k].v;
+        else t[u++] = t[k];
+    }
+    if (csr_alloc(rows, cols, u, dt, A) != 0) return -1;
+    for (size_t k = 0; k < u; k++) {
+        A->rowptr[t[k].i + 1]++;
+        A->colidx[k] = (uint32_t)t[k].j;
+        csr_set(A, k, t[k].v);
+    }
+    for (size_t i = 0; i < rows; i++) A->rowptr[i + 1] += A->rowptr[i];
+    return 0;
+}
+
+static int load_text(FILE *f, DType dt, Csr *out) {
+    size_t r, c, n;
+    if (fscanf(f, "%zu %zu %zu", &r, &c, &n) != 3 || r == 0 || c == 0) return -1;
+    if (c > UINT32_MAX || (r && n / r > c) || n > SIZE_MAX / sizeof(Triplet)) return -1;
+    /* Each triplet takes at least 6 bytes ("0 0 0" and a separator). */
+    struct stat st;
+    if (fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode) && n > (uint64_t)st.st_size / 6) return -1;
+    Triplet *t = (Triplet*)malloc((n ? n : 1) * sizeof(Triplet));
+    if (!t) return -1;
+    for (size_t k = 0; k < n; k++) {
+        if (fscanf(f, "%zu %zu %lf", &t[k].i, &t[k].j, &t[k].v) != 3 ||
+            t[k].i >= r || t[k].j >= c) {
+            free(t); return -1;
+        }
+    }
+    int rc = from_triplets(t, n, r, c, dt, out);
+    free(t);
+    return rc;
+}
+
+/* Every row's column indices in range and strictly increasing. */
+static int check_rows(const Csr *A) {
+    if (A->rowptr[0] != 0 || A->rowptr[A->rows] != A->nnz) return -1;
+    for (size_t i = 0; i < A->rows; i++) {
+        if (A->rowptr[i + 1] < A->rowptr[i]) return -1;
+        for (size_t k = A->rowptr[i]; k < A->rowptr[i + 1]; k++) {
+            if (A->colidx[k] >= A->cols) return -1;
+            if (k > A->rowptr[i] && A->colidx[k] <= A->colidx[k - 1]) return -1;
+        }
+    }
+    return 0;
+}
+
+static int load_bin(FILE *f, DType dt, Csr *out) {
+    uint64_t r, c, n;
+    if (read_u64(f, &r) || read_u64(f, &c) || read_u64(f, &n)) return -1;
+    if (r == 0 || c == 0 || c > UINT32_MAX || r > SIZE_MAX / sizeof(uint64_t) - 1) return -1;
+    if (n > SIZE_MAX / sizeof(double)) return -1;
+
+    /* Value type from what is left after the index arrays. */
+    struct stat st;
+    DType fdt = DT_F64;
+    if (fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode)) {
+        /* Bounded by the file first, so the sizes below cannot wrap. */
+        if (r >= (uint64_t)st.st_size / sizeof(uint64_t) || n > (uint64_t)st.st_size / sizeof(uint32_t)) return -1;
+        uint64_t idx = (3 + r + 1) * sizeof(uint64_t) + n * sizeof(uint32_t);
+        if ((uint64_t)st.st_size < idx) return -1;
+        uint64_t payload = (uint64_t)st.st_size - idx;
+        if (payload == n * sizeof(float) && n > 0) fdt = DT_F32;
+        else if (payload < n * sizeof(double)) return -1;
+    }
+
+    if (csr_alloc((size_t)r, (size_t)c, (size_t)n, dt, out) != 0) return -1;
+    for (size_t i = 0; i <= out->rows; i++) {
+        uint64_t p;
+        if (read_u64(f, &p) || p > n) { csr_free(out); return -1; }
+        out->rowptr[i] = (size_t)p;
+    }
+    if (fread(out->colidx, sizeof(uint32_t), out->nnz, f) != out->nnz || check_rows(out) != 0) {
+        csr_free(out); return -1;
+    }
+    if (fdt == dt) {
+        if (fread(out->val, dt_size(dt), out->nnz, f) != out->nnz) { csr_free(out); return -1; }
+        return 0;
+    }
+    for (size_t k = 0; k < out->nnz; k++) {
+        double d; float s;
+        if (fdt == DT_F64 ? fread(&d, sizeof(d), 1, f) != 1 : fread(&s, sizeof(s), 1, f) != 1) {
+            csr_free(out); return -1;
+        }
+        csr_set(out, k, fdt == DT_F64 ? d : (double)s);
+    }
+    return 0;
+}
+
+int csr_load(const char *path, FileFmt fmt, const LoadOpts *o, Csr *out) {
+    if (!path || !out) return -1;
+    FILE *f = fopen(path, fmt == FMT_BIN ? "rb" : "r");
+    if (!f) { perror("fopen"); return -1; }
+    DType dt = o ? o->dt : DT_F64;
+    int rc = fmt == FMT_BIN ? load_bin(f, dt, out) : load_text(f, dt, out);
+    fclose(f);
+    return rc;
+}
+
+int csr_save(const char *path, FileFmt fmt, const Csr *A) {
+    if (!path || !A || !A->rowptr) return -1;
+    FILE *f = fopen(path, fmt == FMT_BIN ? "wb" : "w");
+    if (!f) { perror("fopen"); return -1; }
+    int rc = 0;
+
+    if (fmt == FMT_TEXT) {
+        const int prec = A->dt == DT_F32 ? 9 : 17;
+        fprintf(f, "%zu %zu %zu\n", A->rows, A->cols, A->nnz);
+        for (size_t i = 0; i < A->rows; i++)
+            for (size_t k = A->rowptr[i]; k < A->rowptr[i + 1]; k++)
+                fprintf(f, "%zu %u %.*g\n", i, A->colidx[k], prec, csr_get(A, k));
+    } else {
+        rc = write_u64(f, A->rows) | write_u64(f, A->cols) | write_u64(f, A->nnz);
+        for (size_t i = 0; i <= A->rows && rc == 0; i++) rc = write_u64(f, A->rowptr[i]);
+        if (rc == 0 && fwrite(A->colidx, sizeof(uint32_t), A->nnz, f) != A->nnz) rc = -1;
+        if (rc == 0 && fwrite(A->val, dt_size(A->dt), A->nnz, f) != A->nnz) rc = -1;
+    }
+
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+int csr_from_dense(const Mat *A, Csr *out) {
+    if (!A || !A->data) return -1;
+    size_t n = 0;
+    for (size_t i = 0; i < A->rows; i++)
+        for (size_t j = 0; j < A->cols; j++) n += m_get(A, i, j) != 0.0;
+    if (csr_alloc(A->rows, A->cols, n, A->dt, out) != 0) return -1;
+    size_t k = 0;
+    for (size_t i = 0; i < A->rows; i++) {
+        for (size_t j = 0; j < A->cols; j++) {
+            double v = m_get(A, i, j);
+            if (v == 0.0) continue;
+            out->colidx[k] = (uint32_t)j;
+            csr_set(out, k++, v);
+        }
+        out->rowptr[i + 1] = k;
+    }
+    return 0;
+}
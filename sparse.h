@@ -0,0 +1,33 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include "matrix.h"
+
+/*
+ * Compressed sparse row: the nonzeros of row i are val[rowptr[i] ..
+ * rowptr[i+1]) at columns colidx[...], sorted and unique within a row.
+ * Column indices are 32-bit to halve index traffic; cols must fit.
+ */
+typedef struct {
+    size_t rows, cols, nnz;
+    size_t *rowptr;           /* rows + 1 entries */
+    uint32_t *colidx;
+    union { double *val; float *val32; };
+    DType dt;
+} Csr;
+
+/*
+ * Text: "rows cols nnz" then nnz "i j value" triplets, 0-based, in any
+ * order; duplicates are summed.
+ * Binary: u64 rows, cols, nnz; u64 rowptr[rows+1]; u32 colidx[nnz];
+ * values as f64, or f32 when exactly 4 bytes per nonzero remain.
+ * Values are converted to o->dt (DT_F64 if o is NULL).
+ */
+int  csr_load(const char *path, FileFmt fmt, const LoadOpts *o, Csr *out);
+int  csr_save(const char *path, FileFmt fmt, const Csr *A);
+void csr_free(Csr *A);
+
+/* Nonzeros of a dense matrix, in A's element type. */
+int  csr_from_dense(const Mat *A, Csr *out);
+
+#endif
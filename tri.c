@@ -0,0 +1,118 @@
+#include "tri.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static int read_u64(FILE *f, uint64_t *x) {
+    return fread(x, sizeof(uint64_t), 1, f) == 1 ? 0 : -1;
+}
+static int write_u64(FILE *f, uint64_t x) {
+    return fwrite(&x, sizeof(uint64_t), 1, f) == 1 ? 0 : -1;
+}
+
+int tri_alloc(size_t n, Uplo uplo, DType dt, Tri *out) {
+    memset(out, 0, sizeof(*out));
+    if (n == 0 || n > SIZE_MAX / dt_size(dt) / (n + 1)) return -1;
+    out->v = v_alloc_dt(tri_len(n), dt);
+    if (!out->v.data) return -1;
+    out->n = n;
+    out->uplo = uplo;
+    return 0;
+}
+
+void tri_free(Tri *T) {
+    if (!T) return;
+    v_free(&T->v);
+    memset(T, 0, sizeof(*T));
+}
+
+int tri_from_dense(const Mat *A, Uplo uplo, Tri *out) {
+    if (!A || !A->data || A->rows != A->cols) return -1;
+    if (tri_alloc(A->rows, uplo, A->dt, out) != 0) return -1;
+    const size_t esz = dt_size(A->dt);
+    for (size_t i = 0; i < out->n; i++) {
+        size_t c0 = tri_col0(out, i), w = tri_row(out, i + 1) - tri_row(out, i);
+        memcpy((char*)out->v.data + tri_row(out, i) * esz,
+               (const char*)A->data + (i * A->ld + c0) * esz, w * esz);
+    }
+    return 0;
+}
+
+static int load_text(FILE *f, DType dt, Tri *out) {
+    size_t n;
+    char u;
+    if (fscanf(f, "%zu %c", &n, &u) != 2 || (u != 'L' && u != 'U')) return -1;
+    if (tri_alloc(n, u == 'L' ? UPLO_L : UPLO_U, dt, out) != 0) return -1;
+    for (size_t k = 0; k < out->v.len; k++) {
+        double v;
+        if (fscanf(f, "%lf", &v) != 1) { tri_free(out); return -1; }
+        v_set(&out->v, k, v);
+    }
+    return 0;
+}
+
+static int load_bin(FILE *f, DType dt, Tri *out) {
+    uint64_t n, u;
+    if (read_u64(f, &n) || read_u64(f, &u) || u > 1) return -1;
+    if (n == 0 || n > SIZE_MAX / sizeof(double) / (n + 1)) return -1;
+    const size_t len = tri_len((size_t)n);
+
+    /* Value type from what is left after the header. */
+    struct stat st;
+    DType fdt = DT_F64;
+    if (fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode)) {
+        const uint64_t hdr = 2 * sizeof(uint64_t);
+        if ((uint64_t)st.st_size < hdr) return -1;
+        uint64_t payload = (uint64_t)st.st_size - hdr;
+        if (payload == len * sizeof(float)) fdt = DT_F32;
+        else if (payload < len * sizeof(double)) return -1;
+    }
+
+    if (tri_alloc((size_t)n, u ? UPLO_U : UPLO_L, dt, out) != 0) return -1;
+    if (fdt == dt) {
+        if (fread(out->v.data, dt_size(dt), len, f) != len) { tri_free(out); return -1; }
+        return 0;
+    }
+    for (size_t k = 0; k < len; k++) {
+        double d; float s;
+        if (fdt == DT_F64 ? fread(&d, sizeof(d), 1, f) != 1 : fread(&s, sizeof(s), 1, f) != 1) {
+            tri_free(out); return -1;
+        }
+        v_set(&out->v, k, fdt == DT_F64 ? d : (double)s);
+    }
+    return 0;
+}
+
+int tri_load(const char *path, FileFmt fmt, const LoadOpts *o, Tri *out) {
+    if (!path || !out) return -1;
+    FILE *f = fopen(path, fmt == FMT_BIN ? "rb" : "r");
+    if (!f) { perror("fopen"); return -1; }
+    DType dt = o ? o->dt : DT_F64;
+    int rc = fmt == FMT_BIN ? load_bin(f, dt, out) : load_text(f, dt, out);
+    fclose(f);
+    return rc;
+}
+
+int tri_save(const char *path, FileFmt fmt, const Tri *T) {
+    if (!path || !T || !T->v.data) return -1;
+    FILE *f = fopen(path, fmt == FMT_BIN ? "wb" : "w");
+    if (!f) { perror("fopen"); return -1; }
+    int rc = 0;
+
+    if (fmt == FMT_TEXT) {
+        const int prec = T->v.dt == DT_F32 ? 9 : 17;
+        fprintf(f, "%zu %c\n", T->n, T->uplo == UPLO_L ? 'L' : 'U');
+        for (size_t i = 0; i < T->n; i++) {
+            for (size_t k = tri_row(T, i); k < tri_row(T, i + 1); k++)
+                fprintf(f, k > tri_row(T, i) ? " %.*g" : "%.*g", prec, v_get(&T->v, k));
+            fputc('\n', f);
+        }
+    } else {
+        rc = write_u64(f, T->n) | write_u64(f, T->uplo == UPLO_U);
+        if (rc == 0 && fwrite(T->v.data, dt_size(T->v.dt), T->v.len, f) != T->v.len) rc = -1;
+    }
+
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
@@ -0,0 +1,59 @@
+#ifndef TRI_H
+#define TRI_H
+
+#include "matrix.h"
+
+/* Which triangle of a symmetric or triangular n x n matrix is stored. */
+typedef enum { UPLO_L, UPLO_U } Uplo;
+
+/*
+ * Packed triangular storage: the uplo triangle of an n x n matrix, row
+ * by row with no gaps, in v (n(n+1)/2 elements of v.dt). UPLO_L row i
+ * holds columns [0, i], UPLO_U row i holds columns [i, n). A symmetric
+ * matrix is stored as either triangle.
+ */
+typedef struct {
+    size_t n;
+    Uplo uplo;
+    Vec v;
+} Tri;
+
+static inline size_t tri_len(size_t n) { return n * (n + 1) / 2; }
+
+/* Offset in v of row i's first stored element (row n: the end). */
+static inline size_t tri_row(const Tri *T, size_t i) {
+    return T->uplo == UPLO_L ? i * (i + 1) / 2 : i * T->n - i * (i - 1) / 2;
+}
+
+/* First stored column of row i; the row holds tri_row(i + 1) - tri_row(i) elements. */
+static inline size_t tri_col0(const Tri *T, size_t i) { return T->uplo == UPLO_L ? 0 : i; }
+
+/* Element (i, j) of the symmetric matrix T stands for: read from whichever triangle is stored. */
+static inline double tri_sym_get(const Tri *T, size_t i, size_t j) {
+    if ((T->uplo == UPLO_L) != (i >= j)) { size_t t = i; i = j; j = t; }
+    return v_get(&T->v, tri_row(T, i) + j - tri_col0(T, i));
+}
+
+/* Element (i, j) of the triangular matrix T: 0 outside the stored triangle. */
+static inline double tri_get(const Tri *T, size_t i, size_t j) {
+    if ((T->uplo == UPLO_L) != (i >= j) && i != j) return 0.0;
+    return v_get(&T->v, tri_row(T, i) + j - tri_col0(T, i));
+}
+
+/* Zeroed n x n packed triangle; v is released with tri_free. */
+int  tri_alloc(size_t n, Uplo uplo, DType dt, Tri *out);
+void tri_free(Tri *T);
+
+/* The uplo triangle of square A, in A's element type; the other half is not read. */
+int  tri_from_dense(const Mat *A, Uplo uplo, Tri *out);
+
+/*
+ * Text: "n L" or "n U", then the packed elements row by row.
+ * Binary: u64 n, u64 uplo (0 = L, 1 = U), then n(n+1)/2 values as f64,
+ * or f32 when exactly 4 bytes per element remain.
+ * Values are converted to o->dt (DT_F64 if o is NULL).
+ */
+int  tri_load(const char *path, FileFmt fmt, const LoadOpts *o, Tri *out);
+int  tri_save(const char *path, FileFmt fmt, const Tri *T);
+
+#endif
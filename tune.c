@@ -0,0 +1,225 @@
+#define _POSIX_C_SOURCE 200809L
+#include "tune.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+/* A slower candidate within this fraction of the best still wins if it uses fewer threads. */
+#define TUNE_THREAD_TOL 0.03
+
+#define PROFILE_HEADER "# op dtype isa class algo tile mc kc nc threads gflops"
+
+static const char *algo_name(MMAlgo a) {
+    return a == MM_PACKED ? "packed" : a == MM_RECURSIVE ? "recursive" : "tiled";
+}
+
+static int algo_parse(const char *s, MMAlgo *a) {
+    if (strcmp(s, "tiled") == 0) *a = MM_TILED;
+    else if (strcmp(s, "packed") == 0) *a = MM_PACKED;
+    else if (strcmp(s, "recursive") == 0) *a = MM_RECURSIVE;
+    else return -1;
+    return 0;
+}
+
+int tune_class(double bytes) {
+    return bytes >= 1.0 ? (int)floor(log2(bytes)) : 0;
+}
+
+int profile_default_path(char *buf, size_t len) {
+    char host[256];
+    if (gethostname(host, sizeof(host)) != 0) return -1;
+    host[sizeof(host) - 1] = '\0';
+    const char *xdg = getenv("XDG_CACHE_HOME"), *home = getenv("HOME");
+    int n;
+    if (xdg && *xdg) n = snprintf(buf, len, "%s/mce/%s.tune", xdg, host);
+    else if (home && *home) n = snprintf(buf, len, "%s/.cache/mce/%s.tune", home, host);
+    else return -1;
+    return n > 0 && (size_t)n < len ? 0 : -1;
+}
+
+int profile_put(Profile *p, const TuneEntry *e) {
+    for (size_t i = 0; i < p->n; i++) {
+        TuneEntry *o = &p->e[i];
+        if (o->cls == e->cls && strcmp(o->op, e->op) == 0 && strcmp(o->dtype, e->dtype) == 0 &&
+            strcmp(o->isa, e->isa) == 0) {
+            *o = *e;
+            p->dirty = 1;
+            return 0;
+        }
+    }
+    if (p->n == p->cap) {
+        size_t cap = p->cap ? 2 * p->cap : 16;
+        TuneEntry *ne = realloc(p->e, cap * sizeof(TuneEntry));
+        if (!ne) return -1;
+        p->e = ne; p->cap = cap;
+    }
+    p->e[p->n++] = *e;
+    p->dirty = 1;
+    return 0;
+}
+
+int profile_load(Profile *p, const char *path) {
+    memset(p, 0, sizeof(*p));
+    FILE *f = fopen(path, "r");
+    if (!f) return errno == ENOENT ? 0 : -1;
+    char line[512], algo[16];
+    int rc = 0, lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        if (line[0] == '#' || line[0] == '\n') continue;
+        TuneEntry e = {0};
+        if (sscanf(line, "%15s %7s %7s %d %15s %d %d %d %d %d %lf", e.op, e.dtype, e.isa, &e.cls,
+                   algo, &e.tile, &e.mc, &e.kc, &e.nc, &e.threads, &e.gflops) != 11 ||
+            algo_parse(algo, &e.algo) != 0 || e.threads < 1 || e.threads > POOL_MAX_THREADS) {
+            fprintf(stderr, "[tune] %s:%d: malformed entry\n", path, lineno);
+            rc = -1;
+            break;
+        }
+        if (profile_put(p, &e) != 0) { rc = -1; break; }
+    }
+    fclose(f);
+    p->dirty = 0;
+    if (rc != 0) profile_free(p);
+    return rc;
+}
+
+/* mkdir -p of path's directory. */
+static int make_parent(const char *path) {
+    char dir[PATH_MAX];
+    size_t n = strlen(path);
+    if (n >= sizeof(dir)) return -1;
+    memcpy(dir, path, n + 1);
+    for (char *q = dir + 1; *q; q++) {
+        if (*q != '/') continue;
+        *q = '\0';
+        if (mkdir(dir, 0755) != 0 && errno != EEXIST) return -1;
+        *q = '/';
+    }
+    return 0;
+}
+
+int profile_save(const Profile *p, const char *path) {
+    char tmp[PATH_MAX];
+    if (make_parent(path) != 0) return -1;
+    if (snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long)getpid()) >= (int)sizeof(tmp)) return -1;
+    FILE *f = fopen(tmp, "w");
+    if (!f) return -1;
+    fprintf(f, "%s\n", PROFILE_HEADER);
+    for (size_t i = 0; i < p->n; i++) {
+        const TuneEntry *e = &p->e[i];
+        fprintf(f, "%s %s %s %d %s %d %d %d %d %d %.3f\n", e->op, e->dtype, e->isa, e->cls,
+                algo_name(e->algo), e->tile, e->mc, e->kc, e->nc, e->threads, e->gflops);
+    }
+    int rc = ferror(f) ? -1 : 0;
+    if (fclose(f) != 0) rc = -1;
+    if (rc == 0 && rename(tmp, path) != 0) rc = -1;
+    if (rc != 0) remove(tmp);
+    return rc;
+}
+
+void profile_free(Profile *p) {
+    free(p->e);
+    memset(p, 0, sizeof(*p));
+}
+
+const TuneEntry *profile_find(const Profile *p, const char *op, const char *dtype,
+                              const char *isa, int cls) {
+    const TuneEntry *best = NULL;
+    int bd = TUNE_CLASS_SLACK + 1;
+    for (size_t i = 0; i < p->n; i++) {
+        const TuneEntry *e = &p->e[i];
+        if (strcmp(e->op, op) != 0 || strcmp(e->dtype, dtype) != 0 || strcmp(e->isa, isa) != 0) continue;
+        int d = abs(e->cls - cls);
+        if (d < bd) { bd = d; best = e; }
+    }
+    return best;
+}
+
+int profile_max_threads(const Profile *p, const char *isa) {
+    int m = 0;
+    for (size_t i = 0; i < p->n; i++)
+        if (strcmp(p->e[i].isa, isa) == 0 && p->e[i].threads > m) m = p->e[i].threads;
+    return m;
+}
+
+/* Search state: *cfg is the candidate being timed, win the best so far. */
+typedef struct {
+    BenchFn fn;
+    BenchPrep prep;
+    void *arg;
+    KCfg *cfg;
+    KCfg win;
+    double wt;      /* median seconds of win; 0 before the first trial */
+    int trials;
+} Search;
+
+/*
+ * Times the current *cfg and keeps it if it beats the winner by more
+ * than tol. Returns 0, -1 if the kernel failed, or -2 if interrupted.
+ */
+static int try_cfg(Search *s, double tol) {
+    BenchOpts o = { .warmup = 1, .reps = 0, .min_time = TUNE_MIN_TIME };
+    BenchStats st;
+    int rc = bench_run(s->fn, s->prep, s->arg, &o, &st);
+    if (rc != 0) return rc == 2 ? -2 : -1;
+    s->trials++;
+    if (s->wt == 0.0 || st.median < s->wt * (1.0 - tol)) { s->wt = st.median; s->win = *s->cfg; }
+    return 0;
+}
+
+int tune_search(BenchFn fn, BenchPrep prep, void *arg, KCfg *cfg, int is_mm, int f64,
+                int max_nt, double flops, TuneEntry *best) {
+    static const int tiles[] = { 16, 32, 64, 128, 256 };
+    static const int mcs[] = { 64, 128, 256 }, kcs[] = { 128, 256, 512 };
+    Search s = { .fn = fn, .prep = prep, .arg = arg, .cfg = cfg, .win = *cfg };
+    int rc = 0;
+
+    cfg->nt = max_nt;
+    if (is_mm) {
+        cfg->mm_algo = MM_TILED;
+        cfg->mc = cfg->kc = cfg->nc = 0;
+        for (size_t i = 0; i < sizeof(tiles) / sizeof(tiles[0]) && rc == 0; i++) {
+            cfg->tile = tiles[i];
+            rc = try_cfg(&s, 0.0);
+        }
+        if (f64) {
+            cfg->tile = s.win.tile;
+            cfg->mm_algo = MM_PACKED;
+            for (size_t a = 0; a < sizeof(mcs) / sizeof(mcs[0]) && rc == 0; a++)
+                for (size_t b = 0; b < sizeof(kcs) / sizeof(kcs[0]) && rc == 0; b++) {
+                    cfg->mc = mcs[a]; cfg->kc = kcs[b];
+                    rc = try_cfg(&s, 0.0);
+                }
+            cfg->mm_algo = MM_RECURSIVE;
+            cfg->mc = cfg->kc = 0;
+            if (rc == 0) rc = try_cfg(&s, 0.0);
+        }
+    } else {
+        rc = try_cfg(&s, 0.0);
+    }
+    if (rc != 0) return rc;
+
+    /* Thread counts, fewest first: each step up must win by TUNE_THREAD_TOL. */
+    const KCfg base = s.win;
+    s.wt = 0.0;
+    for (int t = 1; rc == 0; t = 2 * t < max_nt ? 2 * t : max_nt) {
+        *cfg = base;
+        cfg->nt = t;
+        rc = try_cfg(&s, TUNE_THREAD_TOL);
+        if (t == max_nt) break;
+    }
+    if (rc != 0) return rc;
+
+    *cfg = s.win;
+    best->algo = s.win.mm_algo;
+    best->tile = is_mm ? s.win.tile : 0;
+    best->mc = s.win.mc; best->kc = s.win.kc; best->nc = s.win.nc;
+    best->threads = s.win.nt;
+    best->gflops = s.wt > 0.0 ? flops / s.wt / 1e9 : 0.0;
+    return s.trials;
+}
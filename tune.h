@@ -0,0 +1,70 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include "kernels.h"
+#include "bench.h"
+
+/*
+ * Per-host tuning profiles. --autotune times candidate settings for
+ * each op on the run's operands and stores the winner under (op,
+ * dtype, isa, size class). Later runs look the entry up and start the
+ * kernel with it. Settings given on the command line always win.
+ */
+typedef struct {
+    char op[16], dtype[8], isa[8];
+    int cls;                /* tune_class() of the op's memory traffic */
+    MMAlgo algo;            /* mm only */
+    int tile, mc, kc, nc;   /* mm only; 0 = default */
+    int threads;
+    double gflops;          /* measured rate of the winner */
+} TuneEntry;
+
+typedef struct {
+    TuneEntry *e;
+    size_t n, cap;
+    int dirty;              /* entries changed since load */
+} Profile;
+
+/* Settings given explicitly, which a profile entry must not override. */
+enum { TUNE_FIX_TILE = 1, TUNE_FIX_ALGO = 2, TUNE_FIX_THREADS = 4 };
+
+/* Nearer classes than this are close enough to reuse an entry. */
+#define TUNE_CLASS_SLACK 2
+
+/* Samples per candidate: short, since the search times dozens of them. */
+#define TUNE_MIN_TIME 0.05
+
+/* Size class: floor(log2(bytes)), so one entry covers a 2x range of operand sizes. */
+int tune_class(double bytes);
+
+/* $XDG_CACHE_HOME/mce/<hostname>.tune, or ~/.cache/mce/...; -1 if neither is set. */
+int profile_default_path(char *buf, size_t len);
+
+/* A missing file is an empty profile. -1 on a malformed line or I/O error. */
+int profile_load(Profile *p, const char *path);
+/* Writes all entries (via a temporary and rename), creating the directory. */
+int profile_save(const Profile *p, const char *path);
+void profile_free(Profile *p);
+
+/* Entry for the nearest class within TUNE_CLASS_SLACK, or NULL. */
+const TuneEntry *profile_find(const Profile *p, const char *op, const char *dtype,
+                              const char *isa, int cls);
+/* Adds e, replacing the entry with the same key. */
+int profile_put(Profile *p, const TuneEntry *e);
+
+/* Largest thread count of any entry for isa; 0 if none. */
+int profile_max_threads(const Profile *p, const char *isa);
+
+/*
+ * Searches settings for fn, whose arg passes *cfg to the kernel. For mm
+ * (is_mm), tiled tile sizes and, in f64, packed blocking and the
+ * recursive path at max_nt threads. Then, for every op, thread counts
+ * up to max_nt with the best of those. flops is one call's work.
+ * On success *cfg holds the winner and *best is filled in, apart from
+ * its key. Returns the number of candidates timed, -1 on kernel
+ * failure, or -2 if interrupted.
+ */
+int tune_search(BenchFn fn, BenchPrep prep, void *arg, KCfg *cfg, int is_mm, int f64,
+                int max_nt, double flops, TuneEntry *best);
+
+#endif
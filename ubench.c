@@ -0,0 +1,814 @@
+#define _POSIX_C_SOURCE 200809L
+/*
+ * Microbenchmarks (make bench): every kernel on synthetic operands at
+ * working sets from L1- to DRAM-resident. Each case's first call is
+ * checked against a serial reference in double; the timed calls then
+ * run through bench_run. Results go to a line-based file that --compare
+ * diffs between two builds, flagging throughput regressions.
+ *
+ * Results file, one row per kernel, dtype and level:
+ *   # ubench 1 host=H isa=I threads=T min_time=S
+ *   kernel dtype level shape ws_bytes median_s min_s gflops gbs rel_err check
+ * gflops and gbs come from the fastest sample (min_s), which other load on
+ * the host disturbs least, so two runs agree far better than medians do.
+ */
+#include "ctx.h"
+#include "bench.h"
+#include "simd.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+
+#define UB_VERSION 1
+/* O(n^3) kernels stop growing here, so a DRAM-sized mm stays a fraction of a second. */
+#define UB_MAXN 1024
+/* A large shared LLC is capped: one core only reaches part of it. */
+#define UB_LLC_MAX ((size_t)32 << 20)
+#define UB_DRAM_MIN ((size_t)256 << 20)
+#define UB_NNZ_ROW 16
+#define UB_BATCH_N 16
+/* Rows (or items) of O(n^3) results compared with the reference. */
+#define UB_SAMPLES 8
+#define UB_THRESHOLD 10.0
+
+enum { LV_L1, LV_L2, LV_LLC, LV_DRAM, LV_N };
+static const char *lv_name[LV_N] = { "l1", "l2", "llc", "dram" };
+
+typedef struct {
+    KCfg cfg;
+    DType dt;
+    char shape[64];
+    double flops, bytes;    /* per call: arithmetic and minimum memory traffic */
+    double ws;              /* working set, what the level sizes */
+    Mat A, B, C;
+    Mat *As, *Bs, *Cs;      /* mm_batch items: views into A, B, C */
+    size_t count;
+    Vec x, y, y0, z;
+    Csr S;
+    Tri T;
+    double out, alpha, beta;
+} Case;
+
+typedef struct {
+    const char *name;
+    int (*setup)(Case *c, double bytes);
+    BenchFn call;
+    double (*check)(const Case *c);    /* error of the first call's result, relative to the sum of |terms| */
+} Kernel;
+
+static void on_sigint(int signo) {
+    (void)signo;
+    g_stop = 1;
+}
+
+/* splitmix64: reproducible operands for every build. */
+static uint64_t rnd_next(uint64_t *s) {
+    uint64_t z = (*s += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static double rnd_unit(uint64_t *s) { return (double)(rnd_next(s) >> 11) * 0x1.0p-53 * 2.0 - 1.0; }
+
+static void fill_mat(Mat *A, uint64_t seed) {
+    for (size_t i = 0; i < A->rows; i++)
+        for (size_t j = 0; j < A->cols; j++) m_set(A, i, j, rnd_unit(&seed));
+}
+
+static void fill_vec(Vec *v, uint64_t seed) {
+    for (size_t i = 0; i < v->len; i++) v_set(v, i, rnd_unit(&seed));
+}
+
+static int new_vec(Vec *v, size_t n, DType dt, uint64_t seed) {
+    *v = v_alloc_dt(n, dt);
+    if (!v->data) return -1;
+    fill_vec(v, seed);
+    return 0;
+}
+
+static int new_mat(Mat *A, size_t r, size_t c, DType dt, uint64_t seed) {
+    *A = m_alloc_dt(r, c, dt);
+    if (!A->data) return -1;
+    fill_mat(A, seed);
+    return 0;
+}
+
+static int copy_vec(Vec *dst, const Vec *src) {
+    *dst = v_alloc_dt(src->len, src->dt);
+    if (!dst->data) return -1;
+    memcpy(dst->data, src->data, src->len * dt_size(src->dt));
+    return 0;
+}
+
+static void case_free(Case *c) {
+    m_free(&c->A); m_free(&c->B); m_free(&c->C);
+    free(c->As); free(c->Bs); free(c->Cs);
+    v_free(&c->x); v_free(&c->y); v_free(&c->y0); v_free(&c->z);
+    csr_free(&c->S);
+    tri_free(&c->T);
+}
+
+static double rel(double got, double ref, double abs) {
+    return fabs(got - ref) / (abs > DBL_MIN ? abs : DBL_MIN);
+}
+
+static double worst(double a, double b) { return a > b || isnan(a) ? a : b; }
+
+/* Square side whose elements fill bytes (times frac of n^2), clamped to [2, cap]. */
+static size_t side(double bytes, double per, size_t cap) {
+    size_t n = (size_t)sqrt(bytes / per);
+    if (n < 2) n = 2;
+    return cap && n > cap ? cap : n;
+}
+
+/* ---- vector kernels ---- */
+
+static int setup_vec2(Case *c, double bytes, int inplace) {
+    double e = (double)dt_size(c->dt);
+    size_t n = (size_t)(bytes / (2.0 * e));
+    if (n < 16) n = 16;
+    snprintf(c->shape, sizeof(c->shape), "%zu", n);
+    c->ws = 2.0 * e * n;
+    c->alpha = 1e-3;
+    if (new_vec(&c->x, n, c->dt, 1) != 0 || new_vec(&c->y, n, c->dt, 2) != 0) return -1;
+    return inplace ? copy_vec(&c->y0, &c->y) : 0;
+}
+
+static int setup_dot(Case *c, double bytes) {
+    if (setup_vec2(c, bytes, 0) != 0) return -1;
+    c->flops = 2.0 * c->x.len;
+    c->bytes = c->ws;
+    return 0;
+}
+
+static int setup_axpy(Case *c, double bytes) {
+    if (setup_vec2(c, bytes, 1) != 0) return -1;
+    c->flops = 2.0 * c->x.len;
+    c->bytes = 1.5 * c->ws;
+    return 0;
+}
+
+static int setup_axdot(Case *c, double bytes) {
+    if (setup_axpy(c, bytes) != 0) return -1;
+    c->flops = 4.0 * c->x.len;
+    return 0;
+}
+
+static int call_dot(void *p)   { Case *c = p; return dt_mt(&c->x, &c->y, &c->out, c->cfg); }
+static int call_axpy(void *p)  { Case *c = p; return ax_mt(c->alpha, &c->x, &c->y, c->cfg); }
+static int call_axdot(void *p) { Case *c = p; return axdot_mt(c->alpha, &c->x, &c->y, &c->out, c->cfg); }
+
+static double check_dot(const Case *c) {
+    double s = 0.0, a = 0.0;
+    for (size_t i = 0; i < c->x.len; i++) {
+        double t = v_get(&c->x, i) * v_get(&c->y, i);
+        s += t;
+        a += fabs(t);
+    }
+    return rel(c->out, s, a);
+}
+
+/* y = alpha * x + y0 elementwise; with dot, also out = y . y. */
+static double check_ax(const Case *c, int dot) {
+    double err = 0.0, s = 0.0, a = 0.0;
+    for (size_t i = 0; i < c->x.len; i++) {
+        double t = c->alpha * v_get(&c->x, i), y0 = v_get(&c->y0, i), r = t + y0;
+        err = worst(rel(v_get(&c->y, i), r, fabs(t) + fabs(y0)), err);
+        s += r * r;
+        a += r * r;
+    }
+    return dot ? worst(rel(c->out, s, a), err) : err;
+}
+
+static double check_axpy(const Case *c)  { return check_ax(c, 0); }
+static double check_axdot(const Case *c) { return check_ax(c, 1); }
+
+/* ---- matrix-vector kernels ---- */
+
+static int setup_mv(Case *c, double bytes) {
+    double e = (double)dt_size(c->dt);
+    size_t n = side(bytes, e, 0);
+    snprintf(c->shape, sizeof(c->shape), "%zux%zu", n, n);
+    c->ws = e * ((double)n * n + 2.0 * n);
+    c->flops = 2.0 * n * n;
+    c->bytes = c->ws;
+    c->alpha = 0.5;
+    c->beta = 0.25;
+    if (new_mat(&c->A, n, n, c->dt, 3) != 0 || new_vec(&c->x, n, c->dt, 4) != 0 ||
+        new_vec(&c->y, n, c->dt, 5) != 0 || new_vec(&c->z, n, c->dt, 6) != 0) return -1;
+    return copy_vec(&c->y0, &c->y);
+}
+
+static int call_mv(void *p)    { Case *c = p; return mv_mt(&c->A, TR_N, &c->x, &c->y, c->cfg); }
+static int call_mvt(void *p)   { Case *c = p; return mv_mt(&c->A, TR_T, &c->x, &c->y, c->cfg); }
+static int call_gemv(void *p)  { Case *c = p; return gemv_mt(c->alpha, &c->A, &c->x, c->beta, &c->y, c->cfg); }
+static int call_mvdot(void *p) { Case *c = p; return mvdot_mt(&c->A, &c->x, &c->y, &c->z, &c->out, c->cfg); }
+
+/* y against alpha * op(A) x + beta * y0 (alpha 1, beta 0 for plain mv); dot adds out = y . z. */
+static double check_mv_ex(const Case *c, Trans ta, double alpha, double beta, int dot) {
+    size_t n = c->A.rows;
+    double *r = calloc(n, sizeof(double)), *a = calloc(n, sizeof(double));
+    if (!r || !a) { free(r); free(a); return INFINITY; }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            double t = m_get(&c->A, i, j);
+            size_t o = ta == TR_T ? j : i;
+            double v = t * v_get(&c->x, ta == TR_T ? i : j);
+            r[o] += v;
+            a[o] += fabs(v);
+        }
+    }
+    double err = 0.0, s = 0.0, sa = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double y0 = beta != 0.0 ? beta * v_get(&c->y0, i) : 0.0;
+        double ref = alpha * r[i] + y0, abs = fabs(alpha) * a[i] + fabs(y0);
+        err = worst(rel(v_get(&c->y, i), ref, abs), err);
+        s += ref * v_get(&c->z, i);
+        sa += abs * fabs(v_get(&c->z, i));
+    }
+    free(r);
+    free(a);
+    return dot ? worst(rel(c->out, s, sa), err) : err;
+}
+
+static double check_mv(const Case *c)    { return check_mv_ex(c, TR_N, 1.0, 0.0, 0); }
+static double check_mvt(const Case *c)   { return check_mv_ex(c, TR_T, 1.0, 0.0, 0); }
+static double check_gemv(const Case *c)  { return check_mv_ex(c, TR_N, c->alpha, c->beta, 0); }
+static double check_mvdot(const Case *c) { return check_mv_ex(c, TR_N, 1.0, 0.0, 1); }
+
+static int setup_spmv(Case *c, double bytes) {
+    double e = (double)dt_size(c->dt);
+    size_t r = (size_t)(bytes / (UB_NNZ_ROW * (e + 4.0) + sizeof(size_t) + 2.0 * e));
+    if (r < 2 * UB_NNZ_ROW) r = 2 * UB_NNZ_ROW;
+    size_t nnz = r * UB_NNZ_ROW, stride = r / UB_NNZ_ROW;
+    snprintf(c->shape, sizeof(c->shape), "%zux%zu:%zu", r, r, nnz);
+    c->ws = nnz * (e + 4.0) + (r + 1.0) * sizeof(size_t) + 2.0 * e * r;
+    c->flops = 2.0 * nnz;
+    c->bytes = c->ws;
+    Csr *S = &c->S;
+    *S = (Csr){ .rows = r, .cols = r, .nnz = nnz, .dt = c->dt };
+    S->rowptr = malloc((r + 1) * sizeof(size_t));
+    S->colidx = malloc(nnz * sizeof(uint32_t));
+    S->val = malloc(nnz * dt_size(c->dt));
+    if (!S->rowptr || !S->colidx || !S->val) return -1;
+    /* One nonzero in each of UB_NNZ_ROW column bands: sorted and unique, spread over x. */
+    uint64_t seed = 7;
+    for (size_t i = 0; i <= r; i++) S->rowptr[i] = i * UB_NNZ_ROW;
+    for (size_t k = 0; k < nnz; k++) {
+        S->colidx[k] = (uint32_t)((k % UB_NNZ_ROW) * stride + rnd_next(&seed) % stride);
+        if (c->dt == DT_F32) S->val32[k] = (float)rnd_unit(&seed);
+        else S->val[k] = rnd_unit(&seed);
+    }
+    return new_vec(&c->x, r, c->dt, 8) != 0 || new_vec(&c->y, r, c->dt, 9) != 0 ? -1 : 0;
+}
+
+static int call_spmv(void *p) { Case *c = p; return spmv_mt(&c->S, &c->x, &c->y, c->cfg); }
+
+static double check_spmv(const Case *c) {
+    const Csr *S = &c->S;
+    double err = 0.0;
+    for (size_t i = 0; i < S->rows; i++) {
+        double s = 0.0, a = 0.0;
+        for (size_t k = S->rowptr[i]; k < S->rowptr[i + 1]; k++) {
+            double v = (c->dt == DT_F32 ? (double)S->val32[k] : S->val[k]) * v_get(&c->x, S->colidx[k]);
+            s += v;
+            a += fabs(v);
+        }
+        err = worst(rel(v_get(&c->y, i), s, a), err);
+    }
+    return err;
+}
+
+static int setup_tri(Case *c, double bytes) {
+    double e = (double)dt_size(c->dt);
+    size_t n = side(2.0 * bytes, e, 0);
+    snprintf(c->shape, sizeof(c->shape), "%zu", n);
+    c->ws = e * ((double)tri_len(n) + 2.0 * n);
+    c->flops = 2.0 * n * n;
+    c->bytes = c->ws;
+    if (tri_alloc(n, UPLO_L, c->dt, &c->T) != 0) return -1;
+    fill_vec(&c->T.v, 10);
+    return new_vec(&c->x, n, c->dt, 11) != 0 || new_vec(&c->y, n, c->dt, 12) != 0 ? -1 : 0;
+}
+
+static int setup_trmv(Case *c, double bytes) {
+    if (setup_tri(c, bytes) != 0) return -1;
+    c->flops /= 2.0;
+    return 0;
+}
+
+static int call_symv(void *p) { Case *c = p; return symv_mt(&c->T, &c->x, &c->y, c->cfg); }
+static int call_trmv(void *p) { Case *c = p; return trmv_mt(&c->T, &c->x, &c->y, c->cfg); }
+
+static double check_tri(const Case *c, int sym) {
+    double err = 0.0;
+    for (size_t i = 0; i < c->T.n; i++) {
+        double s = 0.0, a = 0.0;
+        for (size_t j = 0; j < c->T.n; j++) {
+            double v = (sym ? tri_sym_get(&c->T, i, j) : tri_get(&c->T, i, j)) * v_get(&c->x, j);
+            s += v;
+            a += fabs(v);
+        }
+        err = worst(rel(v_get(&c->y, i), s, a), err);
+    }
+    return err;
+}
+
+static double check_symv(const Case *c) { return check_tri(c, 1); }
+static double check_trmv(const Case *c) { return check_tri(c, 0); }
+
+/* ---- matrix-matrix kernels ---- */
+
+static int setup_mm(Case *c, double bytes) {
+    double e = (double)dt_size(c->dt);
+    size_t n = side(bytes, 3.0 * e, UB_MAXN);
+    snprintf(c->shape, sizeof(c->shape), "%zux%zux%zu", n, n, n);
+    c->ws = 3.0 * e * n * n;
+    c->flops = 2.0 * (double)n * n * n;
+    c->bytes = c->ws;
+    if (new_mat(&c->A, n, n, c->dt, 13) != 0 || new_mat(&c->B, n, n, c->dt, 14) != 0) return -1;
+    c->C = m_alloc_dt(n, n, c->dt);
+    return c->C.data ? 0 : -1;
+}
+
+static int setup_packed(Case *c, double bytes) {
+    c->cfg.mm_algo = MM_PACKED;
+    return setup_mm(c, bytes);
+}
+
+static int call_mm(void *p) { Case *c = p; return mm_mt(&c->A, TR_N, &c->B, TR_N, &c->C, c->cfg); }
+
+/* Row i of C = A * B against the reference. */
+static double check_mm_row(const Mat *A, const Mat *B, const Mat *C, size_t i) {
+    double err = 0.0;
+    for (size_t j = 0; j < B->cols; j++) {
+        double s = 0.0, a = 0.0;
+        for (size_t k = 0; k < A->cols; k++) {
+            double v = m_get(A, i, k) * m_get(B, k, j);
+            s += v;
+            a += fabs(v);
+        }
+        err = worst(rel(m_get(C, i, j), s, a), err);
+    }
+    return err;
+}
+
+static double check_mm(const Case *c) {
+    double err = 0.0;
+    for (size_t s = 0; s < UB_SAMPLES; s++)
+        err = worst(check_mm_row(&c->A, &c->B, &c->C, s * (c->A.rows - 1) / (UB_SAMPLES - 1)), err);
+    return err;
+}
+
+static int setup_syrk(Case *c, double bytes) {
+    double e = (double)dt_size(c->dt);
+    size_t n = side(bytes, 1.5 * e, UB_MAXN);
+    snprintf(c->shape, sizeof(c->shape), "%zux%zu", n, n);
+    c->ws = e * ((double)n * n + (double)tri_len(n));
+    c->flops = (double)n * n * (n + 1);
+    c->bytes = c->ws;
+    if (new_mat(&c->A, n, n, c->dt, 15) != 0) return -1;
+    return tri_alloc(n, UPLO_L, c->dt, &c->T);
+}
+
+static int call_syrk(void *p) { Case *c = p; return syrk_mt(&c->A, TR_N, &c->T, c->cfg); }
+
+static double check_syrk(const Case *c) {
+    double err = 0.0;
+    size_t n = c->A.rows;
+    for (size_t s = 0; s < UB_SAMPLES; s++) {
+        size_t i = s * (n - 1) / (UB_SAMPLES - 1);
+        for (size_t j = 0; j <= i; j++) {
+            double t = 0.0, a = 0.0;
+            for (size_t k = 0; k < c->A.cols; k++) {
+                double v = m_get(&c->A, i, k) * m_get(&c->A, j, k);
+                t += v;
+                a += fabs(v);
+            }
+            err = worst(rel(tri_get(&c->T, i, j), t, a), err);
+        }
+    }
+    return err;
+}
+
+static int setup_batch(Case *c, double bytes) {
+    const size_t b = UB_BATCH_N;
+    double e = (double)dt_size(c->dt);
+    size_t count = (size_t)(bytes / (3.0 * e * b * b));
+    if (count < 1) count = 1;
+    snprintf(c->shape, sizeof(c->shape), "%zux%zu^3", count, b);
+    c->count = count;
+    c->ws = 3.0 * e * count * b * b;
+    c->flops = 2.0 * count * b * b * b;
+    c->bytes = c->ws;
+    /* Items are stacked row blocks of three tall matrices. */
+    if (new_mat(&c->A, count * b, b, c->dt, 16) != 0 || new_mat(&c->B, count * b, b, c->dt, 17) != 0) return -1;
+    c->C = m_alloc_dt(count * b, b, c->dt);
+    c->As = malloc(count * sizeof(Mat));
+    c->Bs = malloc(count * sizeof(Mat));
+    c->Cs = malloc(count * sizeof(Mat));
+    if (!c->C.data || !c->As || !c->Bs || !c->Cs) return -1;
+    for (size_t i = 0; i < count; i++) {
+        c->As[i] = m_view(&c->A, i * b, 0, b, b);
+        c->Bs[i] = m_view(&c->B, i * b, 0, b, b);
+        c->Cs[i] = m_view(&c->C, i * b, 0, b, b);
+    }
+    return 0;
+}
+
+static int call_batch(void *p) { Case *c = p; return mm_batch(c->As, c->Bs, c->Cs, c->count, c->cfg); }
+
+static double check_batch(const Case *c) {
+    double err = 0.0;
+    size_t n = c->count < UB_SAMPLES ? c->count : UB_SAMPLES;
+    for (size_t s = 0; s < n; s++) {
+        size_t it = n > 1 ? s * (c->count - 1) / (n - 1) : 0;
+        for (size_t i = 0; i < UB_BATCH_N; i++)
+            err = worst(check_mm_row(&c->As[it], &c->Bs[it], &c->Cs[it], i), err);
+    }
+    return err;
+}
+
+static const Kernel kernels[] = {
+    { "dot",       setup_dot,    call_dot,    check_dot },
+    { "axpy",      setup_axpy,   call_axpy,   check_axpy },
+    { "axdot",     setup_axdot,  call_axdot,  check_axdot },
+    { "mv",        setup_mv,     call_mv,     check_mv },
+    { "mv_t",      setup_mv,     call_mvt,    check_mvt },
+    { "gemv",      setup_mv,     call_gemv,   check_gemv },
+    { "mvdot",     setup_mv,     call_mvdot,  check_mvdot },
+    { "spmv",      setup_spmv,   call_spmv,   check_spmv },
+    { "symv",      setup_tri,    call_symv,   check_symv },
+    { "trmv",      setup_trmv,   call_trmv,   check_trmv },
+    { "mm",        setup_mm,     call_mm,     check_mm },
+    { "mm_packed", setup_packed, call_mm,     check_mm },
+    { "syrk",      setup_syrk,   call_syrk,   check_syrk },
+    { "mm_batch",  setup_batch,  call_batch,  check_batch },
+};
+#define NKERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+/* Reference agreement a kernel must reach: rounding differences only. */
+static double tolerance(DType dt) { return dt == DT_F64 ? 1e-10 : 1e-3; }
+
+static int parse_bytes(const char *s, size_t *out) {
+    char *end;
+    double v = strtod(s, &end);
+    double mul = 1.0;
+    if (*end == 'K' || *end == 'k') mul = 1024.0;
+    else if (*end == 'M' || *end == 'm') mul = 1024.0 * 1024.0;
+    else if (*end == 'G' || *end == 'g') mul = 1024.0 * 1024.0 * 1024.0;
+    else if (*end) return -1;
+    if (mul != 1.0 && end[1]) return -1;
+    if (v <= 0.0) return -1;
+    *out = (size_t)(v * mul);
+    return 0;
+}
+
+/* Working set of each level: half of L1, L2 and the (capped) LLC, and well past the LLC. */
+static void default_levels(size_t lv[LV_N]) {
+    long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE), l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    lv[LV_L1] = (l1 > 0 ? (size_t)l1 : (size_t)32 << 10) / 2;
+    lv[LV_L2] = (l2 > 0 ? (size_t)l2 : (size_t)1 << 20) / 2;
+    size_t llc = (l3 > 0 ? (size_t)l3 : (size_t)32 << 20) / 2;
+    lv[LV_LLC] = llc < UB_LLC_MAX ? llc : UB_LLC_MAX;
+    if (lv[LV_LLC] <= lv[LV_L2]) lv[LV_LLC] = 4 * lv[LV_L2];
+    lv[LV_DRAM] = 8 * lv[LV_LLC] > UB_DRAM_MIN ? 8 * lv[LV_LLC] : UB_DRAM_MIN;
+}
+
+static int in_list(const char *list, const char *name) {
+    if (!list) return 1;
+    size_t n = strlen(name);
+    for (const char *p = list; *p; ) {
+        const char *e = strchr(p, ',');
+        size_t len = e ? (size_t)(e - p) : strlen(p);
+        if (len == n && strncmp(p, name, n) == 0) return 1;
+        if (!e) break;
+        p = e + 1;
+    }
+    return 0;
+}
+
+typedef struct {
+    const char *kernels;     /* comma list, NULL = all */
+    size_t levels[LV_N];
+    int level_on[LV_N];
+    double min_time;
+    int rounds;
+    const char *dtype;
+} RunOpts;
+
+/* One measured case; across rounds it keeps the round with the best min. */
+typedef struct {
+    size_t k;
+    int l;
+    char shape[64];
+    double ws, flops, bytes, err, median, min;
+} Row;
+
+static void print_row(const Row *r, const char *dtype, int ok, FILE *out) {
+    double gflops = r->min > 0.0 ? r->flops / r->min / 1e9 : 0.0;
+    double gbs = r->min > 0.0 ? r->bytes / r->min / 1e9 : 0.0;
+    printf("%-10s %-5s %-5s %-24s %10.1f %12.9f %12.9f %9.3f %8.2f %9.2e%s\n", kernels[r->k].name, dtype,
+           lv_name[r->l], r->shape, r->ws / 1024.0, r->median, r->min, gflops, gbs, r->err, ok ? "" : "  FAIL");
+    if (out) fprintf(out, "%s %s %s %s %.0f %.9f %.9f %.4f %.3f %.3e %s\n", kernels[r->k].name, dtype,
+                     lv_name[r->l], r->shape, r->ws, r->median, r->min, gflops, gbs, r->err, ok ? "ok" : "FAIL");
+    fflush(stdout);
+}
+
+/*
+ * Runs every selected case ro->rounds times, the whole sweep once per
+ * round so a burst of load on the host spoils one sample of many cases
+ * rather than every sample of one. The reference check runs in the first
+ * round. 0, 1 if a check failed, -1 on setup errors, 2 if interrupted.
+ */
+static int run_all(const ExecCtx *ctx, const RunOpts *ro, FILE *out) {
+    char host[256] = "unknown";
+    if (gethostname(host, sizeof(host)) != 0) snprintf(host, sizeof(host), "unknown");
+    host[sizeof(host) - 1] = '\0';
+    const char *hdr = "# kernel dtype level shape ws_bytes median_s min_s gflops gbs rel_err check";
+    if (out) fprintf(out, "# ubench %d host=%s isa=%s threads=%d min_time=%g rounds=%d\n%s\n", UB_VERSION,
+                     host, simd_ops()->name, ctx->cfg.nt, ro->min_time, ro->rounds, hdr);
+    printf("[ubench] %s, %s, %d thread(s), %d round(s); levels", simd_ops()->name, ro->dtype, ctx->cfg.nt,
+           ro->rounds);
+    for (int l = 0; l < LV_N; l++)
+        if (ro->level_on[l]) printf(" %s=%.0fK", lv_name[l], (double)ro->levels[l] / 1024.0);
+    printf("\n%-10s %-5s %-5s %-24s %10s %12s %12s %9s %8s %9s\n", "kernel", "dtype", "level", "shape",
+           "ws_KiB", "median_s", "min_s", "GFLOPS", "GB/s", "rel_err");
+
+    /* The first round decides the rows; later rounds rerun them. */
+    Row rows[NKERNELS * LV_N];
+    size_t nrows = 0;
+    for (size_t k = 0; k < NKERNELS; k++) {
+        if (!in_list(ro->kernels, kernels[k].name)) continue;
+        for (int l = 0; l < LV_N; l++)
+            if (ro->level_on[l]) rows[nrows++] = (Row){ .k = k, .l = l, .min = INFINITY };
+    }
+
+    BenchOpts bo = { .warmup = BENCH_WARMUP, .reps = 0, .min_time = ro->min_time };
+    int status = 0;
+    for (int round = 0; round < ro->rounds && status != 2; round++) {
+        int last = round == ro->rounds - 1;
+        const char *prev = "";
+        for (size_t i = 0; i < nrows; i++) {
+            Row *r = &rows[i];
+            if (g_stop) { status = 2; break; }
+            if (round > 0 && !r->shape[0]) continue;     /* dropped in the first round */
+            if (i > 0 && rows[i - 1].k != r->k) prev = "";
+            const Kernel *kd = &kernels[r->k];
+            Case c = { .cfg = ctx->cfg, .dt = ctx->lo.dt };
+            if (kd->setup(&c, (double)ro->levels[r->l]) != 0) {
+                fprintf(stderr, "[ubench] %s %s: cannot allocate operands\n", kd->name, lv_name[r->l]);
+                case_free(&c);
+                r->shape[0] = '\0';
+                status = -1;
+                continue;
+            }
+            if (round == 0) {
+                /* A clamped O(n^3) case would only repeat the level below. */
+                if (strcmp(c.shape, prev) == 0) { case_free(&c); continue; }
+                memcpy(r->shape, c.shape, sizeof(r->shape));
+                r->ws = c.ws; r->flops = c.flops; r->bytes = c.bytes;
+            }
+            prev = r->shape;
+            BenchStats st = {0};
+            int rc = kd->call(&c);
+            if (round == 0) r->err = rc == 0 ? kd->check(&c) : INFINITY;
+            if (rc == 0) rc = bench_run(kd->call, NULL, &c, &bo, &st);
+            case_free(&c);
+            if (rc == 2 || g_stop) { status = 2; break; }
+            if (rc != 0) {
+                fprintf(stderr, "[ubench] %s %s: kernel failed\n", kd->name, lv_name[r->l]);
+                r->shape[0] = '\0';
+                status = -1;
+                continue;
+            }
+            if (st.min < r->min) { r->min = st.min; r->median = st.median; }
+            if (!last) continue;
+            int ok = r->err <= tolerance(ctx->lo.dt);
+            if (!ok && status == 0) status = 1;
+            print_row(r, ro->dtype, ok, out);
+        }
+        if (!last && status != 2) {
+            printf("[ubench] Round %d of %d done\n", round + 1, ro->rounds);
+            fflush(stdout);
+        }
+    }
+    if (status == 2) fprintf(stderr, "[ubench] Interrupted\n");
+    return status;
+}
+
+typedef struct {
+    char kernel[32], dtype[8], level[8], shape[64], check[8];
+    double ws, median, min, gflops, gbs, err;
+} Result;
+
+typedef struct {
+    Result *r;
+    size_t n;
+    int threads;
+    char isa[16];
+} ResultSet;
+
+static int load_results(const char *path, ResultSet *rs) {
+    memset(rs, 0, sizeof(*rs));
+    FILE *f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "[compare] Cannot open %s\n", path); return -1; }
+    char line[512];
+    size_t cap = 0;
+    int version = 0, bad = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') {
+            if (sscanf(line, "# ubench %d", &version) == 1) {
+                const char *t = strstr(line, "threads="), *i = strstr(line, "isa=");
+                if (t) rs->threads = atoi(t + 8);
+                if (i) sscanf(i + 4, "%15s", rs->isa);
+            }
+            continue;
+        }
+        if (line[0] == '\n') continue;
+        if (rs->n == cap) {
+            cap = cap ? 2 * cap : 64;
+            Result *p = realloc(rs->r, cap * sizeof(Result));
+            if (!p) { bad = 1; break; }
+            rs->r = p;
+        }
+        Result *r = &rs->r[rs->n];
+        if (sscanf(line, "%31s %7s %7s %63s %lf %lf %lf %lf %lf %lf %7s", r->kernel, r->dtype, r->level,
+                   r->shape, &r->ws, &r->median, &r->min, &r->gflops, &r->gbs, &r->err, r->check) != 11) {
+            bad = 1;
+            break;
+        }
+        rs->n++;
+    }
+    fclose(f);
+    if (version != UB_VERSION || bad) {
+        fprintf(stderr, "[compare] %s is not a version %d ubench results file\n", path, UB_VERSION);
+        free(rs->r);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Rows of new matched by kernel, dtype and level against old. A drop in
+ * GFLOPS beyond threshold percent is a regression. 0 if none and every
+ * new check passed, 1 otherwise, -1 if a file cannot be read.
+ */
+static int compare(const char *oldp, const char *newp, double threshold) {
+    ResultSet o, n;
+    if (load_results(oldp, &o) != 0) return -1;
+    if (load_results(newp, &n) != 0) { free(o.r); return -1; }
+    if (o.threads != n.threads || strcmp(o.isa, n.isa) != 0)
+        printf("[compare] Note: %s ran %s on %d thread(s), %s %s on %d\n", oldp, o.isa, o.threads,
+               newp, n.isa, n.threads);
+    printf("%-10s %-5s %-5s %12s %12s %9s\n", "kernel", "dtype", "level", "old_GFLOPS", "new_GFLOPS", "change");
+    int regress = 0, failed = 0, faster = 0, missing = 0;
+    for (size_t i = 0; i < n.n; i++) {
+        const Result *b = &n.r[i], *a = NULL;
+        for (size_t j = 0; j < o.n && !a; j++)
+            if (!strcmp(o.r[j].kernel, b->kernel) && !strcmp(o.r[j].dtype, b->dtype) &&
+                !strcmp(o.r[j].level, b->level)) a = &o.r[j];
+        int fail = strcmp(b->check, "ok") != 0;
+        failed += fail;
+        if (!a) {
+            printf("%-10s %-5s %-5s %12s %12.3f %9s%s\n", b->kernel, b->dtype, b->level, "-", b->gflops, "new",
+                   fail ? "  CHECK FAILED" : "");
+            continue;
+        }
+        double ch = a->gflops > 0.0 ? 100.0 * (b->gflops / a->gflops - 1.0) : 0.0;
+        int reg = ch < -threshold;
+        regress += reg;
+        faster += ch > threshold;
+        printf("%-10s %-5s %-5s %12.3f %12.3f %+8.1f%%%s%s%s\n", b->kernel, b->dtype, b->level, a->gflops,
+               b->gflops, ch, reg ? "  REGRESSION" : "", strcmp(a->shape, b->shape) ? "  (shape differs)" : "",
+               fail ? "  CHECK FAILED" : "");
+    }
+    for (size_t j = 0; j < o.n; j++) {
+        int found = 0;
+        for (size_t i = 0; i < n.n && !found; i++)
+            found = !strcmp(o.r[j].kernel, n.r[i].kernel) && !strcmp(o.r[j].dtype, n.r[i].dtype) &&
+                    !strcmp(o.r[j].level, n.r[i].level);
+        if (!found) missing++;
+    }
+    printf("[compare] %zu row(s): %d regression(s) and %d improvement(s) beyond %.1f%%, %d failed check(s)",
+           n.n, regress, faster, threshold, failed);
+    if (missing) printf(", %d old row(s) not rerun", missing);
+    printf("\n");
+    free(o.r);
+    free(n.r);
+    return regress || failed ? 1 : 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "Usage:\n"
+        "  %s [--threads N] [--dtype f64|f32|mixed] [--isa auto|scalar|avx2|avx512]\n"
+        "     [--kernels K1,K2,...] [--levels l1,l2,llc,dram] [--sizes L1,L2,LLC,DRAM]\n"
+        "     [--min-time S] [--rounds N] [--out FILE]\n"
+        "  %s --compare OLD NEW [--threshold PCT]\n"
+        "\n"
+        "Kernels: dot axpy axdot mv mv_t gemv mvdot spmv symv trmv mm mm_packed syrk mm_batch\n"
+        "Sizes are working-set bytes with K/M/G suffixes (default: from the cache sizes).\n"
+        "--rounds repeats the sweep and keeps each case's best round (default: 1).\n"
+        "--compare exits 1 if a kernel lost more than PCT%% GFLOPS (default: %.0f) or failed its check.\n",
+        argv0, argv0, UB_THRESHOLD);
+}
+
+int main(int argc, char **argv) {
+    signal(SIGINT, on_sigint);
+
+    CtxOpts co;
+    ctx_opts_init(&co);
+    co.profile = "none";    /* fixed settings, so two builds time the same thing */
+    RunOpts ro = { .min_time = 0.1, .rounds = 1, .dtype = "f64" };
+    default_levels(ro.levels);
+    for (int l = 0; l < LV_N; l++) ro.level_on[l] = 1;
+    const char *out_path = NULL, *cmp_old = NULL;
+    double threshold = UB_THRESHOLD;
+
+    static struct option longopts[] = {
+        {"threads", required_argument, 0, 't'},
+        {"dtype", required_argument, 0, 'D'},
+        {"isa", required_argument, 0, 'I'},
+        {"kernels", required_argument, 0, 'k'},
+        {"levels", required_argument, 0, 'l'},
+        {"sizes", required_argument, 0, 's'},
+        {"min-time", required_argument, 0, 'm'},
+        {"rounds", required_argument, 0, 'r'},
+        {"out", required_argument, 0, 'O'},
+        {"compare", required_argument, 0, 'c'},
+        {"threshold", required_argument, 0, 'T'},
+        {"help", no_argument, 0, 'h'},
+        {0,0,0,0}
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "t:D:I:k:l:s:m:r:O:c:T:h", longopts, NULL)) != -1) {
+        switch (c) {
+            case 't': co.nt = atoi(optarg); break;
+            case 'D':
+                ro.dtype = optarg;
+                if (strcmp(optarg, "f64") == 0) { co.dt = DT_F64; co.cfg.acc = ACC_NATIVE; }
+                else if (strcmp(optarg, "f32") == 0) { co.dt = DT_F32; co.cfg.acc = ACC_NATIVE; }
+                else if (strcmp(optarg, "mixed") == 0) { co.dt = DT_F32; co.cfg.acc = ACC_F64; }
+                else { usage(argv[0]); return 1; }
+                break;
+            case 'I':
+                if (simd_select(optarg) != 0) {
+                    fprintf(stderr, "ISA '%s' is not supported on this CPU\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'k': ro.kernels = optarg; break;
+            case 'l':
+                for (int l = 0; l < LV_N; l++) ro.level_on[l] = in_list(optarg, lv_name[l]);
+                break;
+            case 's': {
+                char buf[256];
+                snprintf(buf, sizeof(buf), "%s", optarg);
+                char *save = NULL, *t = strtok_r(buf, ",", &save);
+                for (int l = 0; l < LV_N; l++, t = strtok_r(NULL, ",", &save))
+                    if (!t || parse_bytes(t, &ro.levels[l]) != 0) { usage(argv[0]); return 1; }
+                break;
+            }
+            case 'm': ro.min_time = strtod(optarg, NULL); break;
+            case 'r': ro.rounds = atoi(optarg); break;
+            case 'O': out_path = optarg; break;
+            case 'c': cmp_old = optarg; break;
+            case 'T': threshold = strtod(optarg, NULL); break;
+            case 'h': usage(argv[0]); return 0;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (cmp_old) {
+        if (optind != argc - 1 || threshold < 0.0) { usage(argv[0]); return 1; }
+        return compare(cmp_old, argv[optind], threshold) == 0 ? 0 : 1;
+    }
+    if (optind != argc || co.nt <= 0 || ro.min_time <= 0.0 || ro.rounds <= 0) { usage(argv[0]); return 1; }
+    co.fixed = TUNE_FIX_TILE | TUNE_FIX_ALGO | TUNE_FIX_THREADS;
+
+    ExecCtx ctx;
+    if (ctx_init(&ctx, &co) != 0) {
+        fprintf(stderr, "Failed to start %d worker threads\n", co.nt);
+        return 1;
+    }
+    FILE *out = NULL;
+    if (out_path && !(out = fopen(out_path, "w"))) {
+        fprintf(stderr, "[ubench] Cannot write %s\n", out_path);
+        ctx_free(&ctx);
+        return 1;
+    }
+    int status = run_all(&ctx, &ro, out);
+    if (out && fclose(out) != 0) status = -1;
+    if (out) printf("[ubench] Results in %s\n", out_path);
+    ctx_free(&ctx);
+    return status == 0 ? 0 : status == 2 ? 2 : 1;
+}